@@ -14,21 +14,26 @@ function Run-Test {
 }
 
 Run-Test -TestName "annotated-commit"
+Run-Test -TestName "apply"
 Run-Test -TestName "blame"
 Run-Test -TestName "blob"
 Run-Test -TestName "branch"
 Run-Test -TestName "checkout"
 Run-Test -TestName "cherrypick"
 Run-Test -TestName "commit"
+Run-Test -TestName "commit-graph"
 Run-Test -TestName "config"
 Run-Test -TestName "describe"
 Run-Test -TestName "diff"
 Run-Test -TestName "graph"
 Run-Test -TestName "ignore"
 Run-Test -TestName "index"
+Run-Test -TestName "log"
 Run-Test -TestName "merge"
 Run-Test -TestName "message"
+Run-Test -TestName "odb"
 Run-Test -TestName "pathspec"
+Run-Test -TestName "pickaxe"
 Run-Test -TestName "refcount"
 Run-Test -TestName "reference"
 Run-Test -TestName "reflog"
@@ -0,0 +1,308 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "git2.h"
+
+#include "egit.h"
+#include "interface.h"
+#include "egit-apply.h"
+
+
+// =============================================================================
+// Helpers - checking
+
+typedef struct {
+    const char *ptr;
+    size_t len;
+} apply_line;
+
+/**
+ * Split a buffer into lines, not including the terminating newlines.
+ * The lines point into the buffer, which must outlive them.
+ */
+static size_t apply_split_lines(apply_line **out, const char *buf, size_t len)
+{
+    size_t nlines = 0, alloc = 64;
+    apply_line *lines = (apply_line*) malloc(alloc * sizeof(apply_line));
+
+    const char *end = buf + len;
+    while (buf < end) {
+        const char *nl = memchr(buf, '\n', end - buf);
+        const char *eol = nl ? nl : end;
+        if (nlines == alloc) {
+            alloc *= 2;
+            lines = (apply_line*) realloc(lines, alloc * sizeof(apply_line));
+        }
+        lines[nlines++] = (apply_line) {buf, eol - buf};
+        buf = nl ? nl + 1 : end;
+    }
+
+    *out = lines;
+    return nlines;
+}
+
+/**
+ * Read the preimage of PATH from INDEX, or from the working directory if INDEX is NULL.
+ * Sets *exists to false if there is no such file. The returned buffer must be freed.
+ */
+static int apply_read_preimage(
+    char **out, size_t *len, bool *exists,
+    git_repository *repo, git_index *index, const char *path)
+{
+    *out = NULL;
+    *len = 0;
+    *exists = false;
+
+    if (index) {
+        const git_index_entry *entry = git_index_get_bypath(index, path, 0);
+        if (!entry)
+            return 0;
+
+        git_blob *blob;
+        int retval = git_blob_lookup(&blob, repo, &entry->id);
+        if (retval < 0)
+            return retval;
+
+        *len = git_blob_rawsize(blob);
+        *out = (char*) malloc(*len + 1);
+        memcpy(*out, git_blob_rawcontent(blob), *len);
+        git_blob_free(blob);
+        *exists = true;
+        return 0;
+    }
+
+    const char *workdir = git_repository_workdir(repo);
+    if (!workdir) {
+        giterr_set_str(GITERR_INVALID, "Cannot apply to the working directory of a bare repository");
+        return -1;
+    }
+
+    size_t fullpath_len = strlen(workdir) + strlen(path) + 1;
+    char *fullpath = (char*) malloc(fullpath_len);
+    snprintf(fullpath, fullpath_len, "%s%s", workdir, path);
+    FILE *file = fopen(fullpath, "rb");
+    free(fullpath);
+    if (!file)
+        return 0;
+
+    size_t alloc = 4096;
+    *out = (char*) malloc(alloc);
+    size_t nread;
+    while ((nread = fread(*out + *len, 1, alloc - *len, file)) > 0) {
+        *len += nread;
+        if (*len == alloc) {
+            alloc *= 2;
+            *out = (char*) realloc(*out, alloc);
+        }
+    }
+    fclose(file);
+
+    *exists = true;
+    return 0;
+}
+
+static bool apply_line_eq(const apply_line *pre, const git_diff_line *line)
+{
+    size_t len = line->content_len;
+    if (len > 0 && line->content[len-1] == '\n')
+        len--;
+    return pre->len == len && memcmp(pre->ptr, line->content, len) == 0;
+}
+
+/**
+ * Return true if the old side of hunk number IDX in PATCH can be found in PRE.
+ * Like git apply, we first try the position given in the hunk header, then
+ * search for the closest offset where the hunk matches.
+ */
+static int apply_hunk_matches(bool *out, git_patch *patch, size_t idx, apply_line *pre, size_t npre)
+{
+    const git_diff_hunk *hunk;
+    size_t nlines;
+    int retval = git_patch_get_hunk(&hunk, &nlines, patch, idx);
+    if (retval < 0)
+        return retval;
+
+    // Collect the lines on the old side
+    const git_diff_line **old = (const git_diff_line**) malloc((nlines + 1) * sizeof(git_diff_line*));
+    size_t nold = 0;
+    for (size_t i = 0; i < nlines; i++) {
+        const git_diff_line *line;
+        retval = git_patch_get_line_in_hunk(&line, patch, idx, i);
+        if (retval < 0) {
+            free(old);
+            return retval;
+        }
+        if (line->origin == GIT_DIFF_LINE_CONTEXT || line->origin == GIT_DIFF_LINE_DELETION)
+            old[nold++] = line;
+    }
+
+    *out = false;
+    if (nold <= npre) {
+        ptrdiff_t start = hunk->old_lines == 0 ? hunk->old_start : hunk->old_start - 1;
+        ptrdiff_t last = npre - nold;
+        if (start < 0) start = 0;
+        if (start > last) start = last;
+
+        for (ptrdiff_t offset = 0; !*out && (start - offset >= 0 || start + offset <= last); offset++) {
+            for (int sign = 0; sign < 2 && !*out; sign++) {
+                ptrdiff_t pos = sign ? start - offset : start + offset;
+                if (pos < 0 || pos > last || (sign && offset == 0))
+                    continue;
+                size_t i = 0;
+                while (i < nold && apply_line_eq(&pre[pos + i], old[i]))
+                    i++;
+                *out = (i == nold);
+            }
+        }
+    }
+
+    free(old);
+    return 0;
+}
+
+typedef struct {
+    char *buf;
+    apply_line *lines;
+    size_t nlines;
+    bool exists;
+} apply_preimage;
+
+static int apply_preimage_load(
+    apply_preimage *pre, git_repository *repo, git_index *index, const char *path)
+{
+    size_t len;
+    pre->lines = NULL;
+    pre->nlines = 0;
+    int retval = apply_read_preimage(&pre->buf, &len, &pre->exists, repo, index, path);
+    if (retval < 0)
+        return retval;
+    if (pre->exists)
+        pre->nlines = apply_split_lines(&pre->lines, pre->buf, len);
+    return 0;
+}
+
+static void apply_preimage_dispose(apply_preimage *pre)
+{
+    free(pre->buf);
+    free(pre->lines);
+}
+
+/**
+ * Check every hunk of PATCH against the preimages in the index and/or the working
+ * directory, and cons a conflict record onto *conflicts if any of them fails to apply.
+ */
+static int apply_check_patch(
+    emacs_env *env, emacs_value *conflicts, git_repository *repo,
+    git_patch *patch, git_index *index, bool workdir)
+{
+    const git_diff_delta *delta = git_patch_get_delta(patch);
+    bool added = delta->status == GIT_DELTA_ADDED;
+    const char *path = added ? delta->new_file.path : delta->old_file.path;
+
+    apply_preimage pres[2];
+    size_t npres = 0;
+    int retval = 0;
+
+    if (index) {
+        retval = apply_preimage_load(&pres[npres], repo, index, path);
+        if (retval < 0)
+            return retval;
+        npres++;
+    }
+    if (workdir) {
+        retval = apply_preimage_load(&pres[npres], repo, NULL, path);
+        if (retval < 0)
+            goto cleanup;
+        npres++;
+    }
+
+    bool file_conflict = false;
+    for (size_t p = 0; p < npres; p++)
+        file_conflict |= (added == pres[p].exists);
+
+    emacs_value failed = esym_nil;
+    if (!file_conflict) {
+        for (size_t i = git_patch_num_hunks(patch); i > 0; i--) {
+            bool ok = true;
+            for (size_t p = 0; ok && p < npres; p++) {
+                retval = apply_hunk_matches(&ok, patch, i - 1, pres[p].lines, pres[p].nlines);
+                if (retval < 0)
+                    goto cleanup;
+            }
+            if (!ok)
+                failed = em_cons(env, EM_INTEGER(i - 1), failed);
+        }
+    }
+
+    if (file_conflict || EM_EXTRACT_BOOLEAN(failed))
+        *conflicts = em_cons(env, em_cons(env, EM_STRING(path), failed), *conflicts);
+
+  cleanup:
+    for (size_t p = 0; p < npres; p++)
+        apply_preimage_dispose(&pres[p]);
+    return retval;
+}
+
+static int apply_check(
+    emacs_env *env, emacs_value *conflicts, git_repository *repo,
+    git_diff *diff, git_index *index, bool workdir)
+{
+    for (size_t i = git_diff_num_deltas(diff); i > 0; i--) {
+        git_patch *patch;
+        int retval = git_patch_from_diff(&patch, diff, i - 1);
+        if (retval < 0)
+            return retval;
+        retval = apply_check_patch(env, conflicts, repo, patch, index, workdir);
+        git_patch_free(patch);
+        if (retval < 0)
+            return retval;
+    }
+    return 0;
+}
+
+
+// =============================================================================
+// Apply
+
+EGIT_DOC(apply, "REPO DIFF &optional LOCATION CHECK",
+         "Apply DIFF to REPO at LOCATION.\n"
+         "LOCATION is one of the symbols `workdir' (default), `index' or `both'.\n"
+         "With `both', the working directory and the index are updated together,\n"
+         "like `git apply --index'.\n\n"
+         "If CHECK is non-nil, nothing is modified. Instead, return a list of\n"
+         "conflicts, each of the form (PATH HUNK-INDEX...), where the indices\n"
+         "are zero-based and refer to the hunks of that file in DIFF that do\n"
+         "not apply. An empty hunk list means that the file itself is missing,\n"
+         "or already exists for an addition. Return nil if DIFF applies cleanly.");
+emacs_value egit_apply(emacs_env *env, emacs_value _repo, emacs_value _diff,
+                       emacs_value _location, emacs_value check)
+{
+    EGIT_ASSERT_REPOSITORY(_repo);
+    EGIT_ASSERT_DIFF(_diff);
+
+    git_apply_location_t location;
+    if (!em_findsym_apply_location(&location, env, _location, true))
+        return esym_nil;
+
+    git_repository *repo = EGIT_EXTRACT(_repo);
+    git_diff *diff = EGIT_EXTRACT(_diff);
+
+    if (!EM_EXTRACT_BOOLEAN(check)) {
+        int retval = git_apply(repo, diff, location, NULL);
+        EGIT_CHECK_ERROR(retval);
+        return esym_nil;
+    }
+
+    git_index *index = NULL;
+    if (location != GIT_APPLY_LOCATION_WORKDIR) {
+        int retval = git_repository_index(&index, repo);
+        EGIT_CHECK_ERROR(retval);
+    }
+
+    emacs_value conflicts = esym_nil;
+    int retval = apply_check(env, &conflicts, repo, diff, index,
+                             location != GIT_APPLY_LOCATION_INDEX);
+    git_index_free(index);
+    EGIT_CHECK_ERROR(retval);
+    return conflicts;
+}
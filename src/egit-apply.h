@@ -0,0 +1,8 @@
+#include "egit.h"
+
+#ifndef EGIT_APPLY_H
+#define EGIT_APPLY_H
+
+EGIT_DEFUN(apply, emacs_value _repo, emacs_value _diff, emacs_value _location, emacs_value check);
+
+#endif /* EGIT_APPLY_H */
@@ -1,9 +1,25 @@
+#include <ctype.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <sys/utime.h>
+#else
+#include <sys/mman.h>
+#include <utime.h>
+#endif
 
 #include "git2.h"
 
 #include "egit.h"
 #include "interface.h"
+#include "egit-blame.h"
 
 
 static emacs_value extract_options(emacs_env *env, emacs_value eopts, git_blame_options *opts)
@@ -90,6 +106,33 @@ emacs_value egit_blame_file(emacs_env *env, emacs_value _repo, emacs_value _path
     return egit_wrap(env, EGIT_BLAME, blame, NULL);
 }
 
+EGIT_DOC(blame_buffer, "BLAME CONTENTS",
+         "Return a blame for CONTENTS, an edited version of the file of BLAME.\n"
+         "BLAME is the blame of the committed file, and CONTENTS a string with\n"
+         "the current text, e.g. of a buffer being edited. The new blame is\n"
+         "computed by diffing CONTENTS against the committed file, without\n"
+         "walking the history. Unchanged lines keep their hunks, shifted as\n"
+         "needed, and added or changed lines are in hunks whose commit ID is\n"
+         "all zeros, meaning uncommitted.");
+emacs_value egit_blame_buffer(emacs_env *env, emacs_value _blame, emacs_value _contents)
+{
+    EGIT_ASSERT_BLAME(_blame);
+    EM_ASSERT_STRING(_contents);
+
+    git_blame *reference = EGIT_EXTRACT(_blame);
+
+    ptrdiff_t size;
+    char *contents = em_get_string_with_size(env, _contents, &size);
+
+    git_blame *blame = NULL;
+    int retval = git_blame_buffer(&blame, reference, contents, size);
+    free(contents);
+    EGIT_CHECK_ERROR(retval);
+
+    // The new blame shares the repository of the reference, so keep it alive
+    return egit_wrap(env, EGIT_BLAME, blame, EM_EXTRACT_USER_PTR(_blame));
+}
+
 EGIT_DOC(blame_get_hunk_byindex, "BLAME N", "Return the Nth hunk of BLAME.");
 emacs_value egit_blame_get_hunk_byindex(emacs_env *env, emacs_value _blame, emacs_value _index)
 {
@@ -175,12 +218,15 @@ emacs_value egit_blame_hunk_orig_path(emacs_env *env, emacs_value _hunk)
 EGIT_DOC(blame_hunk_signature, "BLAME-HUNK &optional ORIG",
          "Get the author of the change represented by BLAME-HUNK.\n"
          "If ORIG is non-nil, instead get the author of the commit named by\n"
-         "(libgit-blame-hunk-commit-id BLAME-HUNK t).");
+         "(libgit-blame-hunk-commit-id BLAME-HUNK t).\n"
+         "Return nil for uncommitted lines, see `libgit-blame-buffer'.");
 emacs_value egit_blame_hunk_signature(emacs_env *env, emacs_value _hunk, emacs_value orig)
 {
     EGIT_ASSERT_BLAME_HUNK(_hunk);
     git_blame_hunk *hunk = EGIT_EXTRACT(_hunk);
     git_signature *sig = EM_EXTRACT_BOOLEAN(orig) ? hunk->final_signature : hunk->orig_signature;
+    if (!sig)
+        return esym_nil;
     git_signature *ret;
     int retval = git_signature_dup(&ret, sig);
     EGIT_CHECK_ERROR(retval);
@@ -200,3 +246,916 @@ emacs_value egit_blame_hunk_start_line_number(emacs_env *env, emacs_value _hunk,
         EM_EXTRACT_BOOLEAN(orig) ? hunk->final_start_line_number : hunk->orig_start_line_number
     );
 }
+
+
+// =============================================================================
+// Hunk records
+
+/**
+ * A flat copy of the fields of a blame hunk that Lisp cares about.
+ * The strings are borrowed unless stated otherwise.
+ */
+typedef struct {
+    git_oid final_id, orig_id;
+    size_t final_start, orig_start, lines;
+    const char *path, *name, *email;
+    git_time_t time;
+} blame_record;
+
+static void blame_record_init(blame_record *rec, const git_blame_hunk *hunk)
+{
+    const git_signature *sig = hunk->final_signature;
+    git_oid_cpy(&rec->final_id, &hunk->final_commit_id);
+    git_oid_cpy(&rec->orig_id, &hunk->orig_commit_id);
+    rec->final_start = hunk->final_start_line_number;
+    rec->orig_start = hunk->orig_start_line_number;
+    rec->lines = hunk->lines_in_hunk;
+    rec->path = hunk->orig_path;
+    rec->name = sig ? sig->name : NULL;
+    rec->email = sig ? sig->email : NULL;
+    rec->time = sig ? sig->when.time : 0;
+}
+
+/**
+ * A table of Lisp strings, so that strings repeated across records (commit
+ * IDs, paths and authors) are only converted once and shared.
+ */
+typedef struct {
+    char **keys;
+    emacs_value *values;
+    size_t size, count;
+} blame_strings;
+
+static void blame_strings_init(blame_strings *table)
+{
+    table->size = 64;
+    table->count = 0;
+    table->keys = (char**) calloc(table->size, sizeof(char*));
+    table->values = (emacs_value*) malloc(table->size * sizeof(emacs_value));
+}
+
+static void blame_strings_dispose(blame_strings *table)
+{
+    for (size_t i = 0; i < table->size; i++)
+        free(table->keys[i]);
+    free(table->keys);
+    free(table->values);
+}
+
+static size_t blame_strings_hash(const char *str)
+{
+    size_t hash = 2166136261u;
+    for (; *str; str++)
+        hash = (hash ^ (unsigned char) *str) * 16777619u;
+    return hash;
+}
+
+static size_t blame_strings_slot(blame_strings *table, const char *str)
+{
+    size_t mask = table->size - 1, i = blame_strings_hash(str) & mask;
+    while (table->keys[i] && strcmp(table->keys[i], str))
+        i = (i + 1) & mask;
+    return i;
+}
+
+static void blame_strings_grow(blame_strings *table)
+{
+    blame_strings old = *table;
+    table->size *= 2;
+    table->keys = (char**) calloc(table->size, sizeof(char*));
+    table->values = (emacs_value*) malloc(table->size * sizeof(emacs_value));
+
+    for (size_t i = 0; i < old.size; i++) {
+        if (!old.keys[i])
+            continue;
+        size_t slot = blame_strings_slot(table, old.keys[i]);
+        table->keys[slot] = old.keys[i];
+        table->values[slot] = old.values[i];
+    }
+    free(old.keys);
+    free(old.values);
+}
+
+static emacs_value blame_strings_get(emacs_env *env, blame_strings *table, const char *str)
+{
+    if (!str)
+        return esym_nil;
+
+    if (2 * (table->count + 1) > table->size)
+        blame_strings_grow(table);
+
+    size_t slot = blame_strings_slot(table, str);
+    if (!table->keys[slot]) {
+        table->keys[slot] = strdup(str);
+        table->values[slot] = EM_STRING(str);
+        table->count++;
+    }
+    return table->values[slot];
+}
+
+/**
+ * Convert a record to a vector
+ * [FINAL-ID ORIG-ID FINAL-START ORIG-START LINES ORIG-PATH NAME EMAIL TIME].
+ */
+static emacs_value blame_record_value(
+    emacs_env *env, const blame_record *rec, blame_strings *strings)
+{
+    emacs_value fields[9];
+    fields[0] = blame_strings_get(env, strings, git_oid_tostr_s(&rec->final_id));
+    fields[1] = blame_strings_get(env, strings, git_oid_tostr_s(&rec->orig_id));
+    fields[2] = EM_INTEGER(rec->final_start);
+    fields[3] = EM_INTEGER(rec->orig_start);
+    fields[4] = EM_INTEGER(rec->lines);
+    fields[5] = blame_strings_get(env, strings, rec->path);
+    fields[6] = blame_strings_get(env, strings, rec->name);
+    fields[7] = blame_strings_get(env, strings, rec->email);
+    fields[8] = EM_INTEGER(rec->time);
+    return em_vector(env, fields, 9);
+}
+
+static emacs_value blame_records_value(emacs_env *env, const blame_record *recs, size_t count)
+{
+    emacs_value *hunks = (emacs_value*) malloc((count ? count : 1) * sizeof(emacs_value));
+
+    blame_strings strings;
+    blame_strings_init(&strings);
+    for (size_t i = 0; i < count; i++)
+        hunks[i] = blame_record_value(env, &recs[i], &strings);
+    blame_strings_dispose(&strings);
+
+    emacs_value ret = em_vector(env, hunks, count);
+    free(hunks);
+    return ret;
+}
+
+static emacs_value blame_hunks_value(emacs_env *env, git_blame *blame)
+{
+    uint32_t count = git_blame_get_hunk_count(blame);
+    blame_record *recs = (blame_record*) malloc((count ? count : 1) * sizeof(blame_record));
+    for (uint32_t i = 0; i < count; i++)
+        blame_record_init(&recs[i], git_blame_get_hunk_byindex(blame, i));
+
+    emacs_value ret = blame_records_value(env, recs, count);
+    free(recs);
+    return ret;
+}
+
+EGIT_DOC(blame_hunks, "BLAME",
+         "Return all hunks of BLAME as a vector of records.\n"
+         "Each record is a vector\n"
+         "  [FINAL-ID ORIG-ID FINAL-START ORIG-START LINES ORIG-PATH NAME EMAIL TIME]\n"
+         "where NAME, EMAIL and TIME (in seconds since the epoch) describe the\n"
+         "author of FINAL-ID. Equal strings are shared between records.");
+emacs_value egit_blame_hunks(emacs_env *env, emacs_value _blame)
+{
+    EGIT_ASSERT_BLAME(_blame);
+    git_blame *blame = EGIT_EXTRACT(_blame);
+    return blame_hunks_value(env, blame);
+}
+
+
+// =============================================================================
+// Incremental blame
+
+/**
+ * Number of lines blamed at once when no visible range is given.
+ * Further chunks double in size, so the history is walked a logarithmic number of times.
+ */
+#define BLAME_JOB_CHUNK 256
+
+/**
+ * Largest chunk, since a job is only cancelled between chunks. Past this size,
+ * the history is walked once more per chunk instead.
+ */
+#define BLAME_JOB_CHUNK_MAX 4096
+
+struct egit_blame_job {
+    pthread_mutex_t lock;
+    int refcount;               /**< One for the Lisp wrapper, one for the thread. */
+    bool cancelled, finished;
+
+    char *repo_path, *path;
+    git_blame_options opts;
+
+    blame_record *records;      /**< Records not yet polled, owning their strings. */
+    size_t nrecords, alloc;
+
+    int error;
+    int error_class;
+    char *error_message;
+};
+
+static void blame_job_clear_records(egit_blame_job *job)
+{
+    for (size_t i = 0; i < job->nrecords; i++) {
+        free((char*) job->records[i].path);
+        free((char*) job->records[i].name);
+        free((char*) job->records[i].email);
+    }
+    job->nrecords = 0;
+}
+
+static void blame_job_unref(egit_blame_job *job)
+{
+    pthread_mutex_lock(&job->lock);
+    int refcount = --job->refcount;
+    pthread_mutex_unlock(&job->lock);
+    if (refcount > 0)
+        return;
+
+    blame_job_clear_records(job);
+    free(job->records);
+    free(job->error_message);
+    free(job->repo_path);
+    free(job->path);
+    pthread_mutex_destroy(&job->lock);
+    free(job);
+}
+
+void egit_blame_job_free(egit_blame_job *job)
+{
+    pthread_mutex_lock(&job->lock);
+    job->cancelled = true;
+    pthread_mutex_unlock(&job->lock);
+    blame_job_unref(job);
+}
+
+static bool blame_job_cancelled(egit_blame_job *job)
+{
+    pthread_mutex_lock(&job->lock);
+    bool cancelled = job->cancelled;
+    pthread_mutex_unlock(&job->lock);
+    return cancelled;
+}
+
+static char *blame_strdup(const char *str)
+{
+    return str ? strdup(str) : NULL;
+}
+
+static void blame_job_publish(egit_blame_job *job, git_blame *blame)
+{
+    uint32_t count = git_blame_get_hunk_count(blame);
+
+    pthread_mutex_lock(&job->lock);
+    if (job->nrecords + count > job->alloc) {
+        job->alloc = job->nrecords + count + job->alloc;
+        job->records = (blame_record*) realloc(job->records, job->alloc * sizeof(blame_record));
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        blame_record *rec = &job->records[job->nrecords++];
+        blame_record_init(rec, git_blame_get_hunk_byindex(blame, i));
+        rec->path = blame_strdup(rec->path);
+        rec->name = blame_strdup(rec->name);
+        rec->email = blame_strdup(rec->email);
+    }
+    pthread_mutex_unlock(&job->lock);
+}
+
+/**
+ * Count the lines of the blamed file, the same way libgit2 does.
+ */
+static int blame_job_count_lines(size_t *out, git_repository *repo, egit_blame_job *job)
+{
+    git_oid oid;
+    int retval = 0;
+    if (git_oid_iszero(&job->opts.newest_commit))
+        retval = git_reference_name_to_id(&oid, repo, "HEAD");
+    else
+        git_oid_cpy(&oid, &job->opts.newest_commit);
+    if (retval < 0)
+        return retval;
+
+    git_commit *commit;
+    retval = git_commit_lookup(&commit, repo, &oid);
+    if (retval < 0)
+        return retval;
+
+    git_object *blob;
+    retval = git_object_lookup_bypath(&blob, (git_object*) commit, job->path, GIT_OBJ_BLOB);
+    git_commit_free(commit);
+    if (retval < 0)
+        return retval;
+
+    const char *buf = (const char*) git_blob_rawcontent((git_blob*) blob);
+    size_t len = git_blob_rawsize((git_blob*) blob), lines = 0;
+    for (size_t i = 0; i < len; i++)
+        lines += buf[i] == '\n';
+    if (len > 0 && buf[len - 1] != '\n')
+        lines++;
+
+    git_object_free(blob);
+    *out = lines;
+    return 0;
+}
+
+static int blame_job_range(git_repository *repo, egit_blame_job *job, size_t lo, size_t hi)
+{
+    if (blame_job_cancelled(job))
+        return GIT_EUSER;
+
+    git_blame_options opts = job->opts;
+    opts.min_line = lo;
+    opts.max_line = hi;
+
+    git_blame *blame;
+    int retval = git_blame_file(&blame, repo, job->path, &opts);
+    if (retval < 0)
+        return retval;
+
+    blame_job_publish(job, blame);
+    git_blame_free(blame);
+    return 0;
+}
+
+/**
+ * Blame the visible range first, then ranges of doubling size, up to
+ * BLAME_JOB_CHUNK_MAX lines, alternately below and above what has been
+ * blamed so far.
+ */
+static int blame_job_blame(git_repository *repo, egit_blame_job *job)
+{
+    size_t nlines;
+    int retval = blame_job_count_lines(&nlines, repo, job);
+    if (retval < 0 || nlines == 0)
+        return retval;
+
+    size_t lo = job->opts.min_line ? job->opts.min_line : 1;
+    if (lo > nlines)
+        lo = nlines;
+    size_t hi = job->opts.max_line ? job->opts.max_line : lo + BLAME_JOB_CHUNK - 1;
+    if (hi < lo)
+        hi = lo;
+    if (hi > nlines)
+        hi = nlines;
+
+    retval = blame_job_range(repo, job, lo, hi);
+    size_t size = hi - lo + 1 < BLAME_JOB_CHUNK ? BLAME_JOB_CHUNK : hi - lo + 1;
+    if (size > BLAME_JOB_CHUNK_MAX)
+        size = BLAME_JOB_CHUNK_MAX;
+
+    while (retval == 0 && (hi < nlines || lo > 1)) {
+        if (hi < nlines) {
+            size_t start = hi + 1;
+            hi = nlines - hi > size ? hi + size : nlines;
+            retval = blame_job_range(repo, job, start, hi);
+        }
+        if (retval == 0 && lo > 1) {
+            size_t end = lo - 1;
+            lo = lo > size ? lo - size : 1;
+            retval = blame_job_range(repo, job, lo, end);
+        }
+        size = 2 * size < BLAME_JOB_CHUNK_MAX ? 2 * size : BLAME_JOB_CHUNK_MAX;
+    }
+
+    return retval;
+}
+
+static void *blame_job_run(void *arg)
+{
+    egit_blame_job *job = (egit_blame_job*) arg;
+
+    git_repository *repo = NULL;
+    int retval = git_repository_open(&repo, job->repo_path);
+    if (retval == 0)
+        retval = blame_job_blame(repo, job);
+
+    pthread_mutex_lock(&job->lock);
+    if (retval < 0 && retval != GIT_EUSER) {
+        const git_error *err = giterr_last();
+        job->error = retval;
+        job->error_class = err ? err->klass : GITERR_NONE;
+        job->error_message = err && err->message ? strdup(err->message) : NULL;
+    }
+    job->finished = true;
+    pthread_mutex_unlock(&job->lock);
+
+    git_repository_free(repo);
+    blame_job_unref(job);
+    return NULL;
+}
+
+EGIT_DOC(blame_file_incremental, "REPOSITORY PATH &optional OPTIONS",
+         "Start blaming the file PATH in the background and return a blame job.\n"
+         "OPTIONS is as for `libgit-blame-file', but the whole file is always\n"
+         "blamed. The lines from `min-line' to `max-line' are done first,\n"
+         "so they should be the lines currently visible. The rest of the file\n"
+         "follows in chunks of growing size, nearest lines first.\n\n"
+         "Use `libgit-blame-job-poll' to collect the hunks as they are\n"
+         "found, and `libgit-blame-job-cancel' to stop the job, for example\n"
+         "when the buffer is killed. Since each chunk is blamed separately,\n"
+         "a hunk spanning chunk boundaries is reported in pieces.");
+emacs_value egit_blame_file_incremental(
+    emacs_env *env, emacs_value _repo, emacs_value _path, emacs_value options)
+{
+    EGIT_ASSERT_REPOSITORY(_repo);
+    EM_ASSERT_STRING(_path);
+
+    git_repository *repo = EGIT_EXTRACT(_repo);
+    const char *repo_path = git_repository_path(repo);
+
+    git_blame_options opts;
+    extract_options(env, options, &opts);
+    EM_RETURN_NIL_IF_NLE();
+
+    egit_blame_job *job = (egit_blame_job*) calloc(1, sizeof(egit_blame_job));
+    pthread_mutex_init(&job->lock, NULL);
+    job->refcount = 2;
+    job->repo_path = strdup(repo_path);
+    job->path = EM_EXTRACT_STRING(_path);
+    job->opts = opts;
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, blame_job_run, job) != 0) {
+        job->refcount = 1;
+        egit_blame_job_free(job);
+        em_signal(env, esym_giterr, "Unable to start blame thread");
+        return esym_nil;
+    }
+    pthread_detach(thread);
+
+    return egit_wrap(env, EGIT_BLAME_JOB, job, NULL);
+}
+
+EGIT_DOC(blame_job_poll, "JOB",
+         "Return the hunks found by the blame JOB since the last call.\n"
+         "Each hunk is a record as returned by `libgit-blame-hunks'. The\n"
+         "hunks of each chunk are in line order.\n"
+         "If the job failed, signal its error once all hunks have been returned.");
+emacs_value egit_blame_job_poll(emacs_env *env, emacs_value _job)
+{
+    EGIT_ASSERT_BLAME_JOB(_job);
+    egit_blame_job *job = EGIT_EXTRACT(_job);
+
+    blame_strings strings;
+    blame_strings_init(&strings);
+
+    pthread_mutex_lock(&job->lock);
+    emacs_value ret = esym_nil;
+    for (size_t i = job->nrecords; i > 0; i--)
+        ret = em_cons(env, blame_record_value(env, &job->records[i - 1], &strings), ret);
+    blame_job_clear_records(job);
+
+    int retval = 0;
+    if (EM_EQ(ret, esym_nil) && job->error < 0) {
+        retval = job->error;
+        job->error = 0;
+        giterr_set_str(job->error_class, job->error_message ? job->error_message : "unknown error");
+    }
+    pthread_mutex_unlock(&job->lock);
+    blame_strings_dispose(&strings);
+
+    EGIT_CHECK_ERROR(retval);
+    return ret;
+}
+
+EGIT_DOC(blame_job_done_p, "JOB",
+         "Return non-nil if the blame JOB has stopped, because it finished or\n"
+         "was cancelled, and all its hunks and errors have been returned by\n"
+         "`libgit-blame-job-poll'.");
+emacs_value egit_blame_job_done_p(emacs_env *env, emacs_value _job)
+{
+    EGIT_ASSERT_BLAME_JOB(_job);
+    egit_blame_job *job = EGIT_EXTRACT(_job);
+
+    pthread_mutex_lock(&job->lock);
+    bool done = job->finished && job->nrecords == 0 && job->error == 0;
+    pthread_mutex_unlock(&job->lock);
+    return done ? esym_t : esym_nil;
+}
+
+EGIT_DOC(blame_job_cancel, "JOB",
+         "Cancel the blame JOB.\n"
+         "No more hunks are found after the chunk currently being blamed.");
+emacs_value egit_blame_job_cancel(emacs_env *env, emacs_value _job)
+{
+    EGIT_ASSERT_BLAME_JOB(_job);
+    egit_blame_job *job = EGIT_EXTRACT(_job);
+
+    pthread_mutex_lock(&job->lock);
+    job->cancelled = true;
+    pthread_mutex_unlock(&job->lock);
+    return esym_nil;
+}
+
+
+// =============================================================================
+// Cache
+
+/*
+ * Blame results are cached in files named by a key hash in the directory
+ * BLAME_CACHE_DIR inside the git directory. Each file has the layout
+ *
+ *   header:  signature, version, hunk count, string table size (32-bit each),
+ *            then the key
+ *   hunks:   final ID, original ID, final start, original start, lines,
+ *            path, name and email offsets (32-bit each), time (64-bit)
+ *   strings: NUL-terminated, each stored once
+ *
+ * with all integers in network byte order.
+ */
+#define BLAME_CACHE_DIR "egit-blame-cache"
+#define BLAME_CACHE_SIGNATURE 0x45424c43 // "EBLC"
+#define BLAME_CACHE_VERSION 1
+#define BLAME_CACHE_HEADER_SIZE (16 + GIT_OID_RAWSZ)
+#define BLAME_CACHE_HUNK_SIZE (2 * GIT_OID_RAWSZ + 32)
+#define BLAME_CACHE_NO_STRING 0xffffffff
+
+// Maximal total size of the cache in bytes, zero if disabled.
+static size_t blame_cache_limit = 0;
+
+static uint32_t blame_cache_get_be32(const unsigned char *p)
+{
+    return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | p[3];
+}
+
+static void blame_cache_put_be32(unsigned char *p, uint32_t v)
+{
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static char *blame_cache_dir(git_repository *repo)
+{
+    const char *gitdir = git_repository_path(repo);
+    size_t len = strlen(gitdir) + strlen(BLAME_CACHE_DIR) + 1;
+    char *dir = (char*) malloc(len);
+    snprintf(dir, len, "%s%s", gitdir, BLAME_CACHE_DIR);
+    return dir;
+}
+
+static char *blame_cache_file(const char *dir, const git_oid *key)
+{
+    size_t len = strlen(dir) + GIT_OID_HEXSZ + 2;
+    char *file = (char*) malloc(len);
+    snprintf(file, len, "%s/%s", dir, git_oid_tostr_s(key));
+    return file;
+}
+
+/**
+ * Compute the cache key of a blame. OPTS must have a resolved newest commit.
+ */
+static int blame_cache_key(git_oid *out, const char *path, const git_blame_options *opts)
+{
+    char newest[GIT_OID_HEXSZ + 1], oldest[GIT_OID_HEXSZ + 1];
+    git_oid_tostr(newest, sizeof(newest), &opts->newest_commit);
+    git_oid_tostr(oldest, sizeof(oldest), &opts->oldest_commit);
+
+    size_t len = strlen(path) + 2 * GIT_OID_HEXSZ + 128;
+    char *buf = (char*) malloc(len);
+    int n = snprintf(buf, len, "egit-blame-cache %d\n%s\n%s\n%u\n%lu\n%lu\n%s",
+                     BLAME_CACHE_VERSION, newest, oldest, (unsigned) opts->flags,
+                     (unsigned long) opts->min_line, (unsigned long) opts->max_line, path);
+    int retval = git_odb_hash(out, buf, n, GIT_OBJ_BLOB);
+    free(buf);
+    return retval;
+}
+
+/**
+ * Read a cache file into a vector of hunk records.
+ * @return True on a cache hit. Missing, truncated or mismatching files are misses.
+ */
+static bool blame_cache_read(emacs_value *out, emacs_env *env, const char *file, const git_oid *key)
+{
+    FILE *f = fopen(file, "rb");
+    if (!f)
+        return false;
+
+    struct stat st;
+    if (fstat(fileno(f), &st) != 0 || st.st_size < BLAME_CACHE_HEADER_SIZE) {
+        fclose(f);
+        return false;
+    }
+
+    size_t size = st.st_size;
+    unsigned char *data = NULL;
+    bool mapped = false;
+#ifndef _WIN32
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileno(f), 0);
+    if (map != MAP_FAILED) {
+        data = (unsigned char*) map;
+        mapped = true;
+    }
+#endif
+    if (!data) {
+        data = (unsigned char*) malloc(size);
+        if (fread(data, 1, size, f) != size) {
+            free(data);
+            fclose(f);
+            return false;
+        }
+    }
+    fclose(f);
+
+    bool hit = false;
+    uint32_t nhunks = blame_cache_get_be32(data + 8);
+    uint32_t nstrings = blame_cache_get_be32(data + 12);
+    size_t body = size - BLAME_CACHE_HEADER_SIZE;
+
+    if (blame_cache_get_be32(data) != BLAME_CACHE_SIGNATURE ||
+        blame_cache_get_be32(data + 4) != BLAME_CACHE_VERSION ||
+        memcmp(data + 16, key->id, GIT_OID_RAWSZ) != 0 ||
+        nstrings > body ||
+        (body - nstrings) % BLAME_CACHE_HUNK_SIZE != 0 ||
+        (body - nstrings) / BLAME_CACHE_HUNK_SIZE != nhunks ||
+        (nstrings > 0 && data[size - 1] != '\0'))
+        goto cleanup;
+
+    const unsigned char *hunks = data + BLAME_CACHE_HEADER_SIZE;
+    const char *strings = (const char*) hunks + (size_t) nhunks * BLAME_CACHE_HUNK_SIZE;
+
+    blame_record *recs = (blame_record*) malloc((nhunks ? nhunks : 1) * sizeof(blame_record));
+    bool valid = true;
+    for (uint32_t i = 0; valid && i < nhunks; i++) {
+        const unsigned char *h = hunks + (size_t) i * BLAME_CACHE_HUNK_SIZE;
+        const unsigned char *p = h + 2 * GIT_OID_RAWSZ;
+        blame_record *rec = &recs[i];
+        git_oid_fromraw(&rec->final_id, h);
+        git_oid_fromraw(&rec->orig_id, h + GIT_OID_RAWSZ);
+        rec->final_start = blame_cache_get_be32(p);
+        rec->orig_start = blame_cache_get_be32(p + 4);
+        rec->lines = blame_cache_get_be32(p + 8);
+
+        const char **fields[3] = {&rec->path, &rec->name, &rec->email};
+        for (int j = 0; j < 3; j++) {
+            uint32_t offset = blame_cache_get_be32(p + 12 + 4 * j);
+            if (offset == BLAME_CACHE_NO_STRING)
+                *fields[j] = NULL;
+            else if (offset < nstrings)
+                *fields[j] = strings + offset;
+            else
+                valid = false;
+        }
+        rec->time = (git_time_t) (((uint64_t) blame_cache_get_be32(p + 24) << 32) |
+                                  blame_cache_get_be32(p + 28));
+    }
+
+    if (valid) {
+        *out = blame_records_value(env, recs, nhunks);
+        hit = true;
+    }
+    free(recs);
+
+  cleanup:
+#ifndef _WIN32
+    if (mapped)
+        munmap(data, size);
+    else
+#endif
+        free(data);
+    return hit;
+}
+
+typedef struct {
+    char *data;
+    size_t size, alloc;
+    uint32_t *hashes, *offsets;
+    size_t count, capacity;
+} blame_cache_strings;
+
+/**
+ * Add a string to the string table of a cache file, unless it is already there.
+ * The number of distinct paths and authors of a file is small, so a linear
+ * scan over the hashes is good enough.
+ */
+static uint32_t blame_cache_string(blame_cache_strings *table, const char *str)
+{
+    if (!str)
+        return BLAME_CACHE_NO_STRING;
+
+    uint32_t hash = (uint32_t) blame_strings_hash(str);
+    for (size_t i = 0; i < table->count; i++)
+        if (table->hashes[i] == hash && !strcmp(table->data + table->offsets[i], str))
+            return table->offsets[i];
+
+    size_t len = strlen(str) + 1;
+    if (table->size + len > table->alloc) {
+        table->alloc = 2 * (table->size + len);
+        table->data = (char*) realloc(table->data, table->alloc);
+    }
+    if (table->count == table->capacity) {
+        table->capacity = table->capacity ? 2 * table->capacity : 16;
+        table->hashes = (uint32_t*) realloc(table->hashes, table->capacity * sizeof(uint32_t));
+        table->offsets = (uint32_t*) realloc(table->offsets, table->capacity * sizeof(uint32_t));
+    }
+
+    uint32_t offset = (uint32_t) table->size;
+    memcpy(table->data + table->size, str, len);
+    table->size += len;
+    table->hashes[table->count] = hash;
+    table->offsets[table->count++] = offset;
+    return offset;
+}
+
+static bool blame_cache_write(const char *file, const git_oid *key, git_blame *blame)
+{
+    uint32_t count = git_blame_get_hunk_count(blame);
+    size_t hunks_size = (size_t) count * BLAME_CACHE_HUNK_SIZE;
+    unsigned char *hunks = (unsigned char*) malloc(hunks_size ? hunks_size : 1);
+    blame_cache_strings strings = {0};
+
+    for (uint32_t i = 0; i < count; i++) {
+        blame_record rec;
+        blame_record_init(&rec, git_blame_get_hunk_byindex(blame, i));
+
+        unsigned char *h = hunks + (size_t) i * BLAME_CACHE_HUNK_SIZE;
+        unsigned char *p = h + 2 * GIT_OID_RAWSZ;
+        memcpy(h, rec.final_id.id, GIT_OID_RAWSZ);
+        memcpy(h + GIT_OID_RAWSZ, rec.orig_id.id, GIT_OID_RAWSZ);
+        blame_cache_put_be32(p, (uint32_t) rec.final_start);
+        blame_cache_put_be32(p + 4, (uint32_t) rec.orig_start);
+        blame_cache_put_be32(p + 8, (uint32_t) rec.lines);
+        blame_cache_put_be32(p + 12, blame_cache_string(&strings, rec.path));
+        blame_cache_put_be32(p + 16, blame_cache_string(&strings, rec.name));
+        blame_cache_put_be32(p + 20, blame_cache_string(&strings, rec.email));
+        blame_cache_put_be32(p + 24, (uint32_t) ((uint64_t) rec.time >> 32));
+        blame_cache_put_be32(p + 28, (uint32_t) rec.time);
+    }
+
+    unsigned char header[BLAME_CACHE_HEADER_SIZE];
+    blame_cache_put_be32(header, BLAME_CACHE_SIGNATURE);
+    blame_cache_put_be32(header + 4, BLAME_CACHE_VERSION);
+    blame_cache_put_be32(header + 8, count);
+    blame_cache_put_be32(header + 12, (uint32_t) strings.size);
+    memcpy(header + 16, key->id, GIT_OID_RAWSZ);
+
+    size_t lock_len = strlen(file) + strlen(".lock") + 1;
+    char *lock = (char*) malloc(lock_len);
+    snprintf(lock, lock_len, "%s.lock", file);
+
+    bool ok = false;
+    FILE *f = fopen(lock, "wb");
+    if (f) {
+        ok = fwrite(header, 1, BLAME_CACHE_HEADER_SIZE, f) == BLAME_CACHE_HEADER_SIZE;
+        ok = ok && fwrite(hunks, 1, hunks_size, f) == hunks_size;
+        ok = ok && fwrite(strings.data, 1, strings.size, f) == strings.size;
+        ok = (fclose(f) == 0) && ok;
+#ifdef _WIN32
+        if (ok)
+            remove(file);
+#endif
+        ok = ok && rename(lock, file) == 0;
+        if (!ok)
+            remove(lock);
+    }
+
+    free(lock);
+    free(hunks);
+    free(strings.data);
+    free(strings.hashes);
+    free(strings.offsets);
+    return ok;
+}
+
+typedef struct {
+    char *file;
+    size_t size;
+    time_t mtime;
+} blame_cache_entry;
+
+static int blame_cache_entry_cmp(const void *a, const void *b)
+{
+    time_t ta = ((const blame_cache_entry*) a)->mtime, tb = ((const blame_cache_entry*) b)->mtime;
+    return ta < tb ? -1 : ta > tb;
+}
+
+static bool blame_cache_is_entry(const char *name)
+{
+    if (strlen(name) != GIT_OID_HEXSZ)
+        return false;
+    for (; *name; name++)
+        if (!isxdigit((unsigned char) *name))
+            return false;
+    return true;
+}
+
+/**
+ * Remove the least recently used cache files until the cache fits in its limit.
+ */
+static void blame_cache_evict(const char *dir)
+{
+    DIR *d = opendir(dir);
+    if (!d)
+        return;
+
+    blame_cache_entry *entries = NULL;
+    size_t count = 0, alloc = 0, total = 0;
+    struct dirent *ent;
+    while ((ent = readdir(d))) {
+        if (!blame_cache_is_entry(ent->d_name))
+            continue;
+
+        char *file = (char*) malloc(strlen(dir) + strlen(ent->d_name) + 2);
+        sprintf(file, "%s/%s", dir, ent->d_name);
+        struct stat st;
+        if (stat(file, &st) != 0) {
+            free(file);
+            continue;
+        }
+
+        if (count == alloc) {
+            alloc = alloc ? 2 * alloc : 64;
+            entries = (blame_cache_entry*) realloc(entries, alloc * sizeof(blame_cache_entry));
+        }
+        entries[count++] = (blame_cache_entry) {file, (size_t) st.st_size, st.st_mtime};
+        total += st.st_size;
+    }
+    closedir(d);
+
+    if (total > blame_cache_limit)
+        qsort(entries, count, sizeof(blame_cache_entry), blame_cache_entry_cmp);
+    for (size_t i = 0; i < count; i++) {
+        if (total > blame_cache_limit && remove(entries[i].file) == 0)
+            total -= entries[i].size;
+        free(entries[i].file);
+    }
+    free(entries);
+}
+
+EGIT_DOC(blame_cache_set_limit, "LIMIT",
+         "Enable the blame cache of `libgit-blame-file-hunks', limited to LIMIT bytes.\n"
+         "The cache is stored in the git directory of each repository. When it\n"
+         "grows beyond LIMIT, the least recently used results are removed.\n"
+         "If LIMIT is nil or zero, disable the cache.");
+emacs_value egit_blame_cache_set_limit(emacs_env *env, emacs_value _limit)
+{
+    intmax_t limit = 0;
+    if (EM_EXTRACT_BOOLEAN(_limit)) {
+        EM_ASSERT_INTEGER(_limit);
+        limit = EM_EXTRACT_INTEGER(_limit);
+        if (limit < 0) {
+            em_signal_args_out_of_range(env, limit);
+            return esym_nil;
+        }
+    }
+    blame_cache_limit = limit;
+    return esym_nil;
+}
+
+EGIT_DOC(blame_file_hunks, "REPOSITORY PATH &optional OPTIONS",
+         "Return the hunks of the blame of PATH as a vector of records.\n"
+         "This is the same as calling `libgit-blame-hunks' on the result of\n"
+         "`libgit-blame-file' with the same arguments, but if the blame cache\n"
+         "is enabled (see `libgit-blame-cache-set-limit') the result is read\n"
+         "from the cache when possible, and stored in it otherwise. Results are\n"
+         "keyed by the newest commit, PATH and OPTIONS, so they never go stale.");
+emacs_value egit_blame_file_hunks(
+    emacs_env *env, emacs_value _repo, emacs_value _path, emacs_value options)
+{
+    EGIT_ASSERT_REPOSITORY(_repo);
+    EM_ASSERT_STRING(_path);
+
+    git_repository *repo = EGIT_EXTRACT(_repo);
+
+    git_blame_options opts;
+    extract_options(env, options, &opts);
+    EM_RETURN_NIL_IF_NLE();
+
+    // Resolve HEAD now, so that the cache key names a fixed commit
+    int retval = 0;
+    if (git_oid_iszero(&opts.newest_commit))
+        retval = git_reference_name_to_id(&opts.newest_commit, repo, "HEAD");
+    EGIT_CHECK_ERROR(retval);
+
+    char *path = EM_EXTRACT_STRING(_path);
+    char *dir = NULL, *file = NULL;
+    emacs_value ret = esym_nil;
+    git_oid key;
+
+    if (blame_cache_limit > 0 && blame_cache_key(&key, path, &opts) == 0) {
+        dir = blame_cache_dir(repo);
+        file = blame_cache_file(dir, &key);
+        if (blame_cache_read(&ret, env, file, &key)) {
+            // Mark the entry as recently used
+            utime(file, NULL);
+            goto cleanup;
+        }
+    }
+
+    git_blame *blame = NULL;
+    retval = git_blame_file(&blame, repo, path, &opts);
+    if (retval < 0)
+        goto cleanup;
+
+    ret = blame_hunks_value(env, blame);
+
+    if (file) {
+#ifdef _WIN32
+        _mkdir(dir);
+#else
+        mkdir(dir, 0777);
+#endif
+        if (blame_cache_write(file, &key, blame))
+            blame_cache_evict(dir);
+    }
+    git_blame_free(blame);
+
+  cleanup:
+    free(path);
+    free(dir);
+    free(file);
+    EGIT_CHECK_ERROR(retval);
+    return ret;
+}
@@ -3,10 +3,23 @@
 #ifndef EGIT_BLAME_H
 #define EGIT_BLAME_H
 
+/**
+ * A blame running on a background thread, see `libgit-blame-file-incremental'.
+ */
+typedef struct egit_blame_job egit_blame_job;
+
+/**
+ * Cancel a blame job and release the reference held by its Lisp wrapper.
+ * The job is freed once its thread has stopped.
+ */
+void egit_blame_job_free(egit_blame_job *job);
+
 EGIT_DEFUN(blame_file, emacs_value _repo, emacs_value _path, emacs_value _options);
+EGIT_DEFUN(blame_buffer, emacs_value _blame, emacs_value _contents);
 EGIT_DEFUN(blame_get_hunk_byindex, emacs_value _blame, emacs_value _index);
 EGIT_DEFUN(blame_get_hunk_byline, emacs_value _blame, emacs_value _line);
 EGIT_DEFUN(blame_get_hunk_count, emacs_value _blame);
+EGIT_DEFUN(blame_hunks, emacs_value _blame);
 
 EGIT_DEFUN(blame_hunk_commit_id, emacs_value _hunk, emacs_value orig);
 EGIT_DEFUN(blame_hunk_lines, emacs_value _hunk);
@@ -14,4 +27,12 @@ EGIT_DEFUN(blame_hunk_orig_path, emacs_value _hunk);
 EGIT_DEFUN(blame_hunk_signature, emacs_value _hunk, emacs_value orig);
 EGIT_DEFUN(blame_hunk_start_line_number, emacs_value _hunk, emacs_value orig);
 
+EGIT_DEFUN(blame_cache_set_limit, emacs_value _limit);
+EGIT_DEFUN(blame_file_hunks, emacs_value _repo, emacs_value _path, emacs_value _options);
+
+EGIT_DEFUN(blame_file_incremental, emacs_value _repo, emacs_value _path, emacs_value _options);
+EGIT_DEFUN(blame_job_poll, emacs_value _job);
+EGIT_DEFUN(blame_job_done_p, emacs_value _job);
+EGIT_DEFUN(blame_job_cancel, emacs_value _job);
+
 #endif /* EGIT_BLAME_H */
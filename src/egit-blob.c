@@ -170,6 +170,36 @@ emacs_value egit_blob_rawcontent(emacs_env *env, emacs_value _blob)
     return em_string_as_unibyte(env, str);
 }
 
+EGIT_DOC(blob_read_range, "BLOB OFFSET LENGTH",
+         "Get LENGTH bytes of the raw content of BLOB from OFFSET, as a unibyte string.\n"
+         "The result is shorter if the blob ends before OFFSET + LENGTH.");
+emacs_value egit_blob_read_range(
+    emacs_env *env, emacs_value _blob, emacs_value _offset, emacs_value _length)
+{
+    EGIT_ASSERT_BLOB(_blob);
+    EM_ASSERT_INTEGER(_offset);
+    EM_ASSERT_INTEGER(_length);
+
+    git_blob *blob = EGIT_EXTRACT(_blob);
+    intmax_t size = git_blob_rawsize(blob);
+    intmax_t offset = EM_EXTRACT_INTEGER(_offset);
+    intmax_t length = EM_EXTRACT_INTEGER(_length);
+    if (offset < 0 || offset > size) {
+        em_signal_args_out_of_range(env, offset);
+        return esym_nil;
+    }
+    if (length < 0) {
+        em_signal_args_out_of_range(env, length);
+        return esym_nil;
+    }
+    if (length > size - offset)
+        length = size - offset;
+
+    const char *content = (const char*) git_blob_rawcontent(blob);
+    emacs_value str = env->make_string(env, content + offset, length);
+    return em_string_as_unibyte(env, str);
+}
+
 EGIT_DOC(blob_rawsize, "BLOB", "Get the number of bytes in BLOB.");
 emacs_value egit_blob_rawsize(emacs_env *env, emacs_value _blob)
 {
@@ -178,3 +208,90 @@ emacs_value egit_blob_rawsize(emacs_env *env, emacs_value _blob)
     git_off_t size = git_blob_rawsize(blob);
     return EM_INTEGER(size);
 }
+
+
+// =============================================================================
+// Insertion
+
+// Number of bytes inserted at once, so that no Lisp string as large as the blob is made.
+#define BLOB_INSERT_CHUNK (1 << 20)
+
+/**
+ * Insert SIZE bytes from DATA at point, in chunks.
+ * In a multibyte buffer the bytes are decoded as UTF-8, and chunks end on
+ * character boundaries. In a unibyte buffer, each byte is passed as the
+ * character with that code, which Emacs stores as the byte itself, so the
+ * data is inserted verbatim without going through raw-byte decoding.
+ */
+static void blob_insert(emacs_env *env, const char *data, size_t size)
+{
+    bool multibyte = em_buffer_multibyte_p(env);
+    char *latin1 = multibyte ? NULL : (char*) malloc(2 * BLOB_INSERT_CHUNK);
+
+    size_t pos = 0;
+    while (pos < size && !env->non_local_exit_check(env)) {
+        size_t len = size - pos < BLOB_INSERT_CHUNK ? size - pos : BLOB_INSERT_CHUNK;
+
+        if (multibyte) {
+            // Back off over UTF-8 continuation bytes, but never to an empty chunk
+            size_t end = pos + len;
+            for (int i = 0; i < 3 && end < size && end > pos + 1 &&
+                     ((unsigned char) data[end] & 0xc0) == 0x80; i++)
+                end--;
+            len = end - pos;
+            em_insert(env, data + pos, len);
+        }
+        else {
+            size_t n = 0;
+            for (size_t i = 0; i < len; i++) {
+                unsigned char c = data[pos + i];
+                if (c < 0x80)
+                    latin1[n++] = c;
+                else {
+                    latin1[n++] = 0xc0 | (c >> 6);
+                    latin1[n++] = 0x80 | (c & 0x3f);
+                }
+            }
+            em_insert(env, latin1, n);
+        }
+
+        pos += len;
+    }
+
+    free(latin1);
+}
+
+EGIT_DOC(blob_insert, "BLOB &optional PATH IGNORE-BINARY",
+         "Insert the content of BLOB at point in the current buffer.\n"
+         "If PATH is non-nil, insert the content filtered as for that path,\n"
+         "see `libgit-blob-filtered-content'. Otherwise insert the raw content.\n\n"
+         "The content is inserted in chunks, without making a string of the\n"
+         "whole blob. In a multibyte buffer it is decoded as UTF-8, with invalid\n"
+         "sequences kept as raw bytes. In a unibyte buffer the bytes are\n"
+         "inserted verbatim, which is the right choice for binary data.\n"
+         "Return the number of bytes inserted.");
+emacs_value egit_blob_insert(
+    emacs_env *env, emacs_value _blob, emacs_value _path, emacs_value ignore)
+{
+    EGIT_ASSERT_BLOB(_blob);
+    git_blob *blob = EGIT_EXTRACT(_blob);
+
+    if (!EM_EXTRACT_BOOLEAN(_path)) {
+        size_t size = git_blob_rawsize(blob);
+        blob_insert(env, (const char*) git_blob_rawcontent(blob), size);
+        return EM_INTEGER(size);
+    }
+
+    EM_ASSERT_STRING(_path);
+    char *path = EM_EXTRACT_STRING(_path);
+
+    git_buf buf = {NULL};
+    int retval = git_blob_filtered_content(&buf, blob, path, !EM_EXTRACT_BOOLEAN(ignore));
+    free(path);
+    EGIT_CHECK_ERROR(retval);
+
+    blob_insert(env, buf.ptr, buf.size);
+    size_t size = buf.size;
+    git_buf_dispose(&buf);
+    return EM_INTEGER(size);
+}
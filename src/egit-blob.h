@@ -13,5 +13,8 @@ EGIT_DEFUN(blob_id, emacs_value _blob);
 EGIT_DEFUN(blob_owner, emacs_value _blob);
 EGIT_DEFUN(blob_rawcontent, emacs_value _blob);
 EGIT_DEFUN(blob_rawsize, emacs_value _blob);
+EGIT_DEFUN(blob_read_range, emacs_value _blob, emacs_value _offset, emacs_value _length);
+
+EGIT_DEFUN(blob_insert, emacs_value _blob, emacs_value _path, emacs_value ignore);
 
 #endif /* EGIT_BLOB_H */
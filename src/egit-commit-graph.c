@@ -0,0 +1,1256 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "git2.h"
+
+#include "egit.h"
+#include "interface.h"
+#include "egit-commit-graph.h"
+
+// See Documentation/technical/commit-graph-format.txt in git.git
+#define CG_SIGNATURE 0x43475048 // "CGPH"
+#define CG_VERSION 1
+#define CG_HASH_VERSION 1
+#define CG_HEADER_SIZE 8
+
+// Number of commit-graphs kept mapped at once
+#define CG_CACHE_MAX 16
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+#define CG_CHUNK_ENTRY_SIZE 12
+#define CG_CHUNK_OIDF 0x4f494446 // "OIDF"
+#define CG_CHUNK_OIDL 0x4f49444c // "OIDL"
+#define CG_CHUNK_CDAT 0x43444154 // "CDAT"
+#define CG_CHUNK_EDGE 0x45444745 // "EDGE"
+#define CG_FANOUT_SIZE (256 * 4)
+#define CG_CDAT_SIZE (GIT_OID_RAWSZ + 16)
+#define CG_PARENT_NONE 0x70000000
+#define CG_EXTRA_EDGES 0x80000000
+#define CG_EDGE_LAST 0x80000000
+#define CG_EDGE_MASK 0x7fffffff
+#define CG_GENERATION_MAX 0x3fffffff
+
+
+// =============================================================================
+// Helpers - byte order and hashing
+
+static uint32_t cg_get_be32(const unsigned char *p)
+{
+    return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | p[3];
+}
+
+static uint64_t cg_get_be64(const unsigned char *p)
+{
+    return ((uint64_t) cg_get_be32(p) << 32) | cg_get_be32(p + 4);
+}
+
+static void cg_put_be32(unsigned char *p, uint32_t v)
+{
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static void cg_put_be64(unsigned char *p, uint64_t v)
+{
+    cg_put_be32(p, (uint32_t) (v >> 32));
+    cg_put_be32(p + 4, (uint32_t) v);
+}
+
+/**
+ * Compute the SHA-1 of a buffer. This is only used for the trailing checksum
+ * of the files we write, which libgit2 has no public API for.
+ */
+static void cg_sha1(unsigned char out[20], const unsigned char *data, size_t len)
+{
+    uint32_t h[5] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0};
+    unsigned char block[64];
+    uint64_t bits = (uint64_t) len * 8;
+    size_t total = ((len + 8) / 64 + 1) * 64;
+
+    for (size_t off = 0; off < total; off += 64) {
+        for (size_t i = 0; i < 64; i++) {
+            size_t j = off + i;
+            if (j < len)
+                block[i] = data[j];
+            else if (j == len)
+                block[i] = 0x80;
+            else if (j >= total - 8)
+                block[i] = (unsigned char) (bits >> (8 * (total - 1 - j)));
+            else
+                block[i] = 0;
+        }
+
+        uint32_t w[80];
+        for (int i = 0; i < 16; i++)
+            w[i] = cg_get_be32(block + 4 * i);
+        for (int i = 16; i < 80; i++) {
+            uint32_t x = w[i-3] ^ w[i-8] ^ w[i-14] ^ w[i-16];
+            w[i] = (x << 1) | (x >> 31);
+        }
+
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; i++) {
+            uint32_t f, k;
+            if (i < 20) { f = (b & c) | (~b & d); k = 0x5a827999; }
+            else if (i < 40) { f = b ^ c ^ d; k = 0x6ed9eba1; }
+            else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8f1bbcdc; }
+            else { f = b ^ c ^ d; k = 0xca62c1d6; }
+            uint32_t t = ((a << 5) | (a >> 27)) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = (b << 30) | (b >> 2);
+            b = a;
+            a = t;
+        }
+        h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+    }
+
+    for (int i = 0; i < 5; i++)
+        cg_put_be32(out + 4 * i, h[i]);
+}
+
+
+// =============================================================================
+// Helpers - reading
+
+struct egit_cgraph {
+    char *path;
+    off_t file_size;
+    time_t file_mtime;
+    ino_t file_ino;
+
+    unsigned char *data;
+    size_t size;
+    bool mapped;
+
+    uint32_t num_commits;
+    const unsigned char *fanout;
+    const unsigned char *oids;
+    const unsigned char *cdat;
+    const unsigned char *edges;
+    uint32_t num_edges;
+
+    // False if some commits have no generation number. Git before 2.19
+    // wrote zero for every commit, which must not be used as a real number.
+    bool generations;
+
+    egit_cgraph *next;
+};
+
+// Commit-graphs are cached per repository path, since many repository
+// objects may be opened for the same repository. The list is kept in order
+// of use, and graphs past CG_CACHE_MAX are unmapped, so that repositories
+// that are no longer used, or have been deleted, don't hold on to memory.
+static egit_cgraph *cg_cache = NULL;
+
+static void cg_free(egit_cgraph *graph)
+{
+#ifndef _WIN32
+    if (graph->mapped)
+        munmap(graph->data, graph->size);
+    else
+#endif
+        free(graph->data);
+    free(graph->path);
+    free(graph);
+}
+
+static bool cg_load(egit_cgraph *graph)
+{
+    FILE *file = fopen(graph->path, "rb");
+    if (!file)
+        return false;
+
+    graph->size = graph->file_size;
+    graph->mapped = false;
+    graph->data = NULL;
+
+#ifndef _WIN32
+    void *map = mmap(NULL, graph->size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+    if (map != MAP_FAILED) {
+        graph->data = (unsigned char*) map;
+        graph->mapped = true;
+    }
+#endif
+
+    if (!graph->data) {
+        graph->data = (unsigned char*) malloc(graph->size);
+        if (fread(graph->data, 1, graph->size, file) != graph->size) {
+            fclose(file);
+            return false;
+        }
+    }
+
+    fclose(file);
+    return true;
+}
+
+/**
+ * Validate the file structure and set up the chunk pointers.
+ * All parent positions are checked here so that the accessors can trust them.
+ */
+static bool cg_parse(egit_cgraph *graph)
+{
+    const unsigned char *data = graph->data;
+    size_t size = graph->size;
+
+    if (size < CG_HEADER_SIZE + CG_CHUNK_ENTRY_SIZE + GIT_OID_RAWSZ)
+        return false;
+    if (cg_get_be32(data) != CG_SIGNATURE || data[4] != CG_VERSION || data[5] != CG_HASH_VERSION)
+        return false;
+
+    // We don't support split commit-graph chains
+    uint8_t nchunks = data[6];
+    if (data[7] != 0)
+        return false;
+
+    size_t table_end = CG_HEADER_SIZE + ((size_t) nchunks + 1) * CG_CHUNK_ENTRY_SIZE;
+    size_t data_end = size - GIT_OID_RAWSZ;
+    if (table_end > data_end)
+        return false;
+
+    size_t oidf_size = 0, oidl_size = 0, cdat_size = 0, edge_size = 0;
+    for (uint8_t i = 0; i < nchunks; i++) {
+        const unsigned char *entry = data + CG_HEADER_SIZE + i * CG_CHUNK_ENTRY_SIZE;
+        uint32_t id = cg_get_be32(entry);
+        uint64_t start = cg_get_be64(entry + 4);
+        uint64_t end = cg_get_be64(entry + 4 + CG_CHUNK_ENTRY_SIZE);
+        if (start < table_end || end < start || end > data_end)
+            return false;
+
+        switch (id) {
+        case CG_CHUNK_OIDF: graph->fanout = data + start; oidf_size = end - start; break;
+        case CG_CHUNK_OIDL: graph->oids = data + start; oidl_size = end - start; break;
+        case CG_CHUNK_CDAT: graph->cdat = data + start; cdat_size = end - start; break;
+        case CG_CHUNK_EDGE: graph->edges = data + start; edge_size = end - start; break;
+        default: break;
+        }
+    }
+
+    if (!graph->fanout || !graph->oids || !graph->cdat || oidf_size != CG_FANOUT_SIZE)
+        return false;
+
+    uint32_t prev = 0;
+    for (int i = 0; i < 256; i++) {
+        uint32_t count = cg_get_be32(graph->fanout + 4 * i);
+        if (count < prev)
+            return false;
+        prev = count;
+    }
+    graph->num_commits = prev;
+    if (oidl_size != (size_t) prev * GIT_OID_RAWSZ || cdat_size != (size_t) prev * CG_CDAT_SIZE)
+        return false;
+    if (edge_size % 4 != 0)
+        return false;
+    graph->num_edges = edge_size / 4;
+
+    for (uint32_t i = 0; i < graph->num_edges; i++)
+        if ((cg_get_be32(graph->edges + 4 * i) & CG_EDGE_MASK) >= graph->num_commits)
+            return false;
+
+    graph->generations = true;
+    for (uint32_t pos = 0; pos < graph->num_commits; pos++) {
+        const unsigned char *cdat = graph->cdat + (size_t) pos * CG_CDAT_SIZE;
+        if ((cg_get_be32(cdat + GIT_OID_RAWSZ + 8) >> 2) == 0)
+            graph->generations = false;
+        uint32_t p1 = cg_get_be32(cdat + GIT_OID_RAWSZ);
+        uint32_t p2 = cg_get_be32(cdat + GIT_OID_RAWSZ + 4);
+        if (p1 != CG_PARENT_NONE && p1 >= graph->num_commits)
+            return false;
+        if (p2 == CG_PARENT_NONE)
+            continue;
+        if (!(p2 & CG_EXTRA_EDGES)) {
+            if (p2 >= graph->num_commits)
+                return false;
+            continue;
+        }
+
+        // Octopus merges must have a terminated list in the EDGE chunk
+        uint32_t e = p2 & CG_EDGE_MASK;
+        while (e < graph->num_edges && !(cg_get_be32(graph->edges + 4 * e) & CG_EDGE_LAST))
+            e++;
+        if (e >= graph->num_edges)
+            return false;
+    }
+
+    return true;
+}
+
+static char *cg_path(git_repository *repo)
+{
+    const char *commondir = git_repository_commondir(repo);
+    if (!commondir)
+        return NULL;
+    size_t len = strlen(commondir) + strlen("objects/info/commit-graph") + 1;
+    char *path = (char*) malloc(len);
+    snprintf(path, len, "%sobjects/info/commit-graph", commondir);
+    return path;
+}
+
+egit_cgraph *egit_cgraph_get(git_repository *repo)
+{
+    char *path = cg_path(repo);
+    if (!path)
+        return NULL;
+
+    struct stat st;
+    bool exists = stat(path, &st) == 0;
+
+    // Find a cached graph and check whether it is still current
+    egit_cgraph **prevp = &cg_cache;
+    for (egit_cgraph *graph = cg_cache; graph; prevp = &graph->next, graph = graph->next) {
+        if (strcmp(graph->path, path) != 0)
+            continue;
+        if (exists && graph->file_size == st.st_size && graph->file_mtime == st.st_mtime &&
+            graph->file_ino == st.st_ino) {
+            *prevp = graph->next;
+            graph->next = cg_cache;
+            cg_cache = graph;
+            free(path);
+            return graph;
+        }
+        *prevp = graph->next;
+        cg_free(graph);
+        break;
+    }
+
+    if (!exists) {
+        free(path);
+        return NULL;
+    }
+
+    egit_cgraph *graph = (egit_cgraph*) calloc(1, sizeof(egit_cgraph));
+    graph->path = path;
+    graph->file_size = st.st_size;
+    graph->file_mtime = st.st_mtime;
+    graph->file_ino = st.st_ino;
+
+    if (!cg_load(graph) || !cg_parse(graph)) {
+        cg_free(graph);
+        return NULL;
+    }
+
+    graph->next = cg_cache;
+    cg_cache = graph;
+
+    size_t n = 0;
+    for (prevp = &cg_cache; *prevp; prevp = &(*prevp)->next) {
+        if (++n > CG_CACHE_MAX) {
+            egit_cgraph *old = *prevp;
+            *prevp = NULL;
+            while (old) {
+                egit_cgraph *next = old->next;
+                cg_free(old);
+                old = next;
+            }
+            break;
+        }
+    }
+
+    return graph;
+}
+
+
+// =============================================================================
+// Accessors
+
+bool egit_cgraph_find(const egit_cgraph *graph, const git_oid *oid, uint32_t *pos)
+{
+    uint8_t first = oid->id[0];
+    uint32_t lo = first ? cg_get_be32(graph->fanout + 4 * (first - 1)) : 0;
+    uint32_t hi = cg_get_be32(graph->fanout + 4 * first);
+
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        int cmp = memcmp(graph->oids + (size_t) mid * GIT_OID_RAWSZ, oid->id, GIT_OID_RAWSZ);
+        if (cmp == 0) {
+            *pos = mid;
+            return true;
+        }
+        if (cmp < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return false;
+}
+
+uint32_t egit_cgraph_count(const egit_cgraph *graph)
+{
+    return graph->num_commits;
+}
+
+const git_oid *egit_cgraph_oid(const egit_cgraph *graph, uint32_t pos)
+{
+    return (const git_oid*) (graph->oids + (size_t) pos * GIT_OID_RAWSZ);
+}
+
+uint32_t egit_cgraph_generation(const egit_cgraph *graph, uint32_t pos)
+{
+    if (!graph->generations)
+        return 0;
+    const unsigned char *cdat = graph->cdat + (size_t) pos * CG_CDAT_SIZE;
+    return cg_get_be32(cdat + GIT_OID_RAWSZ + 8) >> 2;
+}
+
+int64_t egit_cgraph_time(const egit_cgraph *graph, uint32_t pos)
+{
+    const unsigned char *cdat = graph->cdat + (size_t) pos * CG_CDAT_SIZE;
+    uint64_t high = cg_get_be32(cdat + GIT_OID_RAWSZ + 8) & 0x3;
+    return (int64_t) ((high << 32) | cg_get_be32(cdat + GIT_OID_RAWSZ + 12));
+}
+
+uint32_t egit_cgraph_parentcount(const egit_cgraph *graph, uint32_t pos)
+{
+    const unsigned char *cdat = graph->cdat + (size_t) pos * CG_CDAT_SIZE;
+    if (cg_get_be32(cdat + GIT_OID_RAWSZ) == CG_PARENT_NONE)
+        return 0;
+
+    uint32_t p2 = cg_get_be32(cdat + GIT_OID_RAWSZ + 4);
+    if (p2 == CG_PARENT_NONE)
+        return 1;
+    if (!(p2 & CG_EXTRA_EDGES))
+        return 2;
+
+    uint32_t count = 2, e = p2 & CG_EDGE_MASK;
+    while (!(cg_get_be32(graph->edges + 4 * e) & CG_EDGE_LAST)) {
+        count++;
+        e++;
+    }
+    return count;
+}
+
+uint32_t egit_cgraph_parent(const egit_cgraph *graph, uint32_t pos, uint32_t n)
+{
+    const unsigned char *cdat = graph->cdat + (size_t) pos * CG_CDAT_SIZE;
+    if (n == 0)
+        return cg_get_be32(cdat + GIT_OID_RAWSZ);
+
+    uint32_t p2 = cg_get_be32(cdat + GIT_OID_RAWSZ + 4);
+    if (!(p2 & CG_EXTRA_EDGES))
+        return p2;
+    return cg_get_be32(graph->edges + 4 * ((p2 & CG_EDGE_MASK) + n - 1)) & CG_EDGE_MASK;
+}
+
+
+// =============================================================================
+// Helpers - priority queue
+
+/**
+ * A max-heap of commit positions, ordered by generation number and then by
+ * commit time, so that commits are always popped before their ancestors.
+ */
+typedef struct {
+    const egit_cgraph *graph;
+    uint32_t *items;
+    size_t size, alloc;
+} cg_queue;
+
+static bool cg_queue_before(const cg_queue *q, uint32_t a, uint32_t b)
+{
+    uint32_t ga = egit_cgraph_generation(q->graph, a);
+    uint32_t gb = egit_cgraph_generation(q->graph, b);
+    if (ga != gb)
+        return ga > gb;
+    return egit_cgraph_time(q->graph, a) > egit_cgraph_time(q->graph, b);
+}
+
+static void cg_queue_push(cg_queue *q, uint32_t pos)
+{
+    if (q->size == q->alloc) {
+        q->alloc = q->alloc ? 2 * q->alloc : 64;
+        q->items = (uint32_t*) realloc(q->items, q->alloc * sizeof(uint32_t));
+    }
+
+    size_t i = q->size++;
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!cg_queue_before(q, pos, q->items[parent]))
+            break;
+        q->items[i] = q->items[parent];
+        i = parent;
+    }
+    q->items[i] = pos;
+}
+
+static uint32_t cg_queue_pop(cg_queue *q)
+{
+    uint32_t top = q->items[0];
+    uint32_t last = q->items[--q->size];
+
+    size_t i = 0;
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= q->size)
+            break;
+        if (child + 1 < q->size && cg_queue_before(q, q->items[child + 1], q->items[child]))
+            child++;
+        if (!cg_queue_before(q, q->items[child], last))
+            break;
+        q->items[i] = q->items[child];
+        i = child;
+    }
+    if (q->size > 0)
+        q->items[i] = last;
+
+    return top;
+}
+
+static uint32_t cg_queue_peek(const cg_queue *q)
+{
+    return q->items[0];
+}
+
+
+// =============================================================================
+// Queries
+
+#define CG_FROM_LOCAL 1
+#define CG_FROM_UPSTREAM 2
+#define CG_FROM_BOTH 3
+#define CG_QUEUED 4
+
+bool egit_cgraph_ahead_behind(
+    size_t *ahead, size_t *behind, const egit_cgraph *graph,
+    uint32_t local, uint32_t upstream)
+{
+    *ahead = *behind = 0;
+    if (local == upstream)
+        return true;
+
+    // Without generation numbers, commits can't be popped before their
+    // ancestors, and the walk can't tell when to stop
+    if (!graph->generations)
+        return false;
+
+    uint8_t *flags = (uint8_t*) calloc(graph->num_commits, 1);
+    cg_queue queue = {graph, NULL, 0, 0};
+
+    // Number of queued commits not yet known to be reachable from both sides.
+    // Once this reaches zero, the remaining commits are all shared.
+    size_t interesting = 2;
+    flags[local] = CG_FROM_LOCAL | CG_QUEUED;
+    flags[upstream] = CG_FROM_UPSTREAM | CG_QUEUED;
+    cg_queue_push(&queue, local);
+    cg_queue_push(&queue, upstream);
+
+    while (queue.size > 0 && interesting > 0) {
+        uint32_t pos = cg_queue_pop(&queue);
+        uint8_t side = flags[pos] & CG_FROM_BOTH;
+        if (side != CG_FROM_BOTH)
+            interesting--;
+
+        if (side == CG_FROM_LOCAL)
+            (*ahead)++;
+        else if (side == CG_FROM_UPSTREAM)
+            (*behind)++;
+
+        uint32_t nparents = egit_cgraph_parentcount(graph, pos);
+        for (uint32_t i = 0; i < nparents; i++) {
+            uint32_t parent = egit_cgraph_parent(graph, pos, i);
+            uint8_t old = flags[parent];
+            flags[parent] |= side | CG_QUEUED;
+
+            if (!(old & CG_QUEUED)) {
+                cg_queue_push(&queue, parent);
+                if (side != CG_FROM_BOTH)
+                    interesting++;
+            }
+            else if ((old & CG_FROM_BOTH) != CG_FROM_BOTH && (flags[parent] & CG_FROM_BOTH) == CG_FROM_BOTH)
+                // Since commits are popped in generation order, a parent that
+                // has been queued has not been popped yet
+                interesting--;
+        }
+    }
+
+    free(queue.items);
+    free(flags);
+    return true;
+}
+
+bool egit_cgraph_descendant_of(
+    const egit_cgraph *graph, uint32_t commit, uint32_t ancestor)
+{
+    // Without generation numbers, nothing can be pruned
+    uint32_t min_generation = egit_cgraph_generation(graph, ancestor);
+    if (commit == ancestor ||
+        (graph->generations && egit_cgraph_generation(graph, commit) <= min_generation))
+        return false;
+
+    uint8_t *seen = (uint8_t*) calloc(graph->num_commits / 8 + 1, 1);
+    size_t size = 0, alloc = 64;
+    uint32_t *stack = (uint32_t*) malloc(alloc * sizeof(uint32_t));
+    stack[size++] = commit;
+    bool found = false;
+
+    while (size > 0 && !found) {
+        uint32_t pos = stack[--size];
+        uint32_t nparents = egit_cgraph_parentcount(graph, pos);
+        for (uint32_t i = 0; i < nparents; i++) {
+            uint32_t parent = egit_cgraph_parent(graph, pos, i);
+            if (parent == ancestor) {
+                found = true;
+                break;
+            }
+            // Commits with a lower generation number can't reach the ancestor
+            if (seen[parent / 8] & (1 << (parent % 8)) ||
+                (graph->generations && egit_cgraph_generation(graph, parent) <= min_generation))
+                continue;
+            seen[parent / 8] |= 1 << (parent % 8);
+            if (size == alloc) {
+                alloc *= 2;
+                stack = (uint32_t*) realloc(stack, alloc * sizeof(uint32_t));
+            }
+            stack[size++] = parent;
+        }
+    }
+
+    free(stack);
+    free(seen);
+    return found;
+}
+
+#define CG_FROM_ONE 1
+#define CG_FROM_TWOS 2
+#define CG_STALE 8
+#define CG_REDUNDANT 16
+
+bool egit_cgraph_merge_bases(
+    uint32_t **out, size_t *count, const egit_cgraph *graph,
+    uint32_t one, const uint32_t *twos, size_t ntwos)
+{
+    *out = NULL;
+    *count = 0;
+
+    // As in ahead_behind, commits must be popped before their ancestors
+    if (!graph->generations)
+        return false;
+
+    for (size_t i = 0; i < ntwos; i++) {
+        if (twos[i] == one) {
+            *out = (uint32_t*) malloc(sizeof(uint32_t));
+            (*out)[(*count)++] = one;
+            return true;
+        }
+    }
+
+    uint8_t *flags = (uint8_t*) calloc(graph->num_commits, 1);
+    cg_queue queue = {graph, NULL, 0, 0};
+    size_t alloc = 4;
+    *out = (uint32_t*) malloc(alloc * sizeof(uint32_t));
+
+    // Paint commits reachable from ONE and from TWOS. A commit reachable from
+    // both is a candidate, and its ancestors are stale. The walk ends when
+    // only stale commits remain in the queue.
+    size_t nonstale = 1;
+    flags[one] = CG_FROM_ONE | CG_QUEUED;
+    cg_queue_push(&queue, one);
+    for (size_t i = 0; i < ntwos; i++) {
+        if (flags[twos[i]] & CG_QUEUED)
+            continue;
+        flags[twos[i]] = CG_FROM_TWOS | CG_QUEUED;
+        cg_queue_push(&queue, twos[i]);
+        nonstale++;
+    }
+
+    while (queue.size > 0 && nonstale > 0) {
+        uint32_t pos = cg_queue_pop(&queue);
+        uint8_t side = flags[pos] & (CG_FROM_BOTH | CG_STALE);
+        if (!(side & CG_STALE))
+            nonstale--;
+
+        if (side == CG_FROM_BOTH) {
+            if (*count == alloc) {
+                alloc *= 2;
+                *out = (uint32_t*) realloc(*out, alloc * sizeof(uint32_t));
+            }
+            (*out)[(*count)++] = pos;
+            side |= CG_STALE;
+        }
+
+        uint32_t nparents = egit_cgraph_parentcount(graph, pos);
+        for (uint32_t i = 0; i < nparents; i++) {
+            uint32_t parent = egit_cgraph_parent(graph, pos, i);
+            uint8_t old = flags[parent];
+            if ((old & side) == side)
+                continue;
+            flags[parent] |= side | CG_QUEUED;
+
+            // Commits are popped in generation order, so a queued parent
+            // has not been popped yet
+            if (!(old & CG_QUEUED)) {
+                cg_queue_push(&queue, parent);
+                if (!(side & CG_STALE))
+                    nonstale++;
+            }
+            else if (!(old & CG_STALE) && (side & CG_STALE))
+                nonstale--;
+        }
+    }
+
+    // A candidate may still be an ancestor of another, if the walk reached
+    // it first through a commit that was not yet stale
+    for (size_t i = 0; i < *count; i++) {
+        for (size_t j = 0; j < *count; j++) {
+            if (i != j && !(flags[(*out)[j]] & CG_REDUNDANT) &&
+                egit_cgraph_descendant_of(graph, (*out)[j], (*out)[i])) {
+                flags[(*out)[i]] |= CG_REDUNDANT;
+                break;
+            }
+        }
+    }
+
+    // Keep the rest newest first, like libgit2. There are rarely more than
+    // a few, so insertion sort will do.
+    size_t n = 0;
+    for (size_t i = 0; i < *count; i++) {
+        if (flags[(*out)[i]] & CG_REDUNDANT)
+            continue;
+        uint32_t pos = (*out)[i];
+        size_t j = n++;
+        while (j > 0 && egit_cgraph_time(graph, (*out)[j - 1]) < egit_cgraph_time(graph, pos)) {
+            (*out)[j] = (*out)[j - 1];
+            j--;
+        }
+        (*out)[j] = pos;
+    }
+    *count = n;
+
+    free(queue.items);
+    free(flags);
+    return true;
+}
+
+/**
+ * This follows the incremental topological walk in git: one walk counts
+ * in-degrees in generation order, and only as far as needed, while the other
+ * emits commits whose in-degree has dropped to zero. A commit's in-degree is
+ * final once the first walk has passed below its generation number.
+ */
+struct egit_cgraph_topo {
+    const egit_cgraph *graph;
+
+    // Zero means not yet visited, otherwise one more than the in-degree
+    uint32_t *indegree;
+    cg_queue indegree_queue;
+
+    uint32_t *stack;
+    size_t size, alloc;
+};
+
+static void cg_topo_push(egit_cgraph_topo *topo, uint32_t pos)
+{
+    if (topo->size == topo->alloc) {
+        topo->alloc = topo->alloc ? 2 * topo->alloc : 64;
+        topo->stack = (uint32_t*) realloc(topo->stack, topo->alloc * sizeof(uint32_t));
+    }
+    topo->stack[topo->size++] = pos;
+}
+
+static void cg_topo_compute_indegree(egit_cgraph_topo *topo, uint32_t generation)
+{
+    const egit_cgraph *graph = topo->graph;
+    cg_queue *queue = &topo->indegree_queue;
+
+    while (queue->size > 0 &&
+           egit_cgraph_generation(graph, cg_queue_peek(queue)) >= generation) {
+        uint32_t pos = cg_queue_pop(queue);
+        uint32_t nparents = egit_cgraph_parentcount(graph, pos);
+        for (uint32_t i = 0; i < nparents; i++) {
+            uint32_t parent = egit_cgraph_parent(graph, pos, i);
+            if (topo->indegree[parent] == 0) {
+                topo->indegree[parent] = 1;
+                cg_queue_push(queue, parent);
+            }
+            topo->indegree[parent]++;
+        }
+    }
+}
+
+egit_cgraph_topo *egit_cgraph_topo_new(
+    const egit_cgraph *graph, const uint32_t *starts, size_t nstarts)
+{
+    egit_cgraph_topo *topo = (egit_cgraph_topo*) calloc(1, sizeof(egit_cgraph_topo));
+    topo->graph = graph;
+    topo->indegree = (uint32_t*) calloc(graph->num_commits ? graph->num_commits : 1, sizeof(uint32_t));
+    topo->indegree_queue.graph = graph;
+
+    uint32_t min_generation = CG_GENERATION_MAX;
+    for (size_t i = 0; i < nstarts; i++) {
+        if (topo->indegree[starts[i]] != 0)
+            continue;
+        topo->indegree[starts[i]] = 1;
+        cg_queue_push(&topo->indegree_queue, starts[i]);
+        uint32_t generation = egit_cgraph_generation(graph, starts[i]);
+        if (generation < min_generation)
+            min_generation = generation;
+    }
+    cg_topo_compute_indegree(topo, min_generation);
+
+    // Push in reverse so that the first start commit is emitted first
+    for (size_t i = nstarts; i > 0; i--) {
+        uint32_t pos = starts[i - 1];
+        if (topo->indegree[pos] == 1) {
+            topo->indegree[pos] = UINT32_MAX;
+            cg_topo_push(topo, pos);
+        }
+    }
+
+    return topo;
+}
+
+bool egit_cgraph_topo_next(uint32_t *out, egit_cgraph_topo *topo)
+{
+    if (topo->size == 0)
+        return false;
+
+    const egit_cgraph *graph = topo->graph;
+    uint32_t pos = topo->stack[--topo->size];
+
+    // Push parents in reverse so that the first parent is emitted first
+    uint32_t nparents = egit_cgraph_parentcount(graph, pos);
+    for (uint32_t i = nparents; i > 0; i--) {
+        uint32_t parent = egit_cgraph_parent(graph, pos, i - 1);
+        cg_topo_compute_indegree(topo, egit_cgraph_generation(graph, parent));
+        if (topo->indegree[parent] == UINT32_MAX)
+            continue;
+        if (--topo->indegree[parent] == 1) {
+            topo->indegree[parent] = UINT32_MAX;
+            cg_topo_push(topo, parent);
+        }
+    }
+
+    *out = pos;
+    return true;
+}
+
+void egit_cgraph_topo_free(egit_cgraph_topo *topo)
+{
+    free(topo->indegree);
+    free(topo->indegree_queue.items);
+    free(topo->stack);
+    free(topo);
+}
+
+
+// =============================================================================
+// Helpers - writing
+
+typedef struct {
+    git_oid oid;
+    git_oid tree;
+    int64_t time;
+    uint32_t generation;
+    size_t parents;
+    uint32_t nparents;
+} cg_write_commit;
+
+typedef struct {
+    cg_write_commit *commits;
+    size_t ncommits, commits_alloc;
+
+    // Parent IDs while collecting, resolved to positions after sorting
+    git_oid *parent_ids;
+    uint32_t *parent_pos;
+    size_t nparents, parents_alloc;
+} cg_writer;
+
+static int cg_oid_cmp(const void *a, const void *b)
+{
+    return git_oid_cmp(&((const cg_write_commit*) a)->oid, &((const cg_write_commit*) b)->oid);
+}
+
+static int cg_collect(cg_writer *w, git_repository *repo)
+{
+    git_revwalk *walk;
+    int retval = git_revwalk_new(&walk, repo);
+    if (retval < 0)
+        return retval;
+
+    retval = git_revwalk_push_glob(walk, "refs/*");
+    if (retval == 0) {
+        retval = git_revwalk_push_head(walk);
+        if (retval == GIT_ENOTFOUND || retval == GIT_EUNBORNBRANCH) {
+            giterr_clear();
+            retval = 0;
+        }
+    }
+
+    git_oid oid;
+    while (retval == 0 && (retval = git_revwalk_next(&oid, walk)) == 0) {
+        git_commit *commit;
+        if ((retval = git_commit_lookup(&commit, repo, &oid)) < 0)
+            break;
+
+        if (w->ncommits == w->commits_alloc) {
+            w->commits_alloc = w->commits_alloc ? 2 * w->commits_alloc : 1024;
+            w->commits = (cg_write_commit*) realloc(w->commits, w->commits_alloc * sizeof(cg_write_commit));
+        }
+        cg_write_commit *c = &w->commits[w->ncommits++];
+        git_oid_cpy(&c->oid, &oid);
+        git_oid_cpy(&c->tree, git_commit_tree_id(commit));
+        c->time = git_commit_time(commit);
+        c->generation = 0;
+        c->parents = w->nparents;
+        c->nparents = git_commit_parentcount(commit);
+
+        for (uint32_t i = 0; i < c->nparents; i++) {
+            if (w->nparents == w->parents_alloc) {
+                w->parents_alloc = w->parents_alloc ? 2 * w->parents_alloc : 1024;
+                w->parent_ids = (git_oid*) realloc(w->parent_ids, w->parents_alloc * sizeof(git_oid));
+            }
+            git_oid_cpy(&w->parent_ids[w->nparents++], git_commit_parent_id(commit, i));
+        }
+        git_commit_free(commit);
+    }
+
+    git_revwalk_free(walk);
+    return retval == GIT_ITEROVER ? 0 : retval;
+}
+
+static int cg_resolve(cg_writer *w)
+{
+    qsort(w->commits, w->ncommits, sizeof(cg_write_commit), cg_oid_cmp);
+
+    w->parent_pos = (uint32_t*) malloc((w->nparents ? w->nparents : 1) * sizeof(uint32_t));
+    for (size_t i = 0; i < w->nparents; i++) {
+        cg_write_commit key;
+        git_oid_cpy(&key.oid, &w->parent_ids[i]);
+        cg_write_commit *found = (cg_write_commit*) bsearch(
+            &key, w->commits, w->ncommits, sizeof(cg_write_commit), cg_oid_cmp);
+        if (!found) {
+            giterr_set_str(GITERR_INVALID, "commit-graph: parent commit not reachable from any reference");
+            return -1;
+        }
+        w->parent_pos[i] = (uint32_t) (found - w->commits);
+    }
+
+    // Generation numbers, computed depth-first without recursion
+    size_t size = 0, alloc = 64;
+    uint32_t *stack = (uint32_t*) malloc(alloc * sizeof(uint32_t));
+    for (size_t start = 0; start < w->ncommits; start++) {
+        if (w->commits[start].generation)
+            continue;
+        stack[size++] = (uint32_t) start;
+
+        while (size > 0) {
+            cg_write_commit *c = &w->commits[stack[size - 1]];
+            uint32_t generation = 0;
+            bool ready = true;
+            for (uint32_t i = 0; i < c->nparents; i++) {
+                cg_write_commit *p = &w->commits[w->parent_pos[c->parents + i]];
+                if (!p->generation) {
+                    ready = false;
+                    if (size == alloc) {
+                        alloc *= 2;
+                        stack = (uint32_t*) realloc(stack, alloc * sizeof(uint32_t));
+                    }
+                    stack[size++] = w->parent_pos[c->parents + i];
+                }
+                else if (p->generation > generation)
+                    generation = p->generation;
+            }
+            if (ready) {
+                c->generation = generation < CG_GENERATION_MAX ? generation + 1 : CG_GENERATION_MAX;
+                size--;
+            }
+        }
+    }
+    free(stack);
+
+    return 0;
+}
+
+static void cg_serialize(unsigned char **out, size_t *len, const cg_writer *w)
+{
+    uint32_t n = (uint32_t) w->ncommits;
+
+    size_t nedges = 0;
+    for (uint32_t i = 0; i < n; i++)
+        if (w->commits[i].nparents > 2)
+            nedges += w->commits[i].nparents - 1;
+
+    uint8_t nchunks = nedges ? 4 : 3;
+    size_t offset = CG_HEADER_SIZE + (nchunks + 1) * CG_CHUNK_ENTRY_SIZE;
+    size_t size = offset + CG_FANOUT_SIZE + (size_t) n * (GIT_OID_RAWSZ + CG_CDAT_SIZE)
+        + nedges * 4 + GIT_OID_RAWSZ;
+    unsigned char *data = (unsigned char*) calloc(size, 1);
+
+    cg_put_be32(data, CG_SIGNATURE);
+    data[4] = CG_VERSION;
+    data[5] = CG_HASH_VERSION;
+    data[6] = nchunks;
+    data[7] = 0;
+
+    uint32_t ids[4] = {CG_CHUNK_OIDF, CG_CHUNK_OIDL, CG_CHUNK_CDAT, CG_CHUNK_EDGE};
+    size_t sizes[4] = {CG_FANOUT_SIZE, (size_t) n * GIT_OID_RAWSZ, (size_t) n * CG_CDAT_SIZE, nedges * 4};
+    size_t starts[4];
+    unsigned char *table = data + CG_HEADER_SIZE;
+    for (uint8_t i = 0; i < nchunks; i++) {
+        starts[i] = offset;
+        cg_put_be32(table + i * CG_CHUNK_ENTRY_SIZE, ids[i]);
+        cg_put_be64(table + i * CG_CHUNK_ENTRY_SIZE + 4, offset);
+        offset += sizes[i];
+    }
+    cg_put_be32(table + nchunks * CG_CHUNK_ENTRY_SIZE, 0);
+    cg_put_be64(table + nchunks * CG_CHUNK_ENTRY_SIZE + 4, offset);
+
+    unsigned char *fanout = data + starts[0];
+    uint32_t count = 0;
+    for (int b = 0; b < 256; b++) {
+        while (count < n && w->commits[count].oid.id[0] == b)
+            count++;
+        cg_put_be32(fanout + 4 * b, count);
+    }
+
+    unsigned char *oids = data + starts[1];
+    unsigned char *cdat = data + starts[2];
+    unsigned char *edges = nedges ? data + starts[3] : NULL;
+    uint32_t edge = 0;
+
+    for (uint32_t i = 0; i < n; i++) {
+        const cg_write_commit *c = &w->commits[i];
+        const uint32_t *parents = &w->parent_pos[c->parents];
+        memcpy(oids + (size_t) i * GIT_OID_RAWSZ, c->oid.id, GIT_OID_RAWSZ);
+
+        unsigned char *entry = cdat + (size_t) i * CG_CDAT_SIZE;
+        memcpy(entry, c->tree.id, GIT_OID_RAWSZ);
+        cg_put_be32(entry + GIT_OID_RAWSZ, c->nparents > 0 ? parents[0] : CG_PARENT_NONE);
+        if (c->nparents <= 2)
+            cg_put_be32(entry + GIT_OID_RAWSZ + 4, c->nparents == 2 ? parents[1] : CG_PARENT_NONE);
+        else {
+            cg_put_be32(entry + GIT_OID_RAWSZ + 4, CG_EXTRA_EDGES | edge);
+            for (uint32_t p = 1; p < c->nparents; p++, edge++)
+                cg_put_be32(edges + 4 * edge, parents[p] | (p == c->nparents - 1 ? CG_EDGE_LAST : 0));
+        }
+
+        uint64_t time = c->time < 0 ? 0 : (uint64_t) c->time;
+        cg_put_be32(entry + GIT_OID_RAWSZ + 8, (c->generation << 2) | (uint32_t) ((time >> 32) & 0x3));
+        cg_put_be32(entry + GIT_OID_RAWSZ + 12, (uint32_t) time);
+    }
+
+    cg_sha1(data + size - GIT_OID_RAWSZ, data, size - GIT_OID_RAWSZ);
+    *out = data;
+    *len = size;
+}
+
+static int cg_write_file(const char *path, const unsigned char *data, size_t len)
+{
+    size_t lock_len = strlen(path) + strlen(".lock") + 1;
+    char *lock = (char*) malloc(lock_len);
+    snprintf(lock, lock_len, "%s.lock", path);
+
+    // Like git, fail rather than write over a lock held by someone else
+    int fd = open(lock, O_WRONLY | O_CREAT | O_EXCL | O_BINARY, 0444);
+    if (fd < 0) {
+        bool locked = errno == EEXIST;
+        giterr_set_str(GITERR_OS, locked ?
+                       "commit-graph: lock file exists, another process may be writing" :
+                       "commit-graph: failed to create lock file");
+        free(lock);
+        return locked ? GIT_ELOCKED : -1;
+    }
+
+    FILE *file = fdopen(fd, "wb");
+    if (!file) {
+        close(fd);
+        remove(lock);
+        giterr_set_str(GITERR_OS, "commit-graph: failed to create lock file");
+        free(lock);
+        return -1;
+    }
+
+    bool ok = fwrite(data, 1, len, file) == len;
+    ok = (fclose(file) == 0) && ok;
+
+#ifdef _WIN32
+    // Windows can't rename over an existing file
+    if (ok)
+        remove(path);
+#endif
+    ok = ok && rename(lock, path) == 0;
+
+    if (!ok) {
+        remove(lock);
+        giterr_set_str(GITERR_OS, "commit-graph: failed to write file");
+    }
+    free(lock);
+    return ok ? 0 : -1;
+}
+
+static int cg_write(size_t *count, git_repository *repo)
+{
+    char *path = cg_path(repo);
+    if (!path) {
+        giterr_set_str(GITERR_REPOSITORY, "commit-graph: repository has no object directory");
+        return -1;
+    }
+
+    cg_writer w;
+    memset(&w, 0, sizeof(cg_writer));
+
+    int retval = cg_collect(&w, repo);
+    if (retval == 0)
+        retval = cg_resolve(&w);
+    if (retval == 0) {
+        unsigned char *data;
+        size_t len;
+        cg_serialize(&data, &len, &w);
+        retval = cg_write_file(path, data, len);
+        free(data);
+    }
+
+    *count = w.ncommits;
+    free(w.commits);
+    free(w.parent_ids);
+    free(w.parent_pos);
+    free(path);
+    return retval;
+}
+
+
+// =============================================================================
+// Commit-graph
+
+EGIT_DOC(commit_graph_write, "REPO",
+         "Write a commit-graph file for all commits reachable from references in REPO.\n"
+         "The file is compatible with `git commit-graph write', and speeds up\n"
+         "ancestry queries such as `libgit-graph-ahead-behind' and\n"
+         "`libgit-graph-descendant-p'. Commits created after the file is written\n"
+         "are handled without it, so it should be rewritten from time to time.\n"
+         "Return the number of commits written.");
+emacs_value egit_commit_graph_write(emacs_env *env, emacs_value _repo)
+{
+    EGIT_ASSERT_REPOSITORY(_repo);
+    git_repository *repo = EGIT_EXTRACT(_repo);
+
+    size_t count;
+    int retval = cg_write(&count, repo);
+    EGIT_CHECK_ERROR(retval);
+    return EM_INTEGER(count);
+}
+
+EGIT_DOC(commit_graph_generation, "REPO ID",
+         "Return the generation number of the commit with ID in the commit-graph of REPO.\n"
+         "Return nil if REPO has no commit-graph, the commit is not in it, or\n"
+         "the commit-graph has no generation numbers.");
+emacs_value egit_commit_graph_generation(emacs_env *env, emacs_value _repo, emacs_value _id)
+{
+    EGIT_ASSERT_REPOSITORY(_repo);
+    EM_ASSERT_STRING(_id);
+
+    git_oid oid;
+    EGIT_EXTRACT_OID(_id, oid);
+    git_repository *repo = EGIT_EXTRACT(_repo);
+
+    egit_cgraph *graph = egit_cgraph_get(repo);
+    uint32_t pos;
+    if (!graph || !egit_cgraph_find(graph, &oid, &pos))
+        return esym_nil;
+    uint32_t generation = egit_cgraph_generation(graph, pos);
+    return generation ? EM_INTEGER(generation) : esym_nil;
+}
+
+EGIT_DOC(commit_graph_topo_order, "REPO IDS &optional LIMIT",
+         "Return a vector of the commits reachable from IDS in topological order.\n"
+         "If LIMIT is non-nil, return at most that many commits. With a\n"
+         "commit-graph, only as much history as needed for LIMIT commits is\n"
+         "visited. Without one, this falls back to a topological revision walk.");
+emacs_value egit_commit_graph_topo_order(
+    emacs_env *env, emacs_value _repo, emacs_value _ids, emacs_value _limit)
+{
+    EGIT_ASSERT_REPOSITORY(_repo);
+    ptrdiff_t nids = em_assert_list(env, esym_stringp, _ids);
+    if (nids < 0)
+        return esym_nil;
+    intmax_t limit = -1;
+    if (EM_EXTRACT_BOOLEAN(_limit)) {
+        EM_ASSERT_INTEGER(_limit);
+        limit = EM_EXTRACT_INTEGER(_limit);
+    }
+
+    git_repository *repo = EGIT_EXTRACT(_repo);
+    git_oid *oids = (git_oid*) malloc((nids ? nids : 1) * sizeof(git_oid));
+    for (ptrdiff_t i = 0; i < nids; i++) {
+        char *oid_s = EM_EXTRACT_STRING(em_car(env, _ids));
+        int retval = git_oid_fromstrp(&oids[i], oid_s);
+        free(oid_s);
+        if (retval < 0) {
+            free(oids);
+            EGIT_CHECK_ERROR(retval);
+        }
+        _ids = em_cdr(env, _ids);
+    }
+
+    egit_cgraph *graph = egit_cgraph_get(repo);
+    uint32_t *starts = (uint32_t*) malloc((nids ? nids : 1) * sizeof(uint32_t));
+    bool use_graph = graph != NULL;
+    for (ptrdiff_t i = 0; use_graph && i < nids; i++)
+        use_graph = egit_cgraph_find(graph, &oids[i], &starts[i]);
+
+    size_t count = 0, alloc = 256;
+    emacs_value *result = (emacs_value*) malloc(alloc * sizeof(emacs_value));
+    int retval = 0;
+
+    if (use_graph) {
+        egit_cgraph_topo *topo = egit_cgraph_topo_new(graph, starts, nids);
+        uint32_t pos;
+        while ((limit < 0 || (intmax_t) count < limit) && egit_cgraph_topo_next(&pos, topo)) {
+            if (count == alloc) {
+                alloc *= 2;
+                result = (emacs_value*) realloc(result, alloc * sizeof(emacs_value));
+            }
+            const char *oid_s = git_oid_tostr_s(egit_cgraph_oid(graph, pos));
+            result[count++] = EM_STRING(oid_s);
+        }
+        egit_cgraph_topo_free(topo);
+    }
+    else {
+        git_revwalk *walk;
+        retval = git_revwalk_new(&walk, repo);
+        if (retval == 0) {
+            git_revwalk_sorting(walk, GIT_SORT_TOPOLOGICAL);
+            for (ptrdiff_t i = 0; retval == 0 && i < nids; i++)
+                retval = git_revwalk_push(walk, &oids[i]);
+
+            git_oid oid;
+            while (retval == 0 && (limit < 0 || (intmax_t) count < limit) &&
+                   (retval = git_revwalk_next(&oid, walk)) == 0) {
+                if (count == alloc) {
+                    alloc *= 2;
+                    result = (emacs_value*) realloc(result, alloc * sizeof(emacs_value));
+                }
+                const char *oid_s = git_oid_tostr_s(&oid);
+                result[count++] = EM_STRING(oid_s);
+            }
+            if (retval == GIT_ITEROVER)
+                retval = 0;
+            git_revwalk_free(walk);
+        }
+    }
+
+    free(starts);
+    free(oids);
+    if (retval < 0) {
+        free(result);
+        EGIT_CHECK_ERROR(retval);
+    }
+
+    emacs_value ret = em_vector(env, result, count);
+    free(result);
+    return ret;
+}
@@ -0,0 +1,96 @@
+#include <stdint.h>
+
+#include "git2.h"
+
+#include "egit.h"
+
+#ifndef EGIT_COMMIT_GRAPH_H
+#define EGIT_COMMIT_GRAPH_H
+
+/**
+ * A commit-graph file, as written by `git commit-graph write'.
+ * Commits are identified by their position in the file, which is the index
+ * of their OID in sorted order.
+ */
+typedef struct egit_cgraph egit_cgraph;
+
+/**
+ * Return the commit-graph of a repository, or NULL if there is none.
+ * The file is read on first use and cached, and re-read if it changes on disk.
+ * The returned graph is owned by the cache and must not be freed.
+ * @param repo The repository.
+ * @return The commit-graph, or NULL if the repository has no valid commit-graph file.
+ */
+egit_cgraph *egit_cgraph_get(git_repository *repo);
+
+/**
+ * Find the position of a commit in the commit-graph.
+ * @param graph The commit-graph.
+ * @param oid The commit ID.
+ * @param pos Where to store the position.
+ * @return True iff the commit is in the graph.
+ */
+bool egit_cgraph_find(const egit_cgraph *graph, const git_oid *oid, uint32_t *pos);
+
+uint32_t egit_cgraph_count(const egit_cgraph *graph);
+const git_oid *egit_cgraph_oid(const egit_cgraph *graph, uint32_t pos);
+/**
+ * Return the generation number of a commit, or zero if the commit-graph
+ * has no generation numbers, as when written by git before 2.19. Zero is
+ * smaller than any real generation number, so walks that stop at a
+ * generation number must check for it.
+ */
+uint32_t egit_cgraph_generation(const egit_cgraph *graph, uint32_t pos);
+int64_t egit_cgraph_time(const egit_cgraph *graph, uint32_t pos);
+uint32_t egit_cgraph_parentcount(const egit_cgraph *graph, uint32_t pos);
+uint32_t egit_cgraph_parent(const egit_cgraph *graph, uint32_t pos, uint32_t n);
+
+/**
+ * Count the commits reachable from LOCAL but not UPSTREAM, and vice versa.
+ * Like git_graph_ahead_behind, but stops walking as soon as the generation
+ * numbers show that no more unique commits can be found.
+ * @return False if the commit-graph has no generation numbers, in which
+ * case git_graph_ahead_behind must be used instead.
+ */
+bool egit_cgraph_ahead_behind(
+    size_t *ahead, size_t *behind, const egit_cgraph *graph,
+    uint32_t local, uint32_t upstream);
+
+/**
+ * Return true if COMMIT is a descendant of ANCESTOR (but not equal to it).
+ * Commits with generation numbers not greater than that of ANCESTOR are not
+ * visited, unless the commit-graph has no generation numbers.
+ */
+bool egit_cgraph_descendant_of(
+    const egit_cgraph *graph, uint32_t commit, uint32_t ancestor);
+
+/**
+ * Find the merge bases of ONE and TWOS, as git_merge_bases_many does.
+ * Commits are visited in generation order, so the walk stops as soon as
+ * only ancestors of known merge bases remain.
+ * @param out Where to store the merge bases, newest first. Must be freed.
+ * @param count Where to store the number of merge bases.
+ * @return False if the commit-graph has no generation numbers, in which
+ * case git_merge_bases_many must be used instead.
+ */
+bool egit_cgraph_merge_bases(
+    uint32_t **out, size_t *count, const egit_cgraph *graph,
+    uint32_t one, const uint32_t *twos, size_t ntwos);
+
+/**
+ * Iterator over commits in topological order (children before parents).
+ * Only as much of the graph as needed is visited, using generation numbers
+ * to decide when a commit can no longer gain children.
+ */
+typedef struct egit_cgraph_topo egit_cgraph_topo;
+
+egit_cgraph_topo *egit_cgraph_topo_new(
+    const egit_cgraph *graph, const uint32_t *starts, size_t nstarts);
+bool egit_cgraph_topo_next(uint32_t *pos, egit_cgraph_topo *topo);
+void egit_cgraph_topo_free(egit_cgraph_topo *topo);
+
+EGIT_DEFUN(commit_graph_write, emacs_value _repo);
+EGIT_DEFUN(commit_graph_generation, emacs_value _repo, emacs_value _id);
+EGIT_DEFUN(commit_graph_topo_order, emacs_value _repo, emacs_value _ids, emacs_value _limit);
+
+#endif /* EGIT_COMMIT_GRAPH_H */
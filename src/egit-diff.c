@@ -382,6 +382,25 @@ emacs_value egit_diff_tree_to_workdir_with_index(
     FINALIZE_AND_RETURN();
 }
 
+EGIT_DOC(diff_from_buffer, "CONTENT",
+         "Create a diff by parsing CONTENT, a string with patch text.\n"
+         "The result can be passed to `libgit-apply', but has no\n"
+         "repository associated with it.");
+emacs_value egit_diff_from_buffer(emacs_env *env, emacs_value content)
+{
+    EM_ASSERT_STRING(content);
+
+    ptrdiff_t size;
+    char *buf = em_get_string_with_size(env, content, &size);
+
+    git_diff *diff;
+    int retval = git_diff_from_buffer(&diff, buf, size);
+    free(buf);
+    EGIT_CHECK_ERROR(retval);
+
+    return egit_wrap(env, EGIT_DIFF, diff, NULL);
+}
+
 #undef MAYBE_GET
 #undef PARSE_OPTIONS
 #undef FINALIZE_AND_RETURN
@@ -15,6 +15,7 @@ EGIT_DEFUN(diff_tree_to_workdir, emacs_value _repo, emacs_value _old_tree,
            emacs_value _opts);
 EGIT_DEFUN(diff_tree_to_workdir_with_index, emacs_value _repo,
            emacs_value _old_tree, emacs_value _opts);
+EGIT_DEFUN(diff_from_buffer, emacs_value content);
 
 EGIT_DEFUN(diff_foreach, emacs_value _diff, emacs_value file_cb,
            emacs_value binary_cb, emacs_value hunk_cb, emacs_value line_cb);
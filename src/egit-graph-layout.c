@@ -0,0 +1,411 @@
+#include <string.h>
+
+#include "git2.h"
+
+#include "egit.h"
+#include "interface.h"
+#include "egit-commit-graph.h"
+#include "egit-graph-layout.h"
+
+
+// =============================================================================
+// Helpers - layout state
+
+/**
+ * State of a graph layout between pages: the commit each lane is waiting for,
+ * from left to right. A commit may be expected by several lanes, which then
+ * merge into it when it is reached.
+ */
+struct egit_layout {
+    git_oid *lanes;
+    size_t nlanes, alloc;
+};
+
+typedef enum {
+    LAYOUT_PASS,
+    LAYOUT_MERGE_IN,
+    LAYOUT_FORK_OUT
+} layout_edge_kind;
+
+typedef struct {
+    layout_edge_kind kind;
+    size_t from, to;
+} layout_edge;
+
+/**
+ * Scratch buffers reused for every commit in a page.
+ */
+typedef struct {
+    git_oid *parents;
+    size_t nparents, parents_alloc;
+    git_oid *below;
+    layout_edge *edges;
+    size_t nedges, alloc;
+} layout_scratch;
+
+void egit_layout_free(egit_layout *layout)
+{
+    if (!layout)
+        return;
+    free(layout->lanes);
+    free(layout);
+}
+
+static void layout_scratch_reserve(layout_scratch *s, size_t nlanes, size_t nparents)
+{
+    if (nparents > s->parents_alloc) {
+        s->parents_alloc = nparents;
+        s->parents = (git_oid*) realloc(s->parents, nparents * sizeof(git_oid));
+    }
+
+    // Each lane above gives one edge, and each parent gives at most one lane and one edge
+    size_t needed = nlanes + nparents + 1;
+    if (needed > s->alloc) {
+        s->alloc = needed;
+        s->below = (git_oid*) realloc(s->below, needed * sizeof(git_oid));
+        s->edges = (layout_edge*) realloc(s->edges, needed * sizeof(layout_edge));
+    }
+}
+
+static void layout_scratch_dispose(layout_scratch *s)
+{
+    free(s->parents);
+    free(s->below);
+    free(s->edges);
+}
+
+/**
+ * Read the parents of the commit OID into the scratch buffer.
+ * The commit-graph is used if the commit is in it, otherwise the commit is looked up.
+ */
+static int layout_parents(
+    layout_scratch *s, git_repository *repo, const egit_cgraph *graph, const git_oid *oid)
+{
+    uint32_t pos;
+    if (graph && egit_cgraph_find(graph, oid, &pos)) {
+        uint32_t nparents = egit_cgraph_parentcount(graph, pos);
+        layout_scratch_reserve(s, 0, nparents);
+        for (uint32_t i = 0; i < nparents; i++)
+            git_oid_cpy(&s->parents[i], egit_cgraph_oid(graph, egit_cgraph_parent(graph, pos, i)));
+        s->nparents = nparents;
+        return 0;
+    }
+
+    git_commit *commit;
+    int retval = git_commit_lookup(&commit, repo, oid);
+    if (retval < 0)
+        return retval;
+
+    unsigned int nparents = git_commit_parentcount(commit);
+    layout_scratch_reserve(s, 0, nparents);
+    for (unsigned int i = 0; i < nparents; i++)
+        git_oid_cpy(&s->parents[i], git_commit_parent_id(commit, i));
+    s->nparents = nparents;
+
+    git_commit_free(commit);
+    return 0;
+}
+
+static void layout_add_edge(layout_scratch *s, layout_edge_kind kind, size_t from, size_t to)
+{
+    s->edges[s->nedges++] = (layout_edge) {kind, from, to};
+}
+
+
+// =============================================================================
+// Helpers - lane assignment
+
+/**
+ * Place the commit OID, whose parents are in the scratch buffer, and advance
+ * the lanes past it. Return the column of the commit; the edges are left in
+ * the scratch buffer.
+ *
+ * The commit takes the leftmost lane waiting for it, or a new lane on the
+ * right if there is none. Other lanes waiting for it merge in. The first
+ * parent continues in the commit's lane, and further parents join a lane
+ * already waiting for them or open new lanes just right of it. Lanes are
+ * kept packed, so passing lanes shift left when a lane closes.
+ */
+static size_t layout_step(egit_layout *layout, layout_scratch *s, const git_oid *oid)
+{
+    size_t nabove = layout->nlanes;
+    layout_scratch_reserve(s, nabove, s->nparents);
+    s->nedges = 0;
+
+    size_t col = nabove;
+    for (size_t i = 0; i < nabove; i++) {
+        if (git_oid_equal(&layout->lanes[i], oid)) {
+            col = i;
+            break;
+        }
+    }
+
+    // Lanes below the commit, with the first parent in the commit's position
+    size_t nbelow = 0, first = 0;
+    for (size_t i = 0; i <= nabove; i++) {
+        if (i == col && s->nparents > 0) {
+            first = nbelow;
+            git_oid_cpy(&s->below[nbelow++], &s->parents[0]);
+        }
+        if (i == nabove)
+            break;
+        if (git_oid_equal(&layout->lanes[i], oid))
+            layout_add_edge(s, LAYOUT_MERGE_IN, i, col);
+        else {
+            layout_add_edge(s, LAYOUT_PASS, i, nbelow);
+            git_oid_cpy(&s->below[nbelow++], &layout->lanes[i]);
+        }
+    }
+    if (s->nparents > 0)
+        layout_add_edge(s, LAYOUT_FORK_OUT, col, first);
+
+    // Further parents join an existing lane or get a new one
+    size_t insert = first + 1;
+    for (size_t p = 1; p < s->nparents; p++) {
+        size_t j = 0;
+        while (j < nbelow && !git_oid_equal(&s->below[j], &s->parents[p]))
+            j++;
+
+        if (j == nbelow) {
+            j = insert++;
+            memmove(&s->below[j + 1], &s->below[j], (nbelow - j) * sizeof(git_oid));
+            git_oid_cpy(&s->below[j], &s->parents[p]);
+            nbelow++;
+            for (size_t e = 0; e < s->nedges; e++)
+                if (s->edges[e].kind != LAYOUT_MERGE_IN && s->edges[e].to >= j)
+                    s->edges[e].to++;
+        }
+        layout_add_edge(s, LAYOUT_FORK_OUT, col, j);
+    }
+
+    if (nbelow > layout->alloc) {
+        layout->alloc = nbelow * 2;
+        layout->lanes = (git_oid*) realloc(layout->lanes, layout->alloc * sizeof(git_oid));
+    }
+    memcpy(layout->lanes, s->below, nbelow * sizeof(git_oid));
+    layout->nlanes = nbelow;
+
+    return col;
+}
+
+/**
+ * Convert a placed commit to a row of the form (ID COLUMN EDGES).
+ */
+static emacs_value layout_row(emacs_env *env, const layout_scratch *s, const git_oid *oid, size_t col)
+{
+    emacs_value edges = esym_nil;
+    for (size_t e = s->nedges; e > 0; e--) {
+        const layout_edge *edge = &s->edges[e - 1];
+        emacs_value edge_v;
+        switch (edge->kind) {
+        case LAYOUT_PASS:
+            edge_v = em_list(env, (emacs_value[]) {
+                    esym_pass, EM_INTEGER(edge->from), EM_INTEGER(edge->to)}, 3);
+            break;
+        case LAYOUT_MERGE_IN:
+            edge_v = em_list(env, (emacs_value[]) {esym_merge_in, EM_INTEGER(edge->from)}, 2);
+            break;
+        default:
+            edge_v = em_list(env, (emacs_value[]) {esym_fork_out, EM_INTEGER(edge->to)}, 2);
+            break;
+        }
+        edges = em_cons(env, edge_v, edges);
+    }
+
+    const char *oid_s = git_oid_tostr_s(oid);
+    return em_list(env, (emacs_value[]) {EM_STRING(oid_s), EM_INTEGER(col), edges}, 3);
+}
+
+/**
+ * Lay out a sequence of commits, appending rows to *rows.
+ * Commits are produced by NEXT until it returns GIT_ITEROVER or MAX rows are done.
+ */
+typedef int (*layout_source)(git_oid *out, void *payload);
+
+static int layout_run(
+    emacs_env *env, emacs_value **rows, size_t *nrows, egit_layout *layout,
+    git_repository *repo, layout_source next, void *payload, intmax_t max)
+{
+    const egit_cgraph *graph = egit_cgraph_get(repo);
+    layout_scratch s = {0};
+    size_t alloc = 64;
+    *rows = (emacs_value*) malloc(alloc * sizeof(emacs_value));
+    *nrows = 0;
+
+    int retval = 0;
+    git_oid oid;
+    while ((intmax_t) *nrows < max && (retval = next(&oid, payload)) == 0) {
+        retval = layout_parents(&s, repo, graph, &oid);
+        if (retval < 0)
+            break;
+        size_t col = layout_step(layout, &s, &oid);
+
+        if (*nrows == alloc) {
+            alloc *= 2;
+            *rows = (emacs_value*) realloc(*rows, alloc * sizeof(emacs_value));
+        }
+        (*rows)[(*nrows)++] = layout_row(env, &s, &oid, col);
+    }
+
+    layout_scratch_dispose(&s);
+    if (retval == GIT_ITEROVER)
+        retval = 0;
+    if (retval < 0) {
+        free(*rows);
+        *rows = NULL;
+    }
+    return retval;
+}
+
+static int layout_next_revwalk(git_oid *out, void *payload)
+{
+    return git_revwalk_next(out, (git_revwalk*) payload);
+}
+
+typedef struct {
+    git_oid *oids;
+    size_t count, pos;
+} layout_oid_list;
+
+static int layout_next_oid(git_oid *out, void *payload)
+{
+    layout_oid_list *list = (layout_oid_list*) payload;
+    if (list->pos == list->count)
+        return GIT_ITEROVER;
+    git_oid_cpy(out, &list->oids[list->pos++]);
+    return 0;
+}
+
+
+// =============================================================================
+// Constructors
+
+EGIT_DOC(graph_layout_new, "SOURCE",
+         "Create a new graph layout for drawing a commit graph next to a log.\n"
+         "SOURCE is either a revwalk, from which `libgit-graph-layout-next'\n"
+         "pulls commits, or a repository, in which case commits are given\n"
+         "explicitly with `libgit-graph-layout-add'. The layout keeps its lanes\n"
+         "between calls, so a long log can be laid out a page at a time.");
+emacs_value egit_graph_layout_new(emacs_env *env, emacs_value _source)
+{
+    egit_type type = egit_get_type(env, _source);
+    if (type != EGIT_REVWALK && type != EGIT_REPOSITORY) {
+        em_signal_wrong_type(env, esym_libgit_revwalk_p, _source);
+        return esym_nil;
+    }
+
+    egit_layout *layout = (egit_layout*) calloc(1, sizeof(egit_layout));
+    return egit_wrap(env, EGIT_GRAPH_LAYOUT, layout, EM_EXTRACT_USER_PTR(_source));
+}
+
+
+// =============================================================================
+// Layout
+
+/**
+ * Return the repository a layout draws commits from.
+ */
+static git_repository *layout_repository(egit_object *source)
+{
+    if (source->type == EGIT_REVWALK)
+        return git_revwalk_repository(source->ptr);
+    return source->ptr;
+}
+
+EGIT_DOC(graph_layout_next, "LAYOUT N",
+         "Lay out the next N commits from the revwalk of LAYOUT.\n"
+         "Return a vector of rows, one per commit, which is shorter than N if\n"
+         "the walk is exhausted. Each row has the form (ID COLUMN EDGES), where\n"
+         "COLUMN is the zero-based lane of the commit and EDGES is a list of\n"
+         "line segments through the row, each of one of the forms\n\n"
+         "- (pass FROM TO): a lane passes the commit, from column FROM above it\n"
+         "  to column TO below it\n"
+         "- (merge-in FROM): the lane in column FROM above ends in the commit\n"
+         "- (fork-out TO): a line leaves the commit for a parent in column TO\n"
+         "  below it, one for each parent\n\n"
+         "The revwalk is not reset, so subsequent calls continue where the\n"
+         "previous one left off. Lanes waiting for parents that never appear in\n"
+         "the walk, for example because they are hidden, stay open.");
+emacs_value egit_graph_layout_next(emacs_env *env, emacs_value _layout, emacs_value _n)
+{
+    EGIT_ASSERT_GRAPH_LAYOUT(_layout);
+    EM_ASSERT_INTEGER(_n);
+
+    egit_object *source = EGIT_EXTRACT_PARENT(_layout);
+    if (source->type != EGIT_REVWALK) {
+        em_signal_wrong_value(env, _layout);
+        return esym_nil;
+    }
+    intmax_t n = EM_EXTRACT_INTEGER(_n);
+    if (n < 0) {
+        em_signal_args_out_of_range(env, n);
+        return esym_nil;
+    }
+
+    egit_layout *layout = EGIT_EXTRACT(_layout);
+    emacs_value *rows;
+    size_t nrows;
+    int retval = layout_run(env, &rows, &nrows, layout, layout_repository(source),
+                            layout_next_revwalk, source->ptr, n);
+    EGIT_CHECK_ERROR(retval);
+
+    emacs_value ret = em_vector(env, rows, nrows);
+    free(rows);
+    return ret;
+}
+
+EGIT_DOC(graph_layout_add, "LAYOUT IDS",
+         "Lay out the commits with IDS, a list of commit IDs, in order.\n"
+         "The commits should come in an order where children precede their\n"
+         "parents, like that of a revwalk. Return a vector of rows as described\n"
+         "in `libgit-graph-layout-next'. This works with any layout, so a\n"
+         "sequence of commits obtained elsewhere may be laid out as well.");
+emacs_value egit_graph_layout_add(emacs_env *env, emacs_value _layout, emacs_value _ids)
+{
+    EGIT_ASSERT_GRAPH_LAYOUT(_layout);
+    ptrdiff_t nids = em_assert_list(env, esym_stringp, _ids);
+    if (nids < 0)
+        return esym_nil;
+
+    layout_oid_list list = {NULL, 0, 0};
+    list.oids = (git_oid*) malloc((nids ? nids : 1) * sizeof(git_oid));
+    for (; list.count < (size_t) nids; list.count++) {
+        char *oid_s = EM_EXTRACT_STRING(em_car(env, _ids));
+        int retval = git_oid_fromstrp(&list.oids[list.count], oid_s);
+        free(oid_s);
+        if (retval < 0) {
+            free(list.oids);
+            EGIT_CHECK_ERROR(retval);
+        }
+        _ids = em_cdr(env, _ids);
+    }
+
+    egit_layout *layout = EGIT_EXTRACT(_layout);
+    egit_object *source = EGIT_EXTRACT_PARENT(_layout);
+    emacs_value *rows;
+    size_t nrows;
+    int retval = layout_run(env, &rows, &nrows, layout, layout_repository(source),
+                            layout_next_oid, &list, nids);
+    free(list.oids);
+    EGIT_CHECK_ERROR(retval);
+
+    emacs_value ret = em_vector(env, rows, nrows);
+    free(rows);
+    return ret;
+}
+
+EGIT_DOC(graph_layout_lanes, "LAYOUT",
+         "Return a list of the commit IDs that the open lanes of LAYOUT wait for.\n"
+         "The list is ordered by column, and a commit may appear more than once.");
+emacs_value egit_graph_layout_lanes(emacs_env *env, emacs_value _layout)
+{
+    EGIT_ASSERT_GRAPH_LAYOUT(_layout);
+    egit_layout *layout = EGIT_EXTRACT(_layout);
+
+    emacs_value ret = esym_nil;
+    for (size_t i = layout->nlanes; i > 0; i--) {
+        const char *oid_s = git_oid_tostr_s(&layout->lanes[i - 1]);
+        ret = em_cons(env, EM_STRING(oid_s), ret);
+    }
+    return ret;
+}
@@ -0,0 +1,22 @@
+#include "egit.h"
+
+#ifndef EGIT_GRAPH_LAYOUT_H
+#define EGIT_GRAPH_LAYOUT_H
+
+/**
+ * Lane state of a commit graph layout, kept between pages.
+ */
+typedef struct egit_layout egit_layout;
+
+/**
+ * Free a graph layout.
+ * @param layout The layout.
+ */
+void egit_layout_free(egit_layout *layout);
+
+EGIT_DEFUN(graph_layout_new, emacs_value _source);
+EGIT_DEFUN(graph_layout_next, emacs_value _layout, emacs_value _n);
+EGIT_DEFUN(graph_layout_add, emacs_value _layout, emacs_value _ids);
+EGIT_DEFUN(graph_layout_lanes, emacs_value _layout);
+
+#endif /* EGIT_GRAPH_LAYOUT_H */
@@ -4,6 +4,7 @@
 
 #include "egit.h"
 #include "interface.h"
+#include "egit-commit-graph.h"
 #include "egit-graph.h"
 
 
@@ -24,8 +25,14 @@ emacs_value egit_graph_ahead_behind(
     git_repository *repo = EGIT_EXTRACT(_repo);
 
     size_t ahead, behind;
-    int retval = git_graph_ahead_behind(&ahead, &behind, repo, &local, &upstream);
-    EGIT_CHECK_ERROR(retval);
+    egit_cgraph *graph = egit_cgraph_get(repo);
+    uint32_t local_pos, upstream_pos;
+    if (!graph || !egit_cgraph_find(graph, &local, &local_pos) ||
+        !egit_cgraph_find(graph, &upstream, &upstream_pos) ||
+        !egit_cgraph_ahead_behind(&ahead, &behind, graph, local_pos, upstream_pos)) {
+        int retval = git_graph_ahead_behind(&ahead, &behind, repo, &local, &upstream);
+        EGIT_CHECK_ERROR(retval);
+    }
 
     return em_cons(env, EM_INTEGER(ahead), EM_INTEGER(behind));
 }
@@ -44,6 +51,12 @@ emacs_value egit_graph_descendant_p(
     EGIT_EXTRACT_OID(_ancestor, ancestor);
     git_repository *repo = EGIT_EXTRACT(_repo);
 
+    egit_cgraph *graph = egit_cgraph_get(repo);
+    uint32_t commit_pos, ancestor_pos;
+    if (graph && egit_cgraph_find(graph, &commit, &commit_pos) &&
+        egit_cgraph_find(graph, &ancestor, &ancestor_pos))
+        return egit_cgraph_descendant_of(graph, commit_pos, ancestor_pos) ? esym_t : esym_nil;
+
     int retval = git_graph_descendant_of(repo, &commit, &ancestor);
     EGIT_CHECK_ERROR(retval);
     return retval ? esym_t : esym_nil;
@@ -1,12 +1,87 @@
+#include <limits.h>
+#include <stdio.h>
 #include <string.h>
+#include <sys/stat.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
 
 #include "git2.h"
 
 #include "egit.h"
+#include "egit-pool.h"
 #include "egit-util.h"
 #include "interface.h"
 #include "egit-index.h"
 
+#ifdef _WIN32
+#define lstat stat
+#define S_ISLNK(mode) 0
+#endif
+
+#if defined(_WIN32)
+#define ST_CTIME_NSEC(st) 0
+#define ST_MTIME_NSEC(st) 0
+#elif defined(__APPLE__)
+#define ST_CTIME_NSEC(st) ((st)->st_ctimespec.tv_nsec)
+#define ST_MTIME_NSEC(st) ((st)->st_mtimespec.tv_nsec)
+#else
+#define ST_CTIME_NSEC(st) ((st)->st_ctim.tv_nsec)
+#define ST_MTIME_NSEC(st) ((st)->st_mtim.tv_nsec)
+#endif
+
+
+// =============================================================================
+// Helpers
+
+/**
+ * Return the repository of the index _INDEX. In-memory indexes have no owner,
+ * but their wrapper keeps the repository they were created for as parent.
+ */
+static git_repository *index_repository(emacs_env *env, emacs_value _index)
+{
+    git_repository *repo = git_index_owner(EGIT_EXTRACT(_index));
+    if (!repo) {
+        egit_object *parent = EGIT_EXTRACT_PARENT(_index);
+        if (parent)
+            repo = parent->ptr;
+    }
+    return repo;
+}
+
+
+// =============================================================================
+// Constructors
+
+EGIT_DOC(index_new, "REPO &optional TREE",
+         "Create a new index in memory, for use with REPO.\n"
+         "The index has no file on disk, so it can't be written with\n"
+         "`libgit-index-write' or read with `libgit-index-read'. Trees are\n"
+         "written to REPO with `libgit-index-write-tree', and blobs added with\n"
+         "`libgit-index-add-frombuffer' are written to REPO.\n\n"
+         "If TREE is non-nil, fill the index with its contents.");
+emacs_value egit_index_new(emacs_env *env, emacs_value _repo, emacs_value _tree)
+{
+    EGIT_ASSERT_REPOSITORY(_repo);
+    if (EM_EXTRACT_BOOLEAN(_tree))
+        EGIT_ASSERT_TREE(_tree);
+
+    git_index *index;
+    int retval = git_index_new(&index);
+    EGIT_CHECK_ERROR(retval);
+
+    if (EM_EXTRACT_BOOLEAN(_tree)) {
+        retval = git_index_read_tree(index, EGIT_EXTRACT(_tree));
+        if (retval < 0) {
+            git_index_free(index);
+            EGIT_CHECK_ERROR(retval);
+        }
+    }
+
+    return egit_wrap(env, EGIT_INDEX, index, EM_EXTRACT_USER_PTR(_repo));
+}
+
 
 // =============================================================================
 // Getters
@@ -127,6 +202,81 @@ emacs_value egit_index_entry_stage(emacs_env *env, emacs_value _entry)
     return em_findenum_stage(stage);
 }
 
+EGIT_DOC(index_entries, "INDEX &optional PREFIX",
+         "Return the entries of INDEX as a vector of records.\n"
+         "Each record is a vector [PATH ID MODE STAGE FLAGS FILE-SIZE MTIME],\n"
+         "where MODE is a symbol as in `libgit-tree-entry-byindex', STAGE is as\n"
+         "in `libgit-index-entry-stage', FLAGS is a list of the symbols\n"
+         "`assume-valid', `intent-to-add' and `skip-worktree', and MTIME is a\n"
+         "cons cell (SECONDS . NANOSECONDS).\n\n"
+         "If PREFIX is non-nil, only list the entries in that directory. The\n"
+         "first of them is found by binary search, so this is fast even for\n"
+         "large indexes.");
+emacs_value egit_index_entries(emacs_env *env, emacs_value _index, emacs_value _prefix)
+{
+    EGIT_ASSERT_INDEX(_index);
+    EM_ASSERT_STRING_OR_NIL(_prefix);
+    git_index *index = EGIT_EXTRACT(_index);
+
+    // Directory prefixes always end with a slash, so "dir" doesn't match "dirx"
+    char *prefix = NULL;
+    size_t prefix_len = 0;
+    size_t start = 0;
+    if (EM_EXTRACT_BOOLEAN(_prefix)) {
+        char *dir = EM_EXTRACT_STRING(_prefix);
+        prefix_len = strlen(dir);
+        prefix = (char*) malloc(prefix_len + 2);
+        memcpy(prefix, dir, prefix_len + 1);
+        free(dir);
+        if (prefix_len > 0 && prefix[prefix_len - 1] != '/') {
+            prefix[prefix_len++] = '/';
+            prefix[prefix_len] = '\0';
+        }
+
+        if (prefix_len > 0 && git_index_find_prefix(&start, index, prefix) < 0) {
+            giterr_clear();
+            free(prefix);
+            return em_vector(env, NULL, 0);
+        }
+    }
+
+    size_t count = git_index_entrycount(index);
+    size_t alloc = prefix_len ? 64 : (count ? count : 1);
+    emacs_value *values = (emacs_value*) malloc(alloc * sizeof(emacs_value));
+    size_t nvalues = 0;
+    bool quit = false;
+
+    for (size_t i = start; i < count; i++) {
+        const git_index_entry *entry = git_index_get_byindex(index, i);
+        if (prefix_len && strncmp(entry->path, prefix, prefix_len) != 0)
+            break;
+        if (nvalues % 4096 == 4095 && (quit = em_should_quit(env)))
+            break;
+
+        emacs_value record[7];
+        record[0] = EM_STRING(entry->path);
+        record[1] = EM_STRING(git_oid_tostr_s(&entry->id));
+        record[2] = em_findenum_filemode(entry->mode);
+        record[3] = em_findenum_stage(git_index_entry_stage(entry));
+        record[4] = em_getlist_idxentry(
+            env, (entry->flags & GIT_IDXENTRY_VALID) | entry->flags_extended);
+        record[5] = EM_INTEGER(entry->file_size);
+        record[6] = em_cons(env, EM_INTEGER(entry->mtime.seconds),
+                            EM_INTEGER(entry->mtime.nanoseconds));
+
+        if (nvalues == alloc) {
+            alloc *= 2;
+            values = (emacs_value*) realloc(values, alloc * sizeof(emacs_value));
+        }
+        values[nvalues++] = em_vector(env, record, 7);
+    }
+
+    emacs_value ret = quit ? esym_nil : em_vector(env, values, nvalues);
+    free(values);
+    free(prefix);
+    return ret;
+}
+
 EGIT_DOC(index_entrycount, "INDEX", "Get the number of entries in INDEX.");
 emacs_value egit_index_entrycount(emacs_env *env, emacs_value _index)
 {
@@ -288,6 +438,48 @@ emacs_value egit_index_add_all(
     return esym_nil;
 }
 
+EGIT_DOC(index_add_frombuffer, "INDEX PATH CONTENT &optional MODE",
+         "Add or update an entry in INDEX with the given CONTENT.\n"
+         "CONTENT is a string, written as a blob to the repository of INDEX.\n"
+         "MODE is a file mode symbol as in `libgit-tree-entry-byindex', by\n"
+         "default `blob'. The file system is not touched.");
+emacs_value egit_index_add_frombuffer(
+    emacs_env *env, emacs_value _index, emacs_value _path, emacs_value _content, emacs_value _mode)
+{
+    EGIT_ASSERT_INDEX(_index);
+    EM_ASSERT_STRING(_path);
+    EM_ASSERT_STRING(_content);
+
+    git_filemode_t mode = GIT_FILEMODE_BLOB;
+    if (EM_EXTRACT_BOOLEAN(_mode) && !em_findsym_filemode(&mode, env, _mode, true))
+        return esym_nil;
+
+    git_index *index = EGIT_EXTRACT(_index);
+    git_repository *repo = index_repository(env, _index);
+    if (!repo) {
+        em_signal(env, esym_giterr, "Index is not associated with a repository");
+        return esym_nil;
+    }
+
+    ptrdiff_t size;
+    char *content = em_get_string_with_size(env, _content, &size);
+    git_index_entry entry;
+    memset(&entry, 0, sizeof(git_index_entry));
+    int retval = git_blob_create_frombuffer(&entry.id, repo, content, size);
+    free(content);
+    EGIT_CHECK_ERROR(retval);
+
+    char *path = EM_EXTRACT_STRING(_path);
+    entry.path = path;
+    entry.mode = mode;
+    entry.file_size = (uint32_t) size;
+    retval = git_index_add(index, &entry);
+    free(path);
+    EGIT_CHECK_ERROR(retval);
+
+    return esym_nil;
+}
+
 EGIT_DOC(index_add_bypath, "INDEX PATH",
          "Add or update an entry in INDEX from a file on disk.\n"
          "Note: this does not obey ignore rules.");
@@ -315,6 +507,39 @@ emacs_value egit_index_clear(emacs_env *env, emacs_value _index)
     return esym_nil;
 }
 
+EGIT_DOC(index_read_tree, "INDEX TREE",
+         "Replace the contents of INDEX with the contents of TREE.");
+emacs_value egit_index_read_tree(emacs_env *env, emacs_value _index, emacs_value _tree)
+{
+    EGIT_ASSERT_INDEX(_index);
+    EGIT_ASSERT_TREE(_tree);
+    git_index *index = EGIT_EXTRACT(_index);
+    git_tree *tree = EGIT_EXTRACT(_tree);
+    int retval = git_index_read_tree(index, tree);
+    EGIT_CHECK_ERROR(retval);
+    return esym_nil;
+}
+
+EGIT_DOC(index_remove, "INDEX PATH &optional STAGE",
+         "Remove the entry for PATH from INDEX.\n"
+         "STAGE is as in `libgit-index-get-bypath'.");
+emacs_value egit_index_remove(emacs_env *env, emacs_value _index, emacs_value _path, emacs_value _stage)
+{
+    EGIT_ASSERT_INDEX(_index);
+    EM_ASSERT_STRING(_path);
+
+    int stage;
+    if (!em_findsym_stage(&stage, env, _stage, true))
+        return esym_nil;
+
+    git_index *index = EGIT_EXTRACT(_index);
+    char *path = EM_EXTRACT_STRING(_path);
+    int retval = git_index_remove(index, path, stage);
+    free(path);
+    EGIT_CHECK_ERROR(retval);
+    return esym_nil;
+}
+
 EGIT_DOC(index_read, "INDEX &optional FORCE",
          "Update INDEX by reading from disk.\n"
          "If FORCE is non-nil, update even if no apparent changes are made.");
@@ -339,7 +564,9 @@ emacs_value egit_index_write(emacs_env *env, emacs_value _index)
 
 EGIT_DOC(index_write_tree, "INDEX &optional REPO",
          "Write the index to a tree and return the ID.\n"
-         "If REPO is non-nil, write to that repository.");
+         "If REPO is non-nil, write to that repository. Otherwise, write to\n"
+         "the repository of INDEX, which for an in-memory index is the one it\n"
+         "was created for.");
 emacs_value egit_index_write_tree(emacs_env *env, emacs_value _index, emacs_value _repo)
 {
     EGIT_ASSERT_INDEX(_index);
@@ -348,6 +575,8 @@ emacs_value egit_index_write_tree(emacs_env *env, emacs_value _index, emacs_valu
 
     git_index *index = EGIT_EXTRACT(_index);
     git_repository *repo = EGIT_EXTRACT_OR_NULL(_repo);
+    if (!repo && !git_index_owner(index))
+        repo = index_repository(env, _index);
 
     git_oid oid;
     int retval = repo ? git_index_write_tree_to(&oid, index, repo)
@@ -356,3 +585,559 @@ emacs_value egit_index_write_tree(emacs_env *env, emacs_value _index, emacs_valu
     const char *oid_s = git_oid_tostr_s(&oid);
     return EM_STRING(oid_s);
 }
+
+
+// =============================================================================
+// Batch add
+
+typedef struct {
+    const char *repo_path;
+    const char *workdir;
+    char **paths;
+    struct stat *stats;
+    git_oid *ids;
+    bool dry_run;
+} index_batch_ctx;
+
+static int index_batch_init(void **state, void *payload)
+{
+    index_batch_ctx *ctx = (index_batch_ctx*) payload;
+    git_repository *repo;
+    int retval = git_repository_open(&repo, ctx->repo_path);
+    *state = repo;
+    return retval;
+}
+
+static void index_batch_free(void *state, void *payload)
+{
+    (void) payload;
+    git_repository_free((git_repository*) state);
+}
+
+/**
+ * Hash a symbolic link without writing it, as git_blob_create_fromworkdir would.
+ */
+static int index_batch_hash_link(git_oid *id, const char *fullpath, const struct stat *st)
+{
+#ifndef _WIN32
+    char *target = (char*) malloc(st->st_size + 1);
+    ssize_t len = readlink(fullpath, target, st->st_size + 1);
+    if (len < 0 || len > st->st_size) {
+        free(target);
+        giterr_set_str(GITERR_OS, "Failed to read symbolic link");
+        return -1;
+    }
+    int retval = git_odb_hash(id, target, len, GIT_OBJ_BLOB);
+    free(target);
+    return retval;
+#else
+    (void) id; (void) fullpath; (void) st;
+    giterr_set_str(GITERR_INVALID, "Symbolic links are not supported");
+    return -1;
+#endif
+}
+
+static int index_batch_task(size_t index, void *state, void *payload)
+{
+    git_repository *repo = (git_repository*) state;
+    index_batch_ctx *ctx = (index_batch_ctx*) payload;
+    const char *path = ctx->paths[index];
+
+    size_t fullpath_len = strlen(ctx->workdir) + strlen(path) + 1;
+    char *fullpath = (char*) malloc(fullpath_len);
+    snprintf(fullpath, fullpath_len, "%s%s", ctx->workdir, path);
+
+    int retval = 0;
+    struct stat *st = &ctx->stats[index];
+    if (lstat(fullpath, st) < 0 || S_ISDIR(st->st_mode)) {
+        char msg[256];
+        snprintf(msg, sizeof(msg), "Cannot add '%.200s': %s", path,
+                 S_ISDIR(st->st_mode) ? "it is a directory" : "file not found");
+        giterr_set_str(GITERR_INDEX, msg);
+        retval = -1;
+    }
+
+    // Blobs are streamed from disk unless filters need the whole contents
+    else if (ctx->dry_run && S_ISLNK(st->st_mode))
+        retval = index_batch_hash_link(&ctx->ids[index], fullpath, st);
+    else if (ctx->dry_run)
+        retval = git_repository_hashfile(&ctx->ids[index], repo, fullpath, GIT_OBJ_BLOB, path);
+    else
+        retval = git_blob_create_fromworkdir(&ctx->ids[index], repo, path);
+
+    free(fullpath);
+    return retval;
+}
+
+/**
+ * Return the index mode for a file, keeping the existing mode where the
+ * index capabilities say the file system can't be trusted. Like libgit2,
+ * new regular files are not executable when the file mode is distrusted.
+ */
+static uint32_t index_batch_mode(git_index *index, const char *path, const struct stat *st)
+{
+    uint32_t mode = S_ISLNK(st->st_mode) ? GIT_FILEMODE_LINK :
+        (st->st_mode & 0100) ? GIT_FILEMODE_BLOB_EXECUTABLE : GIT_FILEMODE_BLOB;
+    if (mode == GIT_FILEMODE_LINK)
+        return mode;
+
+    int caps = git_index_caps(index);
+    const git_index_entry *existing = git_index_get_bypath(index, path, 0);
+    if ((caps & GIT_INDEXCAP_NO_SYMLINKS) && existing && existing->mode == GIT_FILEMODE_LINK)
+        return existing->mode;
+    if (caps & GIT_INDEXCAP_NO_FILEMODE)
+        return existing && existing->mode != GIT_FILEMODE_LINK ? existing->mode : GIT_FILEMODE_BLOB;
+    return mode;
+}
+
+EGIT_DOC(index_add_paths, "INDEX PATHS &optional DRY-RUN",
+         "Add or update entries in INDEX from the files at PATHS on disk.\n"
+         "PATHS is a list of paths relative to the working directory. The\n"
+         "files are read, filtered and written to the object database on a\n"
+         "pool of threads, after which INDEX is updated and, if it has a file\n"
+         "on disk, written once.\n\n"
+         "Return a vector of the blob IDs, in the same order as PATHS.\n"
+         "If DRY-RUN is non-nil, only compute the IDs: nothing is written to\n"
+         "the object database or to INDEX.\n\n"
+         "Like `libgit-index-add-bypath', this does not obey ignore rules.");
+emacs_value egit_index_add_paths(emacs_env *env, emacs_value _index, emacs_value _paths, emacs_value dry_run)
+{
+    EGIT_ASSERT_INDEX(_index);
+    git_index *index = EGIT_EXTRACT(_index);
+
+    git_repository *repo = index_repository(env, _index);
+    const char *workdir = repo ? git_repository_workdir(repo) : NULL;
+    if (!workdir) {
+        em_signal(env, esym_giterr, "Cannot add files to an index without a working directory");
+        return esym_nil;
+    }
+
+    git_strarray paths;
+    if (!egit_strarray_from_list(&paths, env, _paths))
+        return esym_nil;
+    size_t count = paths.count;
+
+    index_batch_ctx ctx;
+    ctx.repo_path = git_repository_path(repo);
+    ctx.workdir = workdir;
+    ctx.paths = paths.strings;
+    ctx.stats = (struct stat*) calloc(count ? count : 1, sizeof(struct stat));
+    ctx.ids = (git_oid*) calloc(count ? count : 1, sizeof(git_oid));
+    ctx.dry_run = EM_EXTRACT_BOOLEAN(dry_run);
+
+    int retval = 0;
+    if (count > 0) {
+        egit_pool *pool = egit_pool_new(count < egit_pool_default_size() ? count : 0,
+                                        index_batch_init, index_batch_task, index_batch_free, &ctx);
+        retval = egit_pool_run(pool, count);
+        egit_pool_free(pool);
+    }
+
+    // Only touch the index once every file has been hashed
+    for (size_t i = 0; retval == 0 && !ctx.dry_run && i < count; i++) {
+        const struct stat *st = &ctx.stats[i];
+        git_index_entry entry;
+        memset(&entry, 0, sizeof(git_index_entry));
+        entry.path = paths.strings[i];
+        git_oid_cpy(&entry.id, &ctx.ids[i]);
+        entry.mode = index_batch_mode(index, entry.path, st);
+        entry.file_size = (uint32_t) st->st_size;
+        entry.ctime.seconds = (int32_t) st->st_ctime;
+        entry.ctime.nanoseconds = (uint32_t) ST_CTIME_NSEC(st);
+        entry.mtime.seconds = (int32_t) st->st_mtime;
+        entry.mtime.nanoseconds = (uint32_t) ST_MTIME_NSEC(st);
+        entry.dev = st->st_dev;
+        entry.ino = st->st_ino;
+        entry.uid = st->st_uid;
+        entry.gid = st->st_gid;
+        retval = git_index_add(index, &entry);
+    }
+    if (retval == 0 && !ctx.dry_run && count > 0 && git_index_path(index))
+        retval = git_index_write(index);
+
+    emacs_value ret = esym_nil;
+    if (retval == 0) {
+        emacs_value *values = (emacs_value*) malloc((count ? count : 1) * sizeof(emacs_value));
+        for (size_t i = 0; i < count; i++)
+            values[i] = EM_STRING(git_oid_tostr_s(&ctx.ids[i]));
+        ret = em_vector(env, values, count);
+        free(values);
+    }
+
+    free(ctx.ids);
+    free(ctx.stats);
+    egit_strarray_dispose(&paths);
+
+    EGIT_CHECK_ERROR(retval);
+    return ret;
+}
+
+
+// =============================================================================
+// Line staging
+
+typedef struct {
+    char origin;
+    intmax_t start, end;
+} index_line_range;
+
+typedef struct {
+    char *ptr;
+    size_t size, alloc;
+} index_linebuf;
+
+static void index_linebuf_put(index_linebuf *buf, const char *data, size_t len)
+{
+    if (buf->size + len > buf->alloc) {
+        while (buf->size + len > buf->alloc)
+            buf->alloc = buf->alloc ? 2 * buf->alloc : 4096;
+        buf->ptr = (char*) realloc(buf->ptr, buf->alloc);
+    }
+    memcpy(buf->ptr + buf->size, data, len);
+    buf->size += len;
+}
+
+/**
+ * Append a line to BUF. If the previous line had no newline (it was the last
+ * line of a file without a trailing newline), one is inserted first.
+ */
+static void index_linebuf_put_line(index_linebuf *buf, const char *data, size_t len)
+{
+    if (buf->size > 0 && buf->ptr[buf->size - 1] != '\n')
+        index_linebuf_put(buf, "\n", 1);
+    index_linebuf_put(buf, data, len);
+}
+
+/**
+ * Parse a list of line ranges (ORIGIN START END) into an array.
+ * Returns false and signals an error on invalid input.
+ */
+static bool index_line_ranges_parse(
+    index_line_range **out, size_t *nranges, emacs_env *env, emacs_value list)
+{
+    *nranges = 0;
+    *out = NULL;
+
+    ptrdiff_t len = em_assert_list(env, esym_nil, list);
+    if (len < 0)
+        return false;
+    if (len == 0)
+        return true;
+
+    index_line_range *ranges = (index_line_range*) malloc(len * sizeof(index_line_range));
+    for (ptrdiff_t i = 0; i < len; i++) {
+        emacs_value elem = em_car(env, list);
+        list = em_cdr(env, list);
+
+        ptrdiff_t elem_len = em_assert_list(env, esym_nil, elem);
+        if (elem_len != 3) {
+            if (elem_len >= 0)
+                em_signal_wrong_value(env, elem);
+            free(ranges);
+            return false;
+        }
+        emacs_value origin = em_car(env, elem);
+        emacs_value start = em_car(env, em_cdr(env, elem));
+        emacs_value end = em_car(env, em_cdr(env, em_cdr(env, elem)));
+        if (!em_assert(env, esym_integerp, origin) ||
+            !em_assert(env, esym_integerp, start) ||
+            !em_assert(env, esym_integerp, end)) {
+            free(ranges);
+            return false;
+        }
+
+        ranges[i].origin = (char) EM_EXTRACT_INTEGER(origin);
+        ranges[i].start = EM_EXTRACT_INTEGER(start);
+        ranges[i].end = EM_EXTRACT_INTEGER(end);
+        if (ranges[i].origin != GIT_DIFF_LINE_ADDITION && ranges[i].origin != GIT_DIFF_LINE_DELETION) {
+            em_signal_wrong_value(env, origin);
+            free(ranges);
+            return false;
+        }
+    }
+
+    *out = ranges;
+    *nranges = len;
+    return true;
+}
+
+static bool index_line_selected(const git_diff_line *line, index_line_range *ranges, size_t nranges)
+{
+    int lineno = line->origin == GIT_DIFF_LINE_ADDITION ? line->new_lineno : line->old_lineno;
+    for (size_t i = 0; i < nranges; i++)
+        if (ranges[i].origin == line->origin && ranges[i].start <= lineno && lineno <= ranges[i].end)
+            return true;
+    return false;
+}
+
+/**
+ * Copy lines from *POS in the base buffer to OUT until *LINENO reaches UNTIL.
+ * With SKIP, advance past one more line without copying it.
+ */
+static void index_copy_base(
+    index_linebuf *out, const char **pos, const char *end,
+    int *lineno, int until, bool skip)
+{
+    while (*pos < end && *lineno < until) {
+        const char *nl = memchr(*pos, '\n', end - *pos);
+        const char *eol = nl ? nl + 1 : end;
+        index_linebuf_put_line(out, *pos, eol - *pos);
+        *pos = eol;
+        (*lineno)++;
+    }
+    if (skip && *pos < end) {
+        const char *nl = memchr(*pos, '\n', end - *pos);
+        *pos = nl ? nl + 1 : end;
+        (*lineno)++;
+    }
+}
+
+/**
+ * Synthesise new content from the diff between OLD and NEW, selecting only the
+ * changed lines in RANGES. Without REVERSE, the result is OLD with the selected
+ * changes applied. With REVERSE, the result is NEW with the selected changes
+ * reverted. The line numbers in RANGES always refer to the diff from OLD to NEW.
+ */
+static int index_synthesize(
+    index_linebuf *out, const char *old, size_t old_len, const char *new, size_t new_len,
+    const char *path, index_line_range *ranges, size_t nranges, bool reverse)
+{
+    git_diff_options opts;
+    int retval = git_diff_init_options(&opts, GIT_DIFF_OPTIONS_VERSION);
+    if (retval < 0)
+        return retval;
+    opts.context_lines = 0;
+    opts.interhunk_lines = 0;
+
+    git_patch *patch;
+    retval = git_patch_from_buffers(&patch, old, old_len, path, new, new_len, path, &opts);
+    if (retval < 0)
+        return retval;
+
+    const char *base = reverse ? new : old;
+    const char *pos = base, *end = base + (reverse ? new_len : old_len);
+    char base_origin = reverse ? GIT_DIFF_LINE_ADDITION : GIT_DIFF_LINE_DELETION;
+    int lineno = 1;
+
+    size_t nhunks = git_patch_num_hunks(patch);
+    for (size_t h = 0; h < nhunks; h++) {
+        const git_diff_hunk *hunk;
+        size_t nlines;
+        retval = git_patch_get_hunk(&hunk, &nlines, patch, h);
+        if (retval < 0)
+            goto cleanup;
+
+        // A hunk without base lines is inserted after its start line
+        int start = reverse ? hunk->new_start : hunk->old_start;
+        int count = reverse ? hunk->new_lines : hunk->old_lines;
+        index_copy_base(out, &pos, end, &lineno, count == 0 ? start + 1 : start, false);
+
+        for (size_t l = 0; l < nlines; l++) {
+            const git_diff_line *line;
+            retval = git_patch_get_line_in_hunk(&line, patch, h, l);
+            if (retval < 0)
+                goto cleanup;
+
+            if (line->origin == base_origin) {
+                // Unselected base lines are kept right away, so that they come
+                // before any selected lines further down in the hunk
+                int base_lineno = reverse ? line->new_lineno : line->old_lineno;
+                bool selected = index_line_selected(line, ranges, nranges);
+                index_copy_base(out, &pos, end, &lineno,
+                                selected ? base_lineno : base_lineno + 1, selected);
+            }
+            else if (line->origin == GIT_DIFF_LINE_ADDITION || line->origin == GIT_DIFF_LINE_DELETION) {
+                if (index_line_selected(line, ranges, nranges))
+                    index_linebuf_put_line(out, line->content, line->content_len);
+            }
+        }
+    }
+
+    index_copy_base(out, &pos, end, &lineno, INT_MAX, false);
+
+  cleanup:
+    git_patch_free(patch);
+    return retval;
+}
+
+/**
+ * Look up the blob of PATH in the HEAD commit of REPO. If HEAD is unborn or
+ * has no such file, *out is set to NULL and zero is returned.
+ */
+static int index_head_blob(git_blob **out, git_repository *repo, const char *path)
+{
+    *out = NULL;
+
+    git_reference *head;
+    int retval = git_repository_head(&head, repo);
+    if (retval == GIT_EUNBORNBRANCH || retval == GIT_ENOTFOUND) {
+        giterr_clear();
+        return 0;
+    }
+    if (retval < 0)
+        return retval;
+
+    git_tree *tree;
+    retval = git_reference_peel((git_object**) &tree, head, GIT_OBJ_TREE);
+    git_reference_free(head);
+    if (retval < 0)
+        return retval;
+
+    git_tree_entry *entry;
+    retval = git_tree_entry_bypath(&entry, tree, path);
+    git_tree_free(tree);
+    if (retval == GIT_ENOTFOUND) {
+        giterr_clear();
+        return 0;
+    }
+    if (retval < 0)
+        return retval;
+
+    retval = git_blob_lookup(out, repo, git_tree_entry_id(entry));
+    git_tree_entry_free(entry);
+    return retval;
+}
+
+/**
+ * Write CONTENT to the object database and point the entry for PATH in INDEX at it.
+ * The mode and flags of an existing entry are kept, but like with
+ * `git update-index --cacheinfo', the stat data is cleared, since it no
+ * longer describes the work tree file.
+ */
+static int index_update_entry(
+    git_oid *oid, git_index *index, git_repository *repo,
+    const char *path, const char *content, size_t len)
+{
+    int retval = git_blob_create_frombuffer(oid, repo, content, len);
+    if (retval < 0)
+        return retval;
+
+    git_index_entry entry;
+    memset(&entry, 0, sizeof(git_index_entry));
+    entry.path = path;
+    entry.mode = GIT_FILEMODE_BLOB;
+
+    const git_index_entry *existing = git_index_get_bypath(index, path, 0);
+    if (existing) {
+        entry.mode = existing->mode;
+        entry.flags = existing->flags;
+        entry.flags_extended = existing->flags_extended;
+    }
+    git_oid_cpy(&entry.id, oid);
+
+    return git_index_add(index, &entry);
+}
+
+static emacs_value index_stage_lines(
+    emacs_env *env, emacs_value _index, emacs_value _path,
+    emacs_value _lines, emacs_value _content, bool reverse)
+{
+    EGIT_ASSERT_INDEX(_index);
+    EM_ASSERT_STRING(_path);
+    if (EM_EXTRACT_BOOLEAN(_content))
+        EM_ASSERT_STRING(_content);
+
+    git_index *index = EGIT_EXTRACT(_index);
+    git_repository *repo = git_index_owner(index);
+    if (!repo) {
+        em_signal_wrong_value(env, _index);
+        return esym_nil;
+    }
+
+    index_line_range *ranges;
+    size_t nranges;
+    if (!index_line_ranges_parse(&ranges, &nranges, env, _lines))
+        return esym_nil;
+
+    char *path = EM_EXTRACT_STRING(_path);
+    git_blob *staged = NULL, *other = NULL;
+    char *content = NULL;
+    ptrdiff_t content_len = 0;
+    index_linebuf out = {NULL, 0, 0};
+    git_oid oid;
+    int retval = 0;
+
+    const git_index_entry *entry = git_index_get_bypath(index, path, 0);
+    if (entry) {
+        retval = git_blob_lookup(&staged, repo, &entry->id);
+        if (retval < 0)
+            goto cleanup;
+    }
+
+    if (reverse) {
+        // Unstaging: the diff is from HEAD to the index
+        retval = index_head_blob(&other, repo, path);
+        if (retval < 0)
+            goto cleanup;
+    }
+    else if (EM_EXTRACT_BOOLEAN(_content))
+        content = em_get_string_with_size(env, _content, &content_len);
+    else {
+        // Read the work tree file through the filters, as `git add' would
+        git_oid workdir_oid;
+        retval = git_blob_create_fromworkdir(&workdir_oid, repo, path);
+        if (retval < 0)
+            goto cleanup;
+        retval = git_blob_lookup(&other, repo, &workdir_oid);
+        if (retval < 0)
+            goto cleanup;
+    }
+
+    const char *staged_buf = staged ? git_blob_rawcontent(staged) : "";
+    size_t staged_len = staged ? (size_t) git_blob_rawsize(staged) : 0;
+    const char *other_buf = content ? content : other ? git_blob_rawcontent(other) : "";
+    size_t other_len = content ? (size_t) content_len : other ? (size_t) git_blob_rawsize(other) : 0;
+
+    if (reverse)
+        retval = index_synthesize(&out, other_buf, other_len, staged_buf, staged_len,
+                                  path, ranges, nranges, true);
+    else
+        retval = index_synthesize(&out, staged_buf, staged_len, other_buf, other_len,
+                                  path, ranges, nranges, false);
+    if (retval < 0)
+        goto cleanup;
+
+    retval = index_update_entry(&oid, index, repo, path, out.ptr ? out.ptr : "", out.size);
+
+  cleanup:
+    free(out.ptr);
+    free(content);
+    git_blob_free(staged);
+    git_blob_free(other);
+    free(path);
+    free(ranges);
+    EGIT_CHECK_ERROR(retval);
+
+    const char *oid_s = git_oid_tostr_s(&oid);
+    return EM_STRING(oid_s);
+}
+
+EGIT_DOC(index_stage_lines, "INDEX PATH LINES &optional CONTENT",
+         "Stage the selected changed LINES of PATH in INDEX.\n"
+         "LINES is a list of ranges of the form (ORIGIN START END), where\n"
+         "ORIGIN is ?+ or ?-, and START and END are inclusive line numbers.\n"
+         "For ?+ the line numbers refer to the work tree file, and for ?- to\n"
+         "the staged file, as returned by `libgit-diff-line-lineno'.\n\n"
+         "CONTENT is the work tree content of PATH. If nil, the file is read\n"
+         "from disk, with filters applied.\n\n"
+         "A new blob is written to the object database and the entry for PATH\n"
+         "is updated in memory. Use `libgit-index-write' to save INDEX to disk.\n"
+         "Return the ID of the new blob.");
+emacs_value egit_index_stage_lines(
+    emacs_env *env, emacs_value _index, emacs_value _path,
+    emacs_value _lines, emacs_value _content)
+{
+    return index_stage_lines(env, _index, _path, _lines, _content, false);
+}
+
+EGIT_DOC(index_unstage_lines, "INDEX PATH LINES",
+         "Unstage the selected changed LINES of PATH in INDEX.\n"
+         "LINES is as in `libgit-index-stage-lines', but the line numbers refer\n"
+         "to the diff from HEAD to the index: ?+ for the staged file and ?-\n"
+         "for the file in HEAD.\n\n"
+         "Return the ID of the new blob.");
+emacs_value egit_index_unstage_lines(
+    emacs_env *env, emacs_value _index, emacs_value _path, emacs_value _lines)
+{
+    return index_stage_lines(env, _index, _path, _lines, esym_nil, true);
+}
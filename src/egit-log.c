@@ -0,0 +1,743 @@
+#include <string.h>
+
+#include "git2.h"
+
+#include "egit.h"
+#include "interface.h"
+#include "egit-log.h"
+
+
+// =============================================================================
+// Helpers - walking
+
+/**
+ * Get a revision walker from SOURCE, which may be a revwalk or a repository.
+ * In the latter case a new walker is created with the given SORT order,
+ * starting from REVSPEC (HEAD by default), and *owned is set to true. REVSPEC
+ * may be a range of the form A..B.
+ */
+static bool log_get_walker(
+    git_revwalk **out, bool *owned, emacs_env *env, emacs_value source, emacs_value _revspec,
+    git_sort_t sort)
+{
+    *owned = false;
+
+    egit_type type = egit_get_type(env, source);
+    if (type == EGIT_REVWALK) {
+        *out = EGIT_EXTRACT(source);
+        return true;
+    }
+    if (type != EGIT_REPOSITORY) {
+        em_signal_wrong_type(env, esym_libgit_repository_p, source);
+        return false;
+    }
+    if (EM_EXTRACT_BOOLEAN(_revspec) && !em_assert(env, esym_stringp, _revspec))
+        return false;
+
+    git_repository *repo = EGIT_EXTRACT(source);
+    char *revspec = NULL;
+    if (EM_EXTRACT_BOOLEAN(_revspec))
+        revspec = EM_EXTRACT_STRING(_revspec);
+
+    git_revwalk *walk;
+    int retval = git_revwalk_new(&walk, repo);
+    if (retval < 0) {
+        free(revspec);
+        egit_dispatch_error(env, retval);
+        return false;
+    }
+    git_revwalk_sorting(walk, sort);
+
+    if (revspec && strstr(revspec, ".."))
+        retval = git_revwalk_push_range(walk, revspec);
+    else {
+        git_object *obj, *commit;
+        retval = git_revparse_single(&obj, repo, revspec ? revspec : "HEAD");
+        if (retval == 0) {
+            retval = git_object_peel(&commit, obj, GIT_OBJ_COMMIT);
+            git_object_free(obj);
+        }
+        if (retval == 0) {
+            retval = git_revwalk_push(walk, git_object_id(commit));
+            git_object_free(commit);
+        }
+    }
+    free(revspec);
+
+    if (retval < 0) {
+        git_revwalk_free(walk);
+        egit_dispatch_error(env, retval);
+        return false;
+    }
+
+    *out = walk;
+    *owned = true;
+    return true;
+}
+
+/**
+ * Parse the optional OFFSET and LIMIT arguments. A nil LIMIT is returned as -1.
+ */
+static bool log_get_range(
+    intmax_t *offset, intmax_t *limit, emacs_env *env, emacs_value _offset, emacs_value _limit)
+{
+    *offset = 0;
+    *limit = -1;
+    if (EM_EXTRACT_BOOLEAN(_offset)) {
+        if (!em_assert(env, esym_integerp, _offset))
+            return false;
+        *offset = EM_EXTRACT_INTEGER(_offset);
+    }
+    if (EM_EXTRACT_BOOLEAN(_limit)) {
+        if (!em_assert(env, esym_integerp, _limit))
+            return false;
+        *limit = EM_EXTRACT_INTEGER(_limit);
+    }
+    if (*offset < 0 || (EM_EXTRACT_BOOLEAN(_limit) && *limit < 0)) {
+        em_signal_args_out_of_range(env, *offset < 0 ? *offset : *limit);
+        return false;
+    }
+    return true;
+}
+
+
+// =============================================================================
+// Helpers - columns
+
+typedef enum {
+    LOG_OID,
+    LOG_ABBREV,
+    LOG_PARENTS,
+    LOG_AUTHOR_NAME,
+    LOG_AUTHOR_EMAIL,
+    LOG_AUTHOR_TIME,
+    LOG_COMMITTER_NAME,
+    LOG_COMMITTER_EMAIL,
+    LOG_COMMITTER_TIME,
+    LOG_SUMMARY,
+    LOG_TREE
+} log_column;
+
+static bool log_columns_parse(log_column **out, ptrdiff_t *ncols, emacs_env *env, emacs_value list)
+{
+    *ncols = em_assert_list(env, esym_nil, list);
+    if (*ncols < 0)
+        return false;
+
+    log_column *columns = (log_column*) malloc((*ncols > 0 ? *ncols : 1) * sizeof(log_column));
+    for (ptrdiff_t i = 0; i < *ncols; i++) {
+        emacs_value sym = em_car(env, list);
+        list = em_cdr(env, list);
+
+        if (EM_EQ(sym, esym_oid)) columns[i] = LOG_OID;
+        else if (EM_EQ(sym, esym_abbrev)) columns[i] = LOG_ABBREV;
+        else if (EM_EQ(sym, esym_parents)) columns[i] = LOG_PARENTS;
+        else if (EM_EQ(sym, esym_author_name)) columns[i] = LOG_AUTHOR_NAME;
+        else if (EM_EQ(sym, esym_author_email)) columns[i] = LOG_AUTHOR_EMAIL;
+        else if (EM_EQ(sym, esym_author_time)) columns[i] = LOG_AUTHOR_TIME;
+        else if (EM_EQ(sym, esym_committer_name)) columns[i] = LOG_COMMITTER_NAME;
+        else if (EM_EQ(sym, esym_committer_email)) columns[i] = LOG_COMMITTER_EMAIL;
+        else if (EM_EQ(sym, esym_committer_time)) columns[i] = LOG_COMMITTER_TIME;
+        else if (EM_EQ(sym, esym_summary)) columns[i] = LOG_SUMMARY;
+        else if (EM_EQ(sym, esym_tree)) columns[i] = LOG_TREE;
+        else {
+            em_signal_wrong_value(env, sym);
+            free(columns);
+            return false;
+        }
+    }
+
+    *out = columns;
+    return true;
+}
+
+static emacs_value log_oid(emacs_env *env, const git_oid *oid)
+{
+    const char *oid_s = git_oid_tostr_s(oid);
+    return EM_STRING(oid_s);
+}
+
+/**
+ * Build a record for COMMIT, using VALUES as scratch space for the columns.
+ */
+static int log_record(
+    emacs_value *out, emacs_env *env, git_commit *commit,
+    log_column *columns, ptrdiff_t ncols, emacs_value *values)
+{
+    for (ptrdiff_t i = 0; i < ncols; i++) {
+        switch (columns[i]) {
+        case LOG_OID:
+            values[i] = log_oid(env, git_commit_id(commit));
+            break;
+        case LOG_ABBREV: {
+            git_buf buf = {NULL, 0, 0};
+            int retval = git_object_short_id(&buf, (git_object*) commit);
+            if (retval < 0)
+                return retval;
+            values[i] = EM_STRING(buf.ptr);
+            git_buf_dispose(&buf);
+            break;
+        }
+        case LOG_PARENTS: {
+            emacs_value parents = esym_nil;
+            for (unsigned int p = git_commit_parentcount(commit); p > 0; p--)
+                parents = em_cons(env, log_oid(env, git_commit_parent_id(commit, p - 1)), parents);
+            values[i] = parents;
+            break;
+        }
+        case LOG_AUTHOR_NAME:
+            values[i] = EM_STRING(git_commit_author(commit)->name);
+            break;
+        case LOG_AUTHOR_EMAIL:
+            values[i] = EM_STRING(git_commit_author(commit)->email);
+            break;
+        case LOG_AUTHOR_TIME:
+            values[i] = EM_INTEGER(git_commit_author(commit)->when.time);
+            break;
+        case LOG_COMMITTER_NAME:
+            values[i] = EM_STRING(git_commit_committer(commit)->name);
+            break;
+        case LOG_COMMITTER_EMAIL:
+            values[i] = EM_STRING(git_commit_committer(commit)->email);
+            break;
+        case LOG_COMMITTER_TIME:
+            values[i] = EM_INTEGER(git_commit_time(commit));
+            break;
+        case LOG_SUMMARY: {
+            const char *summary = git_commit_summary(commit);
+            values[i] = EM_STRING(summary ? summary : "");
+            break;
+        }
+        case LOG_TREE:
+            values[i] = log_oid(env, git_commit_tree_id(commit));
+            break;
+        }
+    }
+
+    *out = em_vector(env, values, ncols);
+    return 0;
+}
+
+
+// =============================================================================
+// Helpers - path history
+
+typedef enum {
+    LOGPATH_NONE,
+    LOGPATH_FOLLOWED,
+    LOGPATH_SKIPPED
+} logpath_state;
+
+typedef struct {
+    git_oid oid;
+    logpath_state state;
+} logpath_mark;
+
+/**
+ * Open-addressing hash table of commits reached by the walk, recording
+ * whether history simplification follows them or not.
+ */
+typedef struct {
+    logpath_mark *slots;
+    size_t size, count;
+} logpath_marks;
+
+static size_t logpath_hash(const git_oid *oid)
+{
+    size_t hash;
+    memcpy(&hash, oid->id, sizeof(hash));
+    return hash;
+}
+
+static logpath_mark *logpath_marks_find(logpath_marks *marks, const git_oid *oid)
+{
+    size_t i = logpath_hash(oid) & (marks->size - 1);
+    while (marks->slots[i].state != LOGPATH_NONE && !git_oid_equal(&marks->slots[i].oid, oid))
+        i = (i + 1) & (marks->size - 1);
+    return &marks->slots[i];
+}
+
+static void logpath_marks_init(logpath_marks *marks)
+{
+    marks->size = 1024;
+    marks->count = 0;
+    marks->slots = (logpath_mark*) calloc(marks->size, sizeof(logpath_mark));
+}
+
+static logpath_state logpath_marks_get(logpath_marks *marks, const git_oid *oid)
+{
+    return logpath_marks_find(marks, oid)->state;
+}
+
+/**
+ * Mark a commit. Followed commits stay followed, since a commit is walked if
+ * any of its children follows it.
+ */
+static void logpath_marks_set(logpath_marks *marks, const git_oid *oid, logpath_state state)
+{
+    if (2 * (marks->count + 1) > marks->size) {
+        logpath_mark *old = marks->slots;
+        size_t old_size = marks->size;
+        marks->size *= 2;
+        marks->slots = (logpath_mark*) calloc(marks->size, sizeof(logpath_mark));
+        for (size_t i = 0; i < old_size; i++)
+            if (old[i].state != LOGPATH_NONE)
+                *logpath_marks_find(marks, &old[i].oid) = old[i];
+        free(old);
+    }
+
+    logpath_mark *mark = logpath_marks_find(marks, oid);
+    if (mark->state == LOGPATH_NONE) {
+        git_oid_cpy(&mark->oid, oid);
+        marks->count++;
+    }
+    else if (mark->state == LOGPATH_FOLLOWED)
+        return;
+    mark->state = state;
+}
+
+/**
+ * Compare PATH between the trees A and B, either of which may be NULL for an
+ * empty tree. Only the subtrees along PATH are loaded, and the comparison
+ * stops at the first level where the entries are identical, or where PATH
+ * is absent on both sides.
+ */
+static int logpath_same(
+    bool *same, git_repository *repo, const git_oid *a, const git_oid *b, const char *path)
+{
+    git_oid oid_a, oid_b;
+    git_filemode_t mode_a = GIT_FILEMODE_TREE, mode_b = GIT_FILEMODE_TREE;
+    bool has_a = a != NULL, has_b = b != NULL;
+    if (has_a) git_oid_cpy(&oid_a, a);
+    if (has_b) git_oid_cpy(&oid_b, b);
+
+    char *name = (char*) malloc(strlen(path) + 1);
+    int retval = 0;
+
+    while (true) {
+        // When only one side has the entry, keep descending on that side
+        // alone, since PATH may still be absent there
+        if (!has_a && !has_b) {
+            *same = true;
+            break;
+        }
+        if (has_a && has_b && git_oid_equal(&oid_a, &oid_b) && mode_a == mode_b) {
+            *same = true;
+            break;
+        }
+
+        while (*path == '/')
+            path++;
+        if (!*path) {
+            *same = false;
+            break;
+        }
+        size_t len = strcspn(path, "/");
+        memcpy(name, path, len);
+        name[len] = '\0';
+        path += len;
+
+        for (int side = 0; side < 2; side++) {
+            bool *has = side ? &has_b : &has_a;
+            git_oid *oid = side ? &oid_b : &oid_a;
+            git_filemode_t *mode = side ? &mode_b : &mode_a;
+            if (!*has)
+                continue;
+            if (*mode != GIT_FILEMODE_TREE) {
+                *has = false;
+                continue;
+            }
+
+            git_tree *tree;
+            retval = git_tree_lookup(&tree, repo, oid);
+            if (retval < 0)
+                goto cleanup;
+            const git_tree_entry *entry = git_tree_entry_byname(tree, name);
+            *has = entry != NULL;
+            if (entry) {
+                git_oid_cpy(oid, git_tree_entry_id(entry));
+                *mode = git_tree_entry_filemode(entry);
+            }
+            git_tree_free(tree);
+        }
+    }
+
+  cleanup:
+    free(name);
+    return retval;
+}
+
+/**
+ * Return true in *same if none of the PATHS differ between the trees A and B.
+ */
+static int logpath_same_all(
+    bool *same, git_repository *repo, const git_oid *a, const git_oid *b,
+    char **paths, ptrdiff_t npaths)
+{
+    *same = true;
+    for (ptrdiff_t i = 0; *same && i < npaths; i++) {
+        int retval = logpath_same(same, repo, a, b, paths[i]);
+        if (retval < 0)
+            return retval;
+    }
+    return 0;
+}
+
+/**
+ * Decide whether COMMIT is shown in the history of PATHS, and mark the parents
+ * to follow. Like git's default history simplification, a commit is shown if
+ * it differs from all its parents along PATHS. Otherwise only the first parent
+ * it is identical to is followed.
+ */
+static int logpath_visit(
+    bool *shown, logpath_marks *marks, git_repository *repo, git_commit *commit,
+    char **paths, ptrdiff_t npaths)
+{
+    const git_oid *tree = git_commit_tree_id(commit);
+    unsigned int nparents = git_commit_parentcount(commit);
+
+    if (nparents == 0) {
+        bool empty;
+        int retval = logpath_same_all(&empty, repo, tree, NULL, paths, npaths);
+        *shown = !empty;
+        return retval;
+    }
+
+    unsigned int same_parent = nparents;
+    for (unsigned int i = 0; i < nparents && same_parent == nparents; i++) {
+        git_commit *parent;
+        int retval = git_commit_parent(&parent, commit, i);
+        if (retval < 0)
+            return retval;
+        bool same;
+        retval = logpath_same_all(&same, repo, tree, git_commit_tree_id(parent), paths, npaths);
+        git_commit_free(parent);
+        if (retval < 0)
+            return retval;
+        if (same)
+            same_parent = i;
+    }
+
+    *shown = same_parent == nparents;
+    for (unsigned int i = 0; i < nparents; i++) {
+        bool follow = *shown || i == same_parent;
+        logpath_marks_set(marks, git_commit_parent_id(commit, i),
+                          follow ? LOGPATH_FOLLOWED : LOGPATH_SKIPPED);
+    }
+    return 0;
+}
+
+/**
+ * If COMMIT adds *PATH compared to its first parent and the addition is a
+ * rename, replace *PATH with the name it had before.
+ */
+static int logpath_follow(char **path, git_repository *repo, git_commit *commit)
+{
+    if (git_commit_parentcount(commit) == 0)
+        return 0;
+
+    git_commit *parent;
+    int retval = git_commit_parent(&parent, commit, 0);
+    if (retval < 0)
+        return retval;
+
+    bool missing;
+    retval = logpath_same(&missing, repo, git_commit_tree_id(parent), NULL, *path);
+    if (retval < 0 || !missing) {
+        git_commit_free(parent);
+        return retval;
+    }
+
+    git_tree *old_tree = NULL, *new_tree = NULL;
+    git_diff *diff = NULL;
+    retval = git_commit_tree(&old_tree, parent);
+    if (retval == 0)
+        retval = git_commit_tree(&new_tree, commit);
+    if (retval == 0)
+        retval = git_diff_tree_to_tree(&diff, repo, old_tree, new_tree, NULL);
+    if (retval == 0) {
+        git_diff_find_options opts;
+        git_diff_find_init_options(&opts, GIT_DIFF_FIND_OPTIONS_VERSION);
+        opts.flags = GIT_DIFF_FIND_RENAMES;
+        retval = git_diff_find_similar(diff, &opts);
+    }
+
+    for (size_t i = 0; retval == 0 && i < git_diff_num_deltas(diff); i++) {
+        const git_diff_delta *delta = git_diff_get_delta(diff, i);
+        if (delta->status == GIT_DELTA_RENAMED && strcmp(delta->new_file.path, *path) == 0) {
+            free(*path);
+            *path = strdup(delta->old_file.path);
+            break;
+        }
+    }
+
+    git_diff_free(diff);
+    git_tree_free(new_tree);
+    git_tree_free(old_tree);
+    git_commit_free(parent);
+    return retval;
+}
+
+
+/**
+ * The state of a path walk on a revwalk, kept between calls so that the
+ * history can be listed in pages without walking it again.
+ */
+typedef struct {
+    ptrdiff_t npaths;
+    char **query;               // The paths as given, to recognize a later page
+    char **paths;               // The paths as named in the next commits
+    bool follow;
+    logpath_marks marks;
+} logpath_cursor;
+
+static void logpath_cursor_free(void *_cursor)
+{
+    logpath_cursor *cursor = (logpath_cursor*) _cursor;
+    for (ptrdiff_t i = 0; i < cursor->npaths; i++) {
+        free(cursor->query[i]);
+        free(cursor->paths[i]);
+    }
+    free(cursor->query);
+    free(cursor->paths);
+    free(cursor->marks.slots);
+    free(cursor);
+}
+
+static logpath_cursor *logpath_cursor_new(
+    emacs_env *env, emacs_value _paths, ptrdiff_t npaths, bool follow)
+{
+    logpath_cursor *cursor = (logpath_cursor*) malloc(sizeof(logpath_cursor));
+    cursor->npaths = npaths;
+    cursor->query = (char**) malloc((npaths > 0 ? npaths : 1) * sizeof(char*));
+    cursor->paths = (char**) malloc((npaths > 0 ? npaths : 1) * sizeof(char*));
+    cursor->follow = follow;
+    for (ptrdiff_t i = 0; i < npaths; i++) {
+        cursor->query[i] = EM_EXTRACT_STRING(em_car(env, _paths));
+        cursor->paths[i] = strdup(cursor->query[i]);
+        _paths = em_cdr(env, _paths);
+    }
+    logpath_marks_init(&cursor->marks);
+    return cursor;
+}
+
+/**
+ * Return true if a call with PATHS and FOLLOW continues the walk of CURSOR.
+ */
+static bool logpath_cursor_continues(
+    logpath_cursor *cursor, emacs_env *env, emacs_value _paths, ptrdiff_t npaths, bool follow)
+{
+    if (cursor->npaths != npaths || cursor->follow != follow)
+        return false;
+    for (ptrdiff_t i = 0; i < npaths; i++) {
+        char *path = EM_EXTRACT_STRING(em_car(env, _paths));
+        bool same = strcmp(path, cursor->query[i]) == 0;
+        free(path);
+        if (!same)
+            return false;
+        _paths = em_cdr(env, _paths);
+    }
+    return true;
+}
+
+
+// =============================================================================
+// Log
+
+EGIT_DOC(log, "SOURCE COLUMNS &optional OFFSET LIMIT REVSPEC",
+         "Return a vector of records for the commits in SOURCE.\n"
+         "SOURCE is either a revision walker, which is consumed from its current\n"
+         "position and not reset, or a repository. In the latter case, commits\n"
+         "reachable from REVSPEC (default HEAD) are listed in time order.\n"
+         "REVSPEC may also be a range of the form A..B.\n\n"
+         "COLUMNS is a list of symbols, and each record is a vector with the\n"
+         "corresponding values in the same order:\n"
+         "- `oid': the commit ID\n"
+         "- `abbrev': the shortest unambiguous abbreviation of the commit ID\n"
+         "- `parents': a list of parent IDs\n"
+         "- `author-name', `author-email': from the author signature\n"
+         "- `author-time': the author time, in seconds since the epoch\n"
+         "- `committer-name', `committer-email': from the committer signature\n"
+         "- `committer-time': the commit time, in seconds since the epoch\n"
+         "- `summary': the first paragraph of the message\n"
+         "- `tree': the tree ID\n\n"
+         "OFFSET commits are skipped first, and at most LIMIT records are returned.");
+emacs_value egit_log(
+    emacs_env *env, emacs_value _source, emacs_value _columns,
+    emacs_value _offset, emacs_value _limit, emacs_value _revspec)
+{
+    intmax_t offset, limit;
+    if (!log_get_range(&offset, &limit, env, _offset, _limit))
+        return esym_nil;
+
+    log_column *columns;
+    ptrdiff_t ncols;
+    if (!log_columns_parse(&columns, &ncols, env, _columns))
+        return esym_nil;
+
+    git_revwalk *walk;
+    bool owned;
+    if (!log_get_walker(&walk, &owned, env, _source, _revspec, GIT_SORT_TIME)) {
+        free(columns);
+        return esym_nil;
+    }
+    git_repository *repo = git_revwalk_repository(walk);
+
+    emacs_value *values = (emacs_value*) malloc((ncols > 0 ? ncols : 1) * sizeof(emacs_value));
+    size_t alloc = (limit >= 0 && limit < 256) ? (limit > 0 ? limit : 1) : 256, count = 0;
+    emacs_value *records = (emacs_value*) malloc(alloc * sizeof(emacs_value));
+
+    git_oid oid;
+    int retval = 0;
+    for (; offset > 0; offset--)
+        if ((retval = git_revwalk_next(&oid, walk)) < 0)
+            goto cleanup;
+
+    while (limit < 0 || (intmax_t) count < limit) {
+        if ((retval = git_revwalk_next(&oid, walk)) < 0)
+            break;
+
+        git_commit *commit;
+        if ((retval = git_commit_lookup(&commit, repo, &oid)) < 0)
+            break;
+
+        if (count == alloc) {
+            alloc *= 2;
+            records = (emacs_value*) realloc(records, alloc * sizeof(emacs_value));
+        }
+        retval = log_record(&records[count], env, commit, columns, ncols, values);
+        git_commit_free(commit);
+        if (retval < 0)
+            break;
+        count++;
+    }
+
+  cleanup:
+    if (owned)
+        git_revwalk_free(walk);
+    free(columns);
+    free(values);
+
+    if (retval < 0 && retval != GIT_ITEROVER) {
+        free(records);
+        EGIT_CHECK_ERROR(retval);
+    }
+
+    emacs_value ret = em_vector(env, records, count);
+    free(records);
+    return ret;
+}
+
+EGIT_DOC(log_path, "SOURCE PATHS &optional OFFSET LIMIT REVSPEC FOLLOW",
+         "Return a vector of the IDs of commits in SOURCE that change PATHS.\n"
+         "PATHS is a list of file or directory names relative to the root of\n"
+         "the repository.\n\n"
+         "SOURCE is either a repository or a revision walker. For a repository,\n"
+         "commits reachable from REVSPEC (default HEAD) are walked in time\n"
+         "order, but never before their children, and REVSPEC may also be a\n"
+         "range of the form A..B. A revision walker must be sorted\n"
+         "topologically, and is consumed from its current position and not\n"
+         "reset. Calls with the same PATHS and FOLLOW on the same walker\n"
+         "continue the walk, so its history can be listed in pages.\n\n"
+         "History is simplified like git's default: a commit is listed if it\n"
+         "differs from each of its parents along PATHS, and if it is identical\n"
+         "to one of them, only that parent is followed.\n\n"
+         "If FOLLOW is non-nil, PATHS must have a single element, and renames\n"
+         "of it are followed. Each element of the result is then a cons cell\n"
+         "(ID . PATH) with the name of the path in that commit.\n\n"
+         "OFFSET matching commits are skipped first, and at most LIMIT are returned.");
+emacs_value egit_log_path(
+    emacs_env *env, emacs_value _source, emacs_value _paths, emacs_value _offset,
+    emacs_value _limit, emacs_value _revspec, emacs_value follow)
+{
+    ptrdiff_t npaths = em_assert_list(env, esym_stringp, _paths);
+    if (npaths < 0)
+        return esym_nil;
+    if (EM_EXTRACT_BOOLEAN(follow) && npaths != 1) {
+        em_signal_wrong_value(env, _paths);
+        return esym_nil;
+    }
+
+    intmax_t offset, limit;
+    if (!log_get_range(&offset, &limit, env, _offset, _limit))
+        return esym_nil;
+
+    git_revwalk *walk;
+    bool owned;
+    if (!log_get_walker(&walk, &owned, env, _source, _revspec,
+                        GIT_SORT_TOPOLOGICAL | GIT_SORT_TIME))
+        return esym_nil;
+    git_repository *repo = git_revwalk_repository(walk);
+
+    // On a revwalk, pick up where the previous page left off
+    egit_object *wrapper = owned ? NULL : (egit_object*) EM_EXTRACT_USER_PTR(_source);
+    logpath_cursor *cursor = wrapper ? egit_state_get(wrapper, logpath_cursor_free) : NULL;
+    if (!cursor || !logpath_cursor_continues(cursor, env, _paths, npaths, EM_EXTRACT_BOOLEAN(follow))) {
+        cursor = logpath_cursor_new(env, _paths, npaths, EM_EXTRACT_BOOLEAN(follow));
+        if (wrapper)
+            egit_state_set(wrapper, cursor, logpath_cursor_free);
+    }
+    char **paths = cursor->paths;
+    logpath_marks *marks = &cursor->marks;
+
+    size_t alloc = (limit >= 0 && limit < 256) ? (limit > 0 ? limit : 1) : 256, count = 0;
+    emacs_value *commits = (emacs_value*) malloc(alloc * sizeof(emacs_value));
+
+    git_oid oid;
+    int retval = 0;
+    while (limit < 0 || (intmax_t) count < limit) {
+        if ((retval = git_revwalk_next(&oid, walk)) < 0)
+            break;
+
+        git_commit *commit;
+        if ((retval = git_commit_lookup(&commit, repo, &oid)) < 0)
+            break;
+
+        // Commits only reachable through parents that were not followed are
+        // skipped, along with their own parents
+        if (logpath_marks_get(marks, &oid) == LOGPATH_SKIPPED) {
+            for (unsigned int i = 0; i < git_commit_parentcount(commit); i++)
+                logpath_marks_set(marks, git_commit_parent_id(commit, i), LOGPATH_SKIPPED);
+            git_commit_free(commit);
+            continue;
+        }
+
+        bool shown;
+        retval = logpath_visit(&shown, marks, repo, commit, paths, npaths);
+        if (retval == 0 && shown && offset == 0) {
+            if (count == alloc) {
+                alloc *= 2;
+                commits = (emacs_value*) realloc(commits, alloc * sizeof(emacs_value));
+            }
+            commits[count] = log_oid(env, &oid);
+            if (EM_EXTRACT_BOOLEAN(follow))
+                commits[count] = em_cons(env, commits[count], EM_STRING(paths[0]));
+            count++;
+        }
+        else if (retval == 0 && shown)
+            offset--;
+        if (retval == 0 && shown && EM_EXTRACT_BOOLEAN(follow))
+            retval = logpath_follow(&paths[0], repo, commit);
+        git_commit_free(commit);
+        if (retval < 0)
+            break;
+    }
+
+    if (owned) {
+        git_revwalk_free(walk);
+        logpath_cursor_free(cursor);
+    }
+    else if (retval == GIT_ITEROVER) {
+        // The walker has reset itself, so the next call starts afresh
+        egit_state_set(wrapper, NULL, NULL);
+    }
+
+    if (retval < 0 && retval != GIT_ITEROVER) {
+        free(commits);
+        EGIT_CHECK_ERROR(retval);
+    }
+
+    emacs_value ret = em_vector(env, commits, count);
+    free(commits);
+    return ret;
+}
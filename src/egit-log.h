@@ -0,0 +1,11 @@
+#include "egit.h"
+
+#ifndef EGIT_LOG_H
+#define EGIT_LOG_H
+
+EGIT_DEFUN(log, emacs_value _source, emacs_value _columns, emacs_value _offset,
+           emacs_value _limit, emacs_value _revspec);
+EGIT_DEFUN(log_path, emacs_value _source, emacs_value _paths, emacs_value _offset,
+           emacs_value _limit, emacs_value _revspec, emacs_value follow);
+
+#endif /* EGIT_LOG_H */
@@ -1,13 +1,47 @@
+#include <stdlib.h>
 #include <string.h>
 
 #include "git2.h"
 
 #include "egit.h"
+#include "egit-commit-graph.h"
 #include "egit-options.h"
 #include "interface.h"
 #include "egit-merge.h"
 
 
+/**
+ * Find the merge bases of IDS with the commit-graph of REPO, if it has one
+ * and all of IDS are in it.
+ * @param graph Where to store the commit-graph, to look up the results.
+ * @param count Where to store the number of merge bases.
+ * @return The positions of the merge bases, which must be freed, or NULL
+ * if the commit-graph can't be used or no merge base was found. In that
+ * case, libgit2 must be asked instead, and will report the error.
+ */
+static uint32_t *merge_bases_from_graph(
+    egit_cgraph **graph, size_t *count, git_repository *repo, const git_oid *ids, size_t nids)
+{
+    *graph = egit_cgraph_get(repo);
+    if (!*graph || nids < 2)
+        return NULL;
+
+    uint32_t pos[nids];
+    for (size_t i = 0; i < nids; i++)
+        if (!egit_cgraph_find(*graph, &ids[i], &pos[i]))
+            return NULL;
+
+    uint32_t *bases;
+    if (!egit_cgraph_merge_bases(&bases, count, *graph, pos[0], pos + 1, nids - 1))
+        return NULL;
+    if (*count == 0) {
+        free(bases);
+        return NULL;
+    }
+    return bases;
+}
+
+
 EGIT_DOC(merge, "REPO HEADS &optional MERGE-OPTIONS CHECKOUT-OPTIONS",
          "Merge HEADS (a list of annotated commits) into the HEAD of REPO.\n"
          "For CHECKOUT-OPTIONS, see `libgit-checkout-head'.\n"
@@ -120,6 +154,8 @@ emacs_value egit_merge_analysis(emacs_env *env, emacs_value _repo, emacs_value _
 
 EGIT_DOC(merge_base, "REPO IDS",
          "Find the best merge base between commits given by the list IDS.\n"
+         "If REPO has a commit-graph, see `libgit-commit-graph-write', it is\n"
+         "used to stop the search early.\n"
          "Returns a commit ID.");
 emacs_value egit_merge_base(emacs_env *env, emacs_value _repo, emacs_value _ids)
 {
@@ -135,6 +171,15 @@ emacs_value egit_merge_base(emacs_env *env, emacs_value _repo, emacs_value _ids)
         EM_DOLIST_END(get_ids);
     }
 
+    egit_cgraph *graph;
+    size_t count;
+    uint32_t *bases = merge_bases_from_graph(&graph, &count, repo, ids, nids);
+    if (bases) {
+        const char *oid_s = git_oid_tostr_s(egit_cgraph_oid(graph, bases[0]));
+        free(bases);
+        return EM_STRING(oid_s);
+    }
+
     git_oid out;
     int retval;
     if (nids == 2)
@@ -174,6 +219,8 @@ emacs_value egit_merge_base_octopus(emacs_env *env, emacs_value _repo, emacs_val
 
 EGIT_DOC(merge_bases, "REPO IDS",
          "Find all merge bases between commits given by the list IDS.\n"
+         "If REPO has a commit-graph, see `libgit-commit-graph-write', it is\n"
+         "used to stop the search early.\n"
          "Returns a list of commit IDs.");
 emacs_value egit_merge_bases(emacs_env *env, emacs_value _repo, emacs_value _ids)
 {
@@ -189,6 +236,19 @@ emacs_value egit_merge_bases(emacs_env *env, emacs_value _repo, emacs_value _ids
         EM_DOLIST_END(get_ids);
     }
 
+    egit_cgraph *graph;
+    size_t count;
+    uint32_t *bases = merge_bases_from_graph(&graph, &count, repo, ids, nids);
+    if (bases) {
+        emacs_value ret = esym_nil;
+        for (size_t i = count; i > 0; i--) {
+            const char *oid_s = git_oid_tostr_s(egit_cgraph_oid(graph, bases[i-1]));
+            ret = em_cons(env, EM_STRING(oid_s), ret);
+        }
+        free(bases);
+        return ret;
+    }
+
     git_oidarray out;
     int retval;
     if (nids == 2)
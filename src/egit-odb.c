@@ -0,0 +1,576 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "git2.h"
+
+#include "egit.h"
+#include "interface.h"
+#include "egit-pool.h"
+#include "egit-odb.h"
+
+
+// =============================================================================
+// Helpers
+
+/**
+ * Parse a list of object IDs into a newly allocated array.
+ * @return The array, or NULL with an error signalled if an element is not a valid ID.
+ */
+static git_oid *odb_extract_ids(size_t *count, emacs_env *env, emacs_value _ids)
+{
+    ptrdiff_t nids = em_assert_list(env, esym_stringp, _ids);
+    if (nids < 0)
+        return NULL;
+
+    git_oid *oids = (git_oid*) malloc((nids ? nids : 1) * sizeof(git_oid));
+    for (ptrdiff_t i = 0; i < nids; i++) {
+        char *oid_s = EM_EXTRACT_STRING(em_car(env, _ids));
+        int retval = git_oid_fromstrp(&oids[i], oid_s);
+        free(oid_s);
+        if (retval < 0) {
+            free(oids);
+            egit_dispatch_error(env, retval);
+            return NULL;
+        }
+        _ids = em_cdr(env, _ids);
+    }
+
+    *count = nids;
+    return oids;
+}
+
+
+// =============================================================================
+// Headers
+
+EGIT_DOC(odb_read_header, "REPO ID",
+         "Return the type and size of the object with the given ID in REPO.\n"
+         "The result is a cons cell (TYPE . SIZE), where TYPE is a symbol such\n"
+         "as `blob' or `tree'. The object is not inflated: for a delta in a\n"
+         "pack, only the headers along its delta chain are read.");
+emacs_value egit_odb_read_header(emacs_env *env, emacs_value _repo, emacs_value _id)
+{
+    EGIT_ASSERT_REPOSITORY(_repo);
+    EM_ASSERT_STRING(_id);
+    git_repository *repo = EGIT_EXTRACT(_repo);
+
+    git_oid id;
+    char *oid_s = EM_EXTRACT_STRING(_id);
+    int retval = git_oid_fromstrp(&id, oid_s);
+    free(oid_s);
+    EGIT_CHECK_ERROR(retval);
+
+    git_odb *odb;
+    retval = git_repository_odb(&odb, repo);
+    EGIT_CHECK_ERROR(retval);
+
+    size_t size;
+    git_otype type;
+    retval = git_odb_read_header(&size, &type, odb, &id);
+    git_odb_free(odb);
+    EGIT_CHECK_ERROR(retval);
+
+    return em_cons(env, em_findenum_otype(type), EM_INTEGER(size));
+}
+
+EGIT_DOC(odb_headers, "REPO IDS &optional NOERROR",
+         "Return the types and sizes of the objects with the given IDS in REPO.\n"
+         "The result is a vector in the same order as IDS, whose elements are\n"
+         "cons cells (TYPE . SIZE) as returned by `libgit-odb-read-header'.\n"
+         "No object is inflated.\n\n"
+         "If NOERROR is non-nil, missing objects give nil elements instead of\n"
+         "signalling an error.");
+emacs_value egit_odb_headers(emacs_env *env, emacs_value _repo, emacs_value _ids, emacs_value noerror)
+{
+    EGIT_ASSERT_REPOSITORY(_repo);
+    git_repository *repo = EGIT_EXTRACT(_repo);
+
+    size_t count;
+    git_oid *ids = odb_extract_ids(&count, env, _ids);
+    if (!ids)
+        return esym_nil;
+
+    git_odb *odb;
+    int retval = git_repository_odb(&odb, repo);
+    if (retval < 0) {
+        free(ids);
+        EGIT_CHECK_ERROR(retval);
+    }
+
+    // Header reads are cheap enough that a thread pool would not pay off
+    emacs_value *values = (emacs_value*) malloc((count ? count : 1) * sizeof(emacs_value));
+    bool quit = false;
+    for (size_t i = 0; i < count; i++) {
+        if ((i & 1023) == 1023 && (quit = em_should_quit(env)))
+            break;
+
+        size_t size;
+        git_otype type;
+        retval = git_odb_read_header(&size, &type, odb, &ids[i]);
+        if (retval == GIT_ENOTFOUND && EM_EXTRACT_BOOLEAN(noerror)) {
+            giterr_clear();
+            values[i] = esym_nil;
+            retval = 0;
+            continue;
+        }
+        if (retval < 0)
+            break;
+        values[i] = em_cons(env, em_findenum_otype(type), EM_INTEGER(size));
+    }
+
+    emacs_value ret = retval == 0 && !quit ? em_vector(env, values, count) : esym_nil;
+    free(values);
+    free(ids);
+    git_odb_free(odb);
+
+    EGIT_CHECK_ERROR(retval);
+    return ret;
+}
+
+
+// =============================================================================
+// Reading
+
+typedef struct {
+    git_odb *odb;
+    const git_oid *ids;
+    size_t *sizes;
+    git_otype *types;
+    git_odb_object **objects;
+    bool headers;               /**< Whether the current batch reads headers only. */
+} odb_read_ctx;
+
+static int odb_read_task(size_t index, void *state, void *payload)
+{
+    (void) state;
+    odb_read_ctx *ctx = (odb_read_ctx*) payload;
+    if (ctx->headers)
+        return git_odb_read_header(&ctx->sizes[index], &ctx->types[index], ctx->odb, &ctx->ids[index]);
+    return git_odb_read(&ctx->objects[index], ctx->odb, &ctx->ids[index]);
+}
+
+EGIT_DOC(odb_read_many, "REPO IDS &optional MAX-BYTES WITH-TYPE",
+         "Read the objects with the given IDS from the object database of REPO.\n"
+         "The objects are read and inflated on a pool of threads, and returned\n"
+         "as a vector in the same order as IDS. Each element is the content of\n"
+         "the object as a unibyte string, or if WITH-TYPE is non-nil, a list\n"
+         "(TYPE SIZE CONTENT) where TYPE is a symbol such as `blob' or `tree'.\n\n"
+         "If MAX-BYTES is given, objects are only read while the total size of\n"
+         "the objects so far, in the order of IDS, stays within MAX-BYTES. The\n"
+         "content of the remaining objects is nil. Their type and size are\n"
+         "still known, since headers are read first.\n\n"
+         "Signal an error if any object is missing.");
+emacs_value egit_odb_read_many(
+    emacs_env *env, emacs_value _repo, emacs_value _ids, emacs_value _max_bytes,
+    emacs_value with_type)
+{
+    EGIT_ASSERT_REPOSITORY(_repo);
+    git_repository *repo = EGIT_EXTRACT(_repo);
+
+    intmax_t max_bytes = -1;
+    if (EM_EXTRACT_BOOLEAN(_max_bytes)) {
+        EM_ASSERT_INTEGER(_max_bytes);
+        max_bytes = EM_EXTRACT_INTEGER(_max_bytes);
+    }
+
+    size_t count;
+    git_oid *ids = odb_extract_ids(&count, env, _ids);
+    if (!ids)
+        return esym_nil;
+
+    // The object database is thread-safe, so all workers share it
+    git_odb *odb;
+    int retval = git_repository_odb(&odb, repo);
+    if (retval < 0) {
+        free(ids);
+        EGIT_CHECK_ERROR(retval);
+    }
+
+    odb_read_ctx ctx;
+    ctx.odb = odb;
+    ctx.ids = ids;
+    ctx.sizes = (size_t*) calloc(count ? count : 1, sizeof(size_t));
+    ctx.types = (git_otype*) calloc(count ? count : 1, sizeof(git_otype));
+    ctx.objects = (git_odb_object**) calloc(count ? count : 1, sizeof(git_odb_object*));
+
+    egit_pool *pool = egit_pool_new(count < egit_pool_default_size() ? count : 0,
+                                    NULL, odb_read_task, NULL, &ctx);
+
+    // With a cap, read the headers first to find how many objects fit
+    size_t nread = count;
+    if (max_bytes >= 0) {
+        ctx.headers = true;
+        retval = egit_pool_run(pool, count);
+        intmax_t total = 0;
+        for (nread = 0; retval == 0 && nread < count; nread++) {
+            total += ctx.sizes[nread];
+            if (total > max_bytes)
+                break;
+        }
+    }
+
+    if (retval == 0) {
+        ctx.headers = false;
+        retval = egit_pool_run(pool, nread);
+    }
+    egit_pool_free(pool);
+
+    emacs_value ret = esym_nil;
+    if (retval == 0) {
+        emacs_value *values = (emacs_value*) malloc((count ? count : 1) * sizeof(emacs_value));
+        for (size_t i = 0; i < count; i++) {
+            git_odb_object *obj = ctx.objects[i];
+            emacs_value content = esym_nil;
+            if (obj) {
+                ctx.sizes[i] = git_odb_object_size(obj);
+                ctx.types[i] = git_odb_object_type(obj);
+                content = env->make_string(env, git_odb_object_data(obj), ctx.sizes[i]);
+                content = em_string_as_unibyte(env, content);
+            }
+
+            if (EM_EXTRACT_BOOLEAN(with_type)) {
+                emacs_value record[3];
+                record[0] = em_findenum_otype(ctx.types[i]);
+                record[1] = EM_INTEGER(ctx.sizes[i]);
+                record[2] = content;
+                values[i] = em_list(env, record, 3);
+            }
+            else
+                values[i] = content;
+        }
+        ret = em_vector(env, values, count);
+        free(values);
+    }
+
+    for (size_t i = 0; i < count; i++)
+        git_odb_object_free(ctx.objects[i]);
+    free(ctx.objects);
+    free(ctx.types);
+    free(ctx.sizes);
+    free(ids);
+    git_odb_free(odb);
+
+    EGIT_CHECK_ERROR(retval);
+    return ret;
+}
+
+
+// =============================================================================
+// OID memo
+
+#define OID_MEMO_SIZE 4096
+
+typedef enum {
+    OID_MEMO_EMPTY,
+    OID_MEMO_PREFIX,            /**< KEY is a prefix of LEN hex digits of ID. */
+    OID_MEMO_ABBREV             /**< KEY is ID, and LEN its shortest unique abbreviation
+                                     of at least START digits. */
+} oid_memo_kind;
+
+typedef struct {
+    oid_memo_kind kind;
+    size_t len, start;
+    git_oid key;
+    git_oid id;
+    git_otype type;
+} oid_memo_entry;
+
+typedef struct oid_memo oid_memo;
+struct oid_memo {
+    char *path;
+    time_t pack_mtime;
+    oid_memo_entry entries[OID_MEMO_SIZE];
+    oid_memo *next;
+};
+
+// Memos are kept per repository path, like commit-graphs. A resolved prefix
+// can only become ambiguous when objects are added, and is then still a valid
+// answer as of when it was resolved, like abbreviations printed by git. Since
+// most new objects arrive in packs, memos are cleared when the pack directory
+// changes.
+static oid_memo *oid_memos = NULL;
+
+static oid_memo *oid_memo_get(git_repository *repo)
+{
+    const char *commondir = git_repository_commondir(repo);
+    if (!commondir)
+        return NULL;
+
+    size_t len = strlen(commondir) + strlen("objects/pack") + 1;
+    char *path = (char*) malloc(len);
+    snprintf(path, len, "%sobjects/pack", commondir);
+    struct stat st;
+    time_t mtime = stat(path, &st) == 0 ? st.st_mtime : 0;
+
+    oid_memo *memo;
+    for (memo = oid_memos; memo; memo = memo->next)
+        if (strcmp(memo->path, path) == 0)
+            break;
+
+    if (!memo) {
+        memo = (oid_memo*) calloc(1, sizeof(oid_memo));
+        memo->path = path;
+        memo->pack_mtime = mtime;
+        memo->next = oid_memos;
+        oid_memos = memo;
+        return memo;
+    }
+
+    free(path);
+    if (memo->pack_mtime != mtime) {
+        memset(memo->entries, 0, sizeof(memo->entries));
+        memo->pack_mtime = mtime;
+    }
+    return memo;
+}
+
+static oid_memo_entry *oid_memo_slot(
+    oid_memo *memo, oid_memo_kind kind, const git_oid *key, size_t len)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < 8; i++)
+        hash = (hash ^ key->id[i]) * 16777619u;
+    if (kind == OID_MEMO_PREFIX)
+        hash = (hash ^ (uint32_t) len) * 16777619u;
+    hash = (hash ^ (uint32_t) kind) * 16777619u;
+    return &memo->entries[hash % OID_MEMO_SIZE];
+}
+
+static oid_memo_entry *oid_memo_find(
+    oid_memo *memo, oid_memo_kind kind, const git_oid *key, size_t len)
+{
+    if (!memo)
+        return NULL;
+    oid_memo_entry *entry = oid_memo_slot(memo, kind, key, len);
+    if (entry->kind != kind || (kind == OID_MEMO_PREFIX && entry->len != len) ||
+        git_oid_cmp(&entry->key, key) != 0)
+        return NULL;
+    return entry;
+}
+
+static void oid_memo_store(
+    oid_memo *memo, oid_memo_kind kind, const git_oid *key, size_t len, size_t start,
+    const git_oid *id, git_otype type)
+{
+    if (!memo)
+        return;
+    oid_memo_entry *entry = oid_memo_slot(memo, kind, key, len);
+    entry->kind = kind;
+    entry->len = len;
+    entry->start = start;
+    git_oid_cpy(&entry->key, key);
+    git_oid_cpy(&entry->id, id);
+    entry->type = type;
+}
+
+/**
+ * Resolve a hex prefix to a full ID and type.
+ * @return Zero, GIT_ENOTFOUND, GIT_EAMBIGUOUS, or another error code.
+ */
+static int oid_resolve(
+    git_oid *id, git_otype *type, oid_memo *memo, git_odb *odb,
+    const char *prefix, size_t len)
+{
+    git_oid key;
+    if (len < GIT_OID_MINPREFIXLEN || len > GIT_OID_HEXSZ ||
+        git_oid_fromstrn(&key, prefix, len) < 0) {
+        giterr_clear();
+        return GIT_ENOTFOUND;
+    }
+
+    oid_memo_entry *entry = oid_memo_find(memo, OID_MEMO_PREFIX, &key, len);
+    if (entry) {
+        git_oid_cpy(id, &entry->id);
+        *type = entry->type;
+        return 0;
+    }
+
+    int retval;
+    if (len == GIT_OID_HEXSZ) {
+        git_oid_cpy(id, &key);
+        retval = git_odb_exists(odb, &key) ? 0 : GIT_ENOTFOUND;
+    }
+    else
+        retval = git_odb_exists_prefix(id, odb, &key, len);
+    if (retval == 0) {
+        size_t size;
+        retval = git_odb_read_header(&size, type, odb, id);
+    }
+    if (retval == GIT_ENOTFOUND || retval == GIT_EAMBIGUOUS) {
+        giterr_clear();
+        return retval;
+    }
+    if (retval < 0)
+        return retval;
+
+    oid_memo_store(memo, OID_MEMO_PREFIX, &key, len, 0, id, *type);
+    return 0;
+}
+
+/**
+ * Find the shortest unique abbreviation of an ID, of at least MIN_LEN digits.
+ * @return Zero, GIT_ENOTFOUND if there is no such object, or another error code.
+ */
+static int oid_abbrev(size_t *out, oid_memo *memo, git_odb *odb, const git_oid *id, size_t min_len)
+{
+    if (min_len < GIT_OID_MINPREFIXLEN)
+        min_len = GIT_OID_MINPREFIXLEN;
+
+    oid_memo_entry *entry = oid_memo_find(memo, OID_MEMO_ABBREV, id, 0);
+    if (entry && entry->start <= min_len) {
+        *out = entry->len < min_len ? min_len : entry->len;
+        return 0;
+    }
+
+    size_t len;
+    int retval = GIT_EAMBIGUOUS;
+    git_oid found;
+    for (len = min_len; len < GIT_OID_HEXSZ; len++) {
+        retval = git_odb_exists_prefix(&found, odb, id, len);
+        if (retval != GIT_EAMBIGUOUS)
+            break;
+    }
+    if (len == GIT_OID_HEXSZ)
+        retval = git_odb_exists(odb, id) ? 0 : GIT_ENOTFOUND;
+    if (retval == GIT_EAMBIGUOUS || retval == GIT_ENOTFOUND) {
+        giterr_clear();
+        return GIT_ENOTFOUND;
+    }
+    if (retval < 0)
+        return retval;
+
+    // A unique prefix of some other object means ID does not exist
+    if (len < GIT_OID_HEXSZ && git_oid_cmp(&found, id) != 0)
+        return GIT_ENOTFOUND;
+
+    oid_memo_store(memo, OID_MEMO_ABBREV, id, len, min_len, id, GIT_OBJ_ANY);
+    *out = len;
+    return 0;
+}
+
+EGIT_DOC(oid_resolve_many, "REPO PREFIXES",
+         "Resolve PREFIXES, a list of hexadecimal strings, to objects in REPO.\n"
+         "Return a vector in the same order as PREFIXES. Each element is a\n"
+         "cons cell (ID . TYPE) with the full ID and type of the object; nil\n"
+         "if there is no such object or the string is not a valid prefix of\n"
+         "at least four digits; or the symbol `ambiguous' if more than one\n"
+         "object matches.\n\n"
+         "Resolved prefixes are remembered for the repository. A remembered\n"
+         "prefix is not checked again until new packs are added, so it may be\n"
+         "returned even if newer loose objects made it ambiguous.");
+emacs_value egit_oid_resolve_many(emacs_env *env, emacs_value _repo, emacs_value _prefixes)
+{
+    EGIT_ASSERT_REPOSITORY(_repo);
+    git_repository *repo = EGIT_EXTRACT(_repo);
+    ptrdiff_t count = em_assert_list(env, esym_stringp, _prefixes);
+    if (count < 0)
+        return esym_nil;
+
+    git_odb *odb;
+    int retval = git_repository_odb(&odb, repo);
+    EGIT_CHECK_ERROR(retval);
+    oid_memo *memo = oid_memo_get(repo);
+
+    emacs_value *values = (emacs_value*) malloc((count ? count : 1) * sizeof(emacs_value));
+    for (ptrdiff_t i = 0; i < count; i++) {
+        ptrdiff_t len;
+        char *prefix = em_get_string_with_size(env, em_car(env, _prefixes), &len);
+        _prefixes = em_cdr(env, _prefixes);
+
+        git_oid id;
+        git_otype type;
+        retval = oid_resolve(&id, &type, memo, odb, prefix, len);
+        free(prefix);
+
+        if (retval == GIT_ENOTFOUND)
+            values[i] = esym_nil;
+        else if (retval == GIT_EAMBIGUOUS)
+            values[i] = esym_ambiguous;
+        else if (retval < 0)
+            break;
+        else {
+            const char *oid_s = git_oid_tostr_s(&id);
+            values[i] = em_cons(env, EM_STRING(oid_s), em_findenum_otype(type));
+        }
+        retval = 0;
+    }
+
+    emacs_value ret = retval == 0 ? em_vector(env, values, count) : esym_nil;
+    free(values);
+    git_odb_free(odb);
+
+    EGIT_CHECK_ERROR(retval);
+    return ret;
+}
+
+EGIT_DOC(oid_abbrev_many, "REPO IDS &optional MIN-LENGTH",
+         "Return the shortest unique abbreviations of IDS in REPO.\n"
+         "The result is a vector of strings in the same order as IDS, with\n"
+         "nil for IDs of objects that do not exist. Abbreviations have at\n"
+         "least MIN-LENGTH digits, by default the value of core.abbrev, or 7.\n\n"
+         "Abbreviations are remembered for the repository, in the same way as\n"
+         "prefixes in `libgit-oid-resolve-many'.");
+emacs_value egit_oid_abbrev_many(
+    emacs_env *env, emacs_value _repo, emacs_value _ids, emacs_value _min_length)
+{
+    EGIT_ASSERT_REPOSITORY(_repo);
+    git_repository *repo = EGIT_EXTRACT(_repo);
+
+    int32_t min_len = 7;
+    if (EM_EXTRACT_BOOLEAN(_min_length)) {
+        EM_ASSERT_INTEGER(_min_length);
+        intmax_t value = EM_EXTRACT_INTEGER(_min_length);
+        min_len = value < 0 ? 0 : (value > GIT_OID_HEXSZ ? GIT_OID_HEXSZ : value);
+    }
+    else {
+        git_config *config;
+        if (git_repository_config_snapshot(&config, repo) == 0) {
+            int32_t value;
+            if (git_config_get_int32(&value, config, "core.abbrev") == 0 &&
+                value >= GIT_OID_MINPREFIXLEN && value <= GIT_OID_HEXSZ)
+                min_len = value;
+            git_config_free(config);
+        }
+        giterr_clear();
+    }
+
+    size_t count;
+    git_oid *ids = odb_extract_ids(&count, env, _ids);
+    if (!ids)
+        return esym_nil;
+
+    git_odb *odb;
+    int retval = git_repository_odb(&odb, repo);
+    if (retval < 0) {
+        free(ids);
+        EGIT_CHECK_ERROR(retval);
+    }
+    oid_memo *memo = oid_memo_get(repo);
+
+    emacs_value *values = (emacs_value*) malloc((count ? count : 1) * sizeof(emacs_value));
+    for (size_t i = 0; i < count; i++) {
+        size_t len;
+        retval = oid_abbrev(&len, memo, odb, &ids[i], min_len);
+        if (retval == GIT_ENOTFOUND)
+            values[i] = esym_nil;
+        else if (retval < 0)
+            break;
+        else {
+            char oid_s[GIT_OID_HEXSZ + 1];
+            git_oid_tostr(oid_s, len + 1, &ids[i]);
+            values[i] = EM_STRING(oid_s);
+        }
+        retval = 0;
+    }
+
+    emacs_value ret = retval == 0 ? em_vector(env, values, count) : esym_nil;
+    free(values);
+    free(ids);
+    git_odb_free(odb);
+
+    EGIT_CHECK_ERROR(retval);
+    return ret;
+}
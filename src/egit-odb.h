@@ -0,0 +1,14 @@
+#include "egit.h"
+
+#ifndef EGIT_ODB_H
+#define EGIT_ODB_H
+
+EGIT_DEFUN(odb_read_header, emacs_value _repo, emacs_value _id);
+EGIT_DEFUN(odb_headers, emacs_value _repo, emacs_value _ids, emacs_value noerror);
+EGIT_DEFUN(odb_read_many, emacs_value _repo, emacs_value _ids, emacs_value _max_bytes,
+           emacs_value with_type);
+
+EGIT_DEFUN(oid_resolve_many, emacs_value _repo, emacs_value _prefixes);
+EGIT_DEFUN(oid_abbrev_many, emacs_value _repo, emacs_value _ids, emacs_value _min_length);
+
+#endif /* EGIT_ODB_H */
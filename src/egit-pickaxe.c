@@ -0,0 +1,312 @@
+#include <regex.h>
+#include <string.h>
+
+#include "git2.h"
+
+#include "egit.h"
+#include "interface.h"
+#include "egit-pool.h"
+#include "egit-pickaxe.h"
+#include "egit-search.h"
+
+// Number of commits handed to the worker pool at a time
+#define PICKAXE_BATCH 256
+
+
+// =============================================================================
+// Helpers - matching
+
+typedef struct {
+    char **paths;
+    size_t npaths, alloc;
+} pickaxe_result;
+
+typedef struct {
+    egit_search_pattern pattern;
+    const char *repo_path;
+    git_oid *oids;
+    pickaxe_result *batch;
+} pickaxe_ctx;
+
+typedef struct {
+    git_repository *repo;
+    egit_search_buf buf;
+} pickaxe_worker;
+
+/**
+ * Return true in *out if an added or removed line between OLD and NEW matches the regexp.
+ */
+static int pickaxe_grep(
+    bool *out, pickaxe_worker *worker, const egit_search_pattern *pattern,
+    git_blob *old, git_blob *new)
+{
+    git_diff_options opts;
+    git_diff_init_options(&opts, GIT_DIFF_OPTIONS_VERSION);
+    opts.context_lines = 0;
+    opts.interhunk_lines = 0;
+
+    git_patch *patch;
+    int retval = git_patch_from_blobs(&patch, old, NULL, new, NULL, &opts);
+    if (retval < 0)
+        return retval;
+
+    *out = false;
+    for (size_t h = 0; !*out && h < git_patch_num_hunks(patch); h++) {
+        int nlines = git_patch_num_lines_in_hunk(patch, h);
+        for (int l = 0; !*out && l < nlines; l++) {
+            const git_diff_line *line;
+            if ((retval = git_patch_get_line_in_hunk(&line, patch, h, l)) < 0)
+                goto cleanup;
+            if (line->origin != GIT_DIFF_LINE_ADDITION && line->origin != GIT_DIFF_LINE_DELETION)
+                continue;
+
+            *out = egit_search_match(pattern, &worker->buf, line->content, line->content_len);
+        }
+    }
+
+  cleanup:
+    git_patch_free(patch);
+    return retval;
+}
+
+/**
+ * Return true in *out if the change in DELTA matches the pattern. Like git,
+ * binary files and submodules never match.
+ */
+static int pickaxe_delta(
+    bool *out, pickaxe_worker *worker, const egit_search_pattern *pattern, const git_diff_delta *delta)
+{
+    *out = false;
+    if (delta->old_file.mode == GIT_FILEMODE_COMMIT || delta->new_file.mode == GIT_FILEMODE_COMMIT)
+        return 0;
+
+    git_blob *old = NULL, *new = NULL;
+    int retval = 0;
+    if (!git_oid_iszero(&delta->old_file.id))
+        retval = git_blob_lookup(&old, worker->repo, &delta->old_file.id);
+    if (retval == 0 && !git_oid_iszero(&delta->new_file.id))
+        retval = git_blob_lookup(&new, worker->repo, &delta->new_file.id);
+    if (retval < 0 || (old && git_blob_is_binary(old)) || (new && git_blob_is_binary(new)))
+        goto cleanup;
+
+    if (pattern->regexp)
+        retval = pickaxe_grep(out, worker, pattern, old, new);
+    else {
+        size_t count_old = old ? egit_search_count(pattern, git_blob_rawcontent(old), git_blob_rawsize(old)) : 0;
+        size_t count_new = new ? egit_search_count(pattern, git_blob_rawcontent(new), git_blob_rawsize(new)) : 0;
+        *out = count_old != count_new;
+    }
+
+  cleanup:
+    git_blob_free(new);
+    git_blob_free(old);
+    return retval;
+}
+
+static void pickaxe_result_add(pickaxe_result *result, const char *path)
+{
+    if (result->npaths == result->alloc) {
+        result->alloc = result->alloc ? 2 * result->alloc : 4;
+        result->paths = (char**) realloc(result->paths, result->alloc * sizeof(char*));
+    }
+    result->paths[result->npaths++] = strdup(path);
+}
+
+static void pickaxe_result_clear(pickaxe_result *result)
+{
+    for (size_t i = 0; i < result->npaths; i++)
+        free(result->paths[i]);
+    result->npaths = 0;
+}
+
+
+// =============================================================================
+// Helpers - workers
+
+static int pickaxe_worker_init(void **state, void *payload)
+{
+    pickaxe_ctx *ctx = (pickaxe_ctx*) payload;
+    pickaxe_worker *worker = (pickaxe_worker*) calloc(1, sizeof(pickaxe_worker));
+    *state = worker;
+    return git_repository_open(&worker->repo, ctx->repo_path);
+}
+
+static void pickaxe_worker_free(void *state, void *payload)
+{
+    (void) payload;
+    pickaxe_worker *worker = (pickaxe_worker*) state;
+    if (!worker)
+        return;
+    git_repository_free(worker->repo);
+    free(worker->buf.ptr);
+    free(worker);
+}
+
+/**
+ * Diff a commit against its parent and collect the paths whose change matches.
+ * Like git log, merge commits are not diffed and never match.
+ */
+static int pickaxe_task(size_t index, void *state, void *payload)
+{
+    pickaxe_ctx *ctx = (pickaxe_ctx*) payload;
+    pickaxe_worker *worker = (pickaxe_worker*) state;
+    pickaxe_result *result = &ctx->batch[index];
+
+    git_commit *commit, *parent = NULL;
+    int retval = git_commit_lookup(&commit, worker->repo, &ctx->oids[index]);
+    if (retval < 0)
+        return retval;
+    if (git_commit_parentcount(commit) > 1) {
+        git_commit_free(commit);
+        return 0;
+    }
+
+    git_tree *old_tree = NULL, *new_tree = NULL;
+    git_diff *diff = NULL;
+    if (git_commit_parentcount(commit) == 1) {
+        retval = git_commit_parent(&parent, commit, 0);
+        if (retval == 0)
+            retval = git_commit_tree(&old_tree, parent);
+    }
+    if (retval == 0)
+        retval = git_commit_tree(&new_tree, commit);
+    if (retval == 0)
+        retval = git_diff_tree_to_tree(&diff, worker->repo, old_tree, new_tree, NULL);
+
+    for (size_t i = 0; retval == 0 && i < git_diff_num_deltas(diff); i++) {
+        const git_diff_delta *delta = git_diff_get_delta(diff, i);
+        bool match;
+        retval = pickaxe_delta(&match, worker, &ctx->pattern, delta);
+        if (retval == 0 && match)
+            pickaxe_result_add(result, delta->new_file.path);
+    }
+
+    git_diff_free(diff);
+    git_tree_free(new_tree);
+    git_tree_free(old_tree);
+    git_commit_free(parent);
+    git_commit_free(commit);
+    return retval;
+}
+
+
+// =============================================================================
+// Pickaxe
+
+EGIT_DOC(pickaxe, "REVWALK PATTERN &optional REGEXP LIMIT FUNC",
+         "Search the commits in REVWALK for changes involving PATTERN.\n"
+         "By default, like `git log -S', a commit matches if it changes the\n"
+         "number of occurrences of the string PATTERN in a file. If REGEXP is\n"
+         "non-nil, like `git log -G', a commit matches if an added or removed\n"
+         "line matches PATTERN as an extended regular expression.\n\n"
+         "Each commit is compared with its parent, and merge commits and binary\n"
+         "files never match. The commits are distributed over a pool of threads.\n\n"
+         "Return a vector of matches in walk order, each of the form\n"
+         "(ID PATH...), where the paths are the files whose change matched.\n"
+         "If FUNC is non-nil, it is called with each match as soon as it is\n"
+         "found, and the search stops early if it returns `abort'. The search\n"
+         "also stops when the user quits.\n\n"
+         "The revwalk is not reset, so subsequent calls return the next page\n"
+         "of results. As with `libgit-revwalk-search', commits are searched in\n"
+         "batches, and the search stops at the end of the first batch with at\n"
+         "least LIMIT matches, so more than LIMIT matches may be returned. The\n"
+         "next call resumes right after them. Only stopping with `abort' or a\n"
+         "quit leaves the rest of a batch unsearched.");
+emacs_value egit_pickaxe(
+    emacs_env *env, emacs_value _revwalk, emacs_value _pattern,
+    emacs_value regexp, emacs_value _limit, emacs_value func)
+{
+    EGIT_ASSERT_REVWALK(_revwalk);
+    EM_ASSERT_STRING(_pattern);
+    intmax_t limit = -1;
+    if (EM_EXTRACT_BOOLEAN(_limit)) {
+        EM_ASSERT_INTEGER(_limit);
+        limit = EM_EXTRACT_INTEGER(_limit);
+    }
+    if (EM_EXTRACT_BOOLEAN(func))
+        EM_ASSERT_FUNCTION(func);
+
+    git_revwalk *walk = EGIT_EXTRACT(_revwalk);
+    egit_object *wrapper = (egit_object*) EM_EXTRACT_USER_PTR(_revwalk);
+    pickaxe_ctx ctx;
+    ctx.repo_path = git_repository_path(git_revwalk_repository(walk));
+
+    char *needle = EM_EXTRACT_STRING(_pattern);
+    if (!*needle || !egit_search_pattern_init(&ctx.pattern, needle, EM_EXTRACT_BOOLEAN(regexp),
+                                              false, REG_EXTENDED | REG_NEWLINE)) {
+        free(needle);
+        em_signal_wrong_value(env, _pattern);
+        return esym_nil;
+    }
+
+    ctx.oids = (git_oid*) malloc(PICKAXE_BATCH * sizeof(git_oid));
+    ctx.batch = (pickaxe_result*) calloc(PICKAXE_BATCH, sizeof(pickaxe_result));
+    egit_pool *pool = egit_pool_new(0, pickaxe_worker_init, pickaxe_task, pickaxe_worker_free, &ctx);
+
+    size_t alloc = 64, count = 0;
+    emacs_value *matches = (emacs_value*) malloc(alloc * sizeof(emacs_value));
+    bool done = limit == 0, exhausted = false, aborted = false, nonlocal_exit = false;
+    int retval = 0;
+
+    while (!done) {
+        size_t n;
+        retval = egit_search_next_batch(ctx.oids, PICKAXE_BATCH, &n, &exhausted, wrapper);
+        if (retval < 0 || (retval = egit_pool_run(pool, n)) < 0)
+            break;
+
+        for (size_t i = 0; i < n; i++) {
+            pickaxe_result *result = &ctx.batch[i];
+            if (aborted || result->npaths == 0) {
+                pickaxe_result_clear(result);
+                continue;
+            }
+
+            emacs_value match = esym_nil;
+            for (size_t p = result->npaths; p > 0; p--)
+                match = em_cons(env, EM_STRING(result->paths[p - 1]), match);
+            const char *oid_s = git_oid_tostr_s(&ctx.oids[i]);
+            match = em_cons(env, EM_STRING(oid_s), match);
+            pickaxe_result_clear(result);
+
+            if (count == alloc) {
+                alloc *= 2;
+                matches = (emacs_value*) realloc(matches, alloc * sizeof(emacs_value));
+            }
+            matches[count++] = match;
+
+            if (EM_EXTRACT_BOOLEAN(func)) {
+                emacs_value ret = env->funcall(env, func, 1, &match);
+                if (env->non_local_exit_check(env) != emacs_funcall_exit_return)
+                    aborted = nonlocal_exit = true;
+                else if (EM_EQ(ret, esym_abort))
+                    aborted = true;
+            }
+        }
+
+        // Like revwalk-search, a batch is returned whole once LIMIT is reached,
+        // so that the next call can resume at the walker
+        if (aborted || exhausted || (limit >= 0 && (intmax_t) count >= limit) ||
+            em_should_quit(env))
+            done = true;
+    }
+
+    egit_pool_free(pool);
+    for (size_t i = 0; i < PICKAXE_BATCH; i++) {
+        pickaxe_result_clear(&ctx.batch[i]);
+        free(ctx.batch[i].paths);
+    }
+    free(ctx.batch);
+    free(ctx.oids);
+    egit_search_pattern_dispose(&ctx.pattern);
+    free(needle);
+
+    if (nonlocal_exit || retval < 0) {
+        free(matches);
+        EGIT_CHECK_ERROR(retval);
+        return esym_nil;
+    }
+
+    emacs_value ret = em_vector(env, matches, count);
+    free(matches);
+    return ret;
+}
@@ -0,0 +1,9 @@
+#include "egit.h"
+
+#ifndef EGIT_PICKAXE_H
+#define EGIT_PICKAXE_H
+
+EGIT_DEFUN(pickaxe, emacs_value _revwalk, emacs_value _pattern, emacs_value regexp,
+           emacs_value _limit, emacs_value func);
+
+#endif /* EGIT_PICKAXE_H */
@@ -0,0 +1,200 @@
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "git2.h"
+
+#include "egit-pool.h"
+
+
+// =============================================================================
+// Helpers
+
+struct egit_pool {
+    pthread_t *threads;
+    size_t nthreads;
+
+    egit_pool_init_cb init;
+    egit_pool_task_cb task;
+    egit_pool_free_cb fini;
+    void *payload;
+
+    pthread_mutex_t lock;
+    pthread_cond_t work_cond;   /**< Signalled when a batch starts or the pool stops. */
+    pthread_cond_t done_cond;   /**< Signalled when the last worker finishes a batch. */
+
+    unsigned long batch;        /**< Incremented for each batch. */
+    size_t ntasks, next;        /**< Size of the current batch, and the next task to run. */
+    size_t finished;            /**< Number of workers done with the current batch. */
+    bool shutdown;
+
+    int error;
+    int error_class;
+    char *error_message;
+
+    void *inline_state;         /**< Worker state when no threads could be started. */
+};
+
+/**
+ * Record the libgit2 error of the current thread, if it is the first one.
+ * Must be called with the lock held.
+ */
+static void pool_set_error(egit_pool *pool, int retval)
+{
+    if (pool->error < 0)
+        return;
+
+    const git_error *err = giterr_last();
+    pool->error = retval;
+    pool->error_class = err ? err->klass : GITERR_NONE;
+    pool->error_message = err && err->message ? strdup(err->message) : NULL;
+}
+
+static void *pool_worker(void *arg)
+{
+    egit_pool *pool = (egit_pool*) arg;
+
+    void *state = NULL;
+    int retval = pool->init ? pool->init(&state, pool->payload) : 0;
+
+    pthread_mutex_lock(&pool->lock);
+    if (retval < 0)
+        pool_set_error(pool, retval);
+
+    unsigned long seen = 0;
+    while (true) {
+        while (!pool->shutdown && pool->batch == seen)
+            pthread_cond_wait(&pool->work_cond, &pool->lock);
+        if (pool->shutdown)
+            break;
+        seen = pool->batch;
+
+        while (pool->error == 0 && pool->next < pool->ntasks) {
+            size_t index = pool->next++;
+            pthread_mutex_unlock(&pool->lock);
+            retval = pool->task(index, state, pool->payload);
+            pthread_mutex_lock(&pool->lock);
+            if (retval < 0)
+                pool_set_error(pool, retval);
+        }
+
+        if (++pool->finished == pool->nthreads)
+            pthread_cond_signal(&pool->done_cond);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    if (pool->fini)
+        pool->fini(state, pool->payload);
+    return NULL;
+}
+
+
+// =============================================================================
+// Pool
+
+size_t egit_pool_default_size(void)
+{
+    long n;
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    n = info.dwNumberOfProcessors;
+#else
+    n = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return n < 1 ? 1 : (n > 64 ? 64 : n);
+}
+
+egit_pool *egit_pool_new(
+    size_t nthreads, egit_pool_init_cb init, egit_pool_task_cb task,
+    egit_pool_free_cb fini, void *payload)
+{
+    egit_pool *pool = (egit_pool*) calloc(1, sizeof(egit_pool));
+    pool->init = init;
+    pool->task = task;
+    pool->fini = fini;
+    pool->payload = payload;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_cond, NULL);
+    pthread_cond_init(&pool->done_cond, NULL);
+
+    if (nthreads == 0)
+        nthreads = egit_pool_default_size();
+    pool->threads = (pthread_t*) malloc(nthreads * sizeof(pthread_t));
+
+    // Workers compare their count against nthreads, so hold the lock while starting them
+    pthread_mutex_lock(&pool->lock);
+    for (size_t i = 0; i < nthreads; i++) {
+        if (pthread_create(&pool->threads[pool->nthreads], NULL, pool_worker, pool) != 0)
+            break;
+        pool->nthreads++;
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    // Fall back to running tasks on the calling thread
+    if (pool->nthreads == 0 && init) {
+        int retval = init(&pool->inline_state, payload);
+        if (retval < 0)
+            pool_set_error(pool, retval);
+    }
+
+    return pool;
+}
+
+int egit_pool_run(egit_pool *pool, size_t ntasks)
+{
+    pthread_mutex_lock(&pool->lock);
+
+    if (pool->nthreads == 0) {
+        for (size_t i = 0; pool->error == 0 && i < ntasks; i++) {
+            int retval = pool->task(i, pool->inline_state, pool->payload);
+            if (retval < 0)
+                pool_set_error(pool, retval);
+        }
+    }
+    else if (pool->error == 0 && ntasks > 0) {
+        pool->ntasks = ntasks;
+        pool->next = 0;
+        pool->finished = 0;
+        pool->batch++;
+        pthread_cond_broadcast(&pool->work_cond);
+        while (pool->finished < pool->nthreads)
+            pthread_cond_wait(&pool->done_cond, &pool->lock);
+    }
+
+    int retval = pool->error;
+    if (retval < 0)
+        giterr_set_str(pool->error_class, pool->error_message ? pool->error_message : "unknown error");
+    pthread_mutex_unlock(&pool->lock);
+    return retval;
+}
+
+void egit_pool_free(egit_pool *pool)
+{
+    if (!pool)
+        return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->work_cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (size_t i = 0; i < pool->nthreads; i++)
+        pthread_join(pool->threads[i], NULL);
+    if (pool->nthreads == 0 && pool->fini && pool->inline_state)
+        pool->fini(pool->inline_state, pool->payload);
+
+    pthread_cond_destroy(&pool->done_cond);
+    pthread_cond_destroy(&pool->work_cond);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->error_message);
+    free(pool->threads);
+    free(pool);
+}
@@ -0,0 +1,66 @@
+#include <stddef.h>
+
+#include "git2.h"
+
+#ifndef EGIT_POOL_H
+#define EGIT_POOL_H
+
+/**
+ * A pool of worker threads that run batches of independent tasks.
+ *
+ * Each worker has its own state, created once by the init callback when the
+ * thread starts. Since libgit2 objects must not be shared between threads,
+ * this is typically where a worker opens its own repository. Tasks never run
+ * on the main thread, so they must not touch the Emacs environment.
+ */
+typedef struct egit_pool egit_pool;
+
+/**
+ * Create the state of a worker. Return a negative value on error.
+ */
+typedef int (*egit_pool_init_cb)(void **state, void *payload);
+
+/**
+ * Run task number INDEX of the current batch. Return a negative value on
+ * error, in which case the remaining tasks of the batch are skipped.
+ */
+typedef int (*egit_pool_task_cb)(size_t index, void *state, void *payload);
+
+/**
+ * Free the state of a worker.
+ */
+typedef void (*egit_pool_free_cb)(void *state, void *payload);
+
+/**
+ * Return the default number of worker threads, the number of online processors.
+ */
+size_t egit_pool_default_size(void);
+
+/**
+ * Start a pool of worker threads.
+ * @param nthreads Number of threads, or zero for the default.
+ * @param init Callback creating the state of each worker, may be NULL.
+ * @param task Callback running a task.
+ * @param fini Callback freeing the state of each worker, may be NULL.
+ * @param payload Passed to all callbacks.
+ * @return The pool.
+ */
+egit_pool *egit_pool_new(
+    size_t nthreads, egit_pool_init_cb init, egit_pool_task_cb task,
+    egit_pool_free_cb fini, void *payload);
+
+/**
+ * Run tasks 0 to NTASKS - 1 on the pool and wait for them to finish.
+ * If a task or worker initialization failed, its libgit2 error is restored on
+ * the calling thread, so it can be passed on with EGIT_CHECK_ERROR. The pool
+ * does not run further tasks after an error.
+ * @return Zero, or the first negative value returned by a callback.
+ */
+int egit_pool_run(egit_pool *pool, size_t ntasks);
+
+/**
+ * Stop the worker threads and free the pool.
+ */
+void egit_pool_free(egit_pool *pool);
+
+#endif /* EGIT_POOL_H */
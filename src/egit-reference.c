@@ -1,8 +1,11 @@
+#include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 
 #include "git2.h"
 
 #include "egit.h"
+#include "egit-commit-graph.h"
 #include "egit-util.h"
 #include "interface.h"
 #include "egit-repository.h"
@@ -490,3 +493,325 @@ emacs_value egit_reference_foreach_name(emacs_env *env, emacs_value _repo, emacs
     EGIT_CHECK_ERROR(retval);
     return esym_nil;
 }
+
+
+// =============================================================================
+// Snapshot
+
+typedef struct {
+    char *name;
+    git_remote *remote;         /**< NULL if the remote doesn't exist. */
+} snapshot_remote;
+
+typedef struct {
+    git_repository *repo;
+    git_config *config;
+    git_odb *odb;
+    egit_cgraph *graph;
+    bool ahead_behind, time;
+
+    snapshot_remote *remotes;
+    size_t nremotes;
+} snapshot_ctx;
+
+/**
+ * Look up a remote, caching it so that each remote is parsed only once.
+ */
+static git_remote *snapshot_remote_get(snapshot_ctx *ctx, const char *name)
+{
+    for (size_t i = 0; i < ctx->nremotes; i++)
+        if (!strcmp(ctx->remotes[i].name, name))
+            return ctx->remotes[i].remote;
+
+    git_remote *remote = NULL;
+    if (git_remote_lookup(&remote, ctx->repo, name) < 0) {
+        giterr_clear();
+        remote = NULL;
+    }
+
+    ctx->remotes = (snapshot_remote*) realloc(
+        ctx->remotes, (ctx->nremotes + 1) * sizeof(snapshot_remote));
+    ctx->remotes[ctx->nremotes].name = strdup(name);
+    ctx->remotes[ctx->nremotes].remote = remote;
+    ctx->nremotes++;
+    return remote;
+}
+
+/**
+ * Compute the upstream of a local branch from the configuration, like
+ * git_branch_upstream_name but with remotes cached across branches.
+ * @return The upstream name, to be freed by the caller, or NULL.
+ */
+static char *snapshot_upstream(snapshot_ctx *ctx, const char *refname)
+{
+    if (!ctx->config)
+        return NULL;
+
+    const char *branch = refname + strlen("refs/heads/");
+    size_t len = strlen(branch) + strlen("branch..remote") + 1;
+    char *key = (char*) malloc(len);
+
+    const char *remote_name = NULL, *merge = NULL;
+    snprintf(key, len, "branch.%s.remote", branch);
+    int retval = git_config_get_string(&remote_name, ctx->config, key);
+    if (retval == 0) {
+        snprintf(key, len, "branch.%s.merge", branch);
+        retval = git_config_get_string(&merge, ctx->config, key);
+    }
+    free(key);
+    if (retval < 0 || !*remote_name || !*merge) {
+        giterr_clear();
+        return NULL;
+    }
+
+    if (!strcmp(remote_name, "."))
+        return strdup(merge);
+
+    git_remote *remote = snapshot_remote_get(ctx, remote_name);
+    size_t nspecs = remote ? git_remote_refspec_count(remote) : 0;
+    for (size_t i = 0; i < nspecs; i++) {
+        const git_refspec *spec = git_remote_get_refspec(remote, i);
+        if (git_refspec_direction(spec) != GIT_DIRECTION_FETCH ||
+            !git_refspec_src_matches(spec, merge))
+            continue;
+
+        git_buf buf = {NULL, 0, 0};
+        char *upstream = NULL;
+        if (git_refspec_transform(&buf, spec, merge) == 0)
+            upstream = strdup(buf.ptr);
+        git_buf_dispose(&buf);
+        giterr_clear();
+        return upstream;
+    }
+    return NULL;
+}
+
+/**
+ * Find the commit that a reference target peels to, reading only the object
+ * header when the target is a commit already.
+ * @return Zero, GIT_ENOTFOUND if it doesn't peel to a commit, or an error code.
+ */
+static int snapshot_peel(git_oid *out, snapshot_ctx *ctx, const git_reference *ref)
+{
+    const git_oid *target = git_reference_target_peel(ref);
+    if (!target)
+        target = git_reference_target(ref);
+
+    size_t size;
+    git_otype type;
+    int retval = git_odb_read_header(&size, &type, ctx->odb, target);
+    if (retval < 0)
+        return retval;
+    if (type == GIT_OBJ_COMMIT) {
+        git_oid_cpy(out, target);
+        return 0;
+    }
+    if (type != GIT_OBJ_TAG)
+        return GIT_ENOTFOUND;
+
+    git_object *tag, *commit;
+    retval = git_object_lookup(&tag, ctx->repo, target, GIT_OBJ_TAG);
+    if (retval < 0)
+        return retval;
+    retval = git_object_peel(&commit, tag, GIT_OBJ_COMMIT);
+    git_object_free(tag);
+    if (retval < 0)
+        return retval == GIT_EINVALIDSPEC || retval == GIT_EPEEL ? GIT_ENOTFOUND : retval;
+    git_oid_cpy(out, git_object_id(commit));
+    git_object_free(commit);
+    return 0;
+}
+
+static int snapshot_commit_time(git_time_t *out, snapshot_ctx *ctx, const git_oid *id)
+{
+    uint32_t pos;
+    if (ctx->graph && egit_cgraph_find(ctx->graph, id, &pos)) {
+        *out = egit_cgraph_time(ctx->graph, pos);
+        return 0;
+    }
+
+    git_commit *commit;
+    int retval = git_commit_lookup(&commit, ctx->repo, id);
+    if (retval < 0)
+        return retval;
+    *out = git_commit_time(commit);
+    git_commit_free(commit);
+    return 0;
+}
+
+static int snapshot_ahead_behind(
+    size_t *ahead, size_t *behind, snapshot_ctx *ctx, const git_oid *local, const git_oid *upstream)
+{
+    uint32_t local_pos, upstream_pos;
+    if (ctx->graph && egit_cgraph_find(ctx->graph, local, &local_pos) &&
+        egit_cgraph_find(ctx->graph, upstream, &upstream_pos) &&
+        egit_cgraph_ahead_behind(ahead, behind, ctx->graph, local_pos, upstream_pos))
+        return 0;
+    return git_graph_ahead_behind(ahead, behind, ctx->repo, local, upstream);
+}
+
+/**
+ * Build the record for REF.
+ */
+static int snapshot_record(emacs_value *out, emacs_env *env, snapshot_ctx *ctx, git_reference *ref)
+{
+    const char *name = git_reference_name(ref);
+    emacs_value record[8];
+    for (int i = 0; i < 8; i++)
+        record[i] = esym_nil;
+
+    record[0] = EM_STRING(name);
+    record[1] = EM_STRING(git_reference_shorthand(ref));
+
+    bool branch = git_reference_is_branch(ref);
+    record[2] = branch ? esym_branch :
+        git_reference_is_remote(ref) ? esym_remote :
+        git_reference_is_tag(ref) ? esym_tag :
+        git_reference_is_note(ref) ? esym_note : esym_other;
+
+    // Symbolic references are resolved for peeling, but report their own target
+    git_reference *resolved = NULL;
+    int retval;
+    if (git_reference_type(ref) == GIT_REF_SYMBOLIC) {
+        record[3] = EM_STRING(git_reference_symbolic_target(ref));
+        retval = git_reference_resolve(&resolved, ref);
+    }
+    else {
+        record[3] = EM_STRING(git_oid_tostr_s(git_reference_target(ref)));
+        retval = 0;
+    }
+
+    git_oid peeled;
+    if (retval == 0)
+        retval = snapshot_peel(&peeled, ctx, resolved ? resolved : ref);
+    git_reference_free(resolved);
+    if (retval == GIT_ENOTFOUND) {
+        giterr_clear();
+        *out = em_vector(env, record, 8);
+        return 0;
+    }
+    if (retval < 0)
+        return retval;
+    record[4] = EM_STRING(git_oid_tostr_s(&peeled));
+
+    if (ctx->time) {
+        git_time_t time;
+        retval = snapshot_commit_time(&time, ctx, &peeled);
+        if (retval < 0)
+            return retval;
+        record[7] = EM_INTEGER(time);
+    }
+
+    char *upstream = branch ? snapshot_upstream(ctx, name) : NULL;
+    if (upstream) {
+        record[5] = EM_STRING(upstream);
+
+        git_oid upstream_id;
+        if (ctx->ahead_behind && git_reference_name_to_id(&upstream_id, ctx->repo, upstream) == 0) {
+            size_t ahead, behind;
+            retval = snapshot_ahead_behind(&ahead, &behind, ctx, &peeled, &upstream_id);
+            if (retval == 0)
+                record[6] = em_cons(env, EM_INTEGER(ahead), EM_INTEGER(behind));
+        }
+        giterr_clear();
+        retval = 0;
+        free(upstream);
+    }
+
+    *out = em_vector(env, record, 8);
+    return 0;
+}
+
+EGIT_DOC(reference_snapshot, "REPO &optional GLOB COLUMNS",
+         "Return a vector describing every reference in REPO.\n"
+         "If GLOB is non-nil, only include references whose names match it.\n"
+         "The references database is iterated once, and each element is a\n"
+         "vector [NAME SHORTHAND KIND TARGET PEELED UPSTREAM AHEAD-BEHIND TIME]:\n\n"
+         "- KIND is one of the symbols `branch', `remote', `tag', `note' or `other'.\n"
+         "- TARGET is the target ID, or the target name for symbolic references.\n"
+         "- PEELED is the ID of the commit the reference peels to, or nil.\n"
+         "- UPSTREAM is the name of the upstream of a local branch, or nil.\n\n"
+         "COLUMNS is a list of optional columns to compute, otherwise nil:\n\n"
+         "- `ahead-behind': AHEAD-BEHIND is a cons cell (AHEAD . BEHIND)\n"
+         "      comparing a local branch with its upstream, as in\n"
+         "      `libgit-graph-ahead-behind'.\n"
+         "- `committer-time': TIME is the commit time of PEELED, in seconds.");
+emacs_value egit_reference_snapshot(emacs_env *env, emacs_value _repo, emacs_value _glob, emacs_value columns)
+{
+    EGIT_ASSERT_REPOSITORY(_repo);
+    EM_ASSERT_STRING_OR_NIL(_glob);
+
+    snapshot_ctx ctx;
+    memset(&ctx, 0, sizeof(snapshot_ctx));
+    ctx.repo = EGIT_EXTRACT(_repo);
+
+    if (em_assert_list(env, esym_nil, columns) < 0)
+        return esym_nil;
+    for (; em_consp(env, columns); columns = em_cdr(env, columns)) {
+        emacs_value column = em_car(env, columns);
+        if (EM_EQ(column, esym_ahead_behind)) ctx.ahead_behind = true;
+        else if (EM_EQ(column, esym_committer_time)) ctx.time = true;
+        else {
+            em_signal_wrong_value(env, column);
+            return esym_nil;
+        }
+    }
+
+    git_reference_iterator *iter;
+    int retval;
+    if (EM_EXTRACT_BOOLEAN(_glob)) {
+        char *glob = EM_EXTRACT_STRING(_glob);
+        retval = git_reference_iterator_glob_new(&iter, ctx.repo, glob);
+        free(glob);
+    }
+    else
+        retval = git_reference_iterator_new(&iter, ctx.repo);
+    EGIT_CHECK_ERROR(retval);
+
+    retval = git_repository_odb(&ctx.odb, ctx.repo);
+    if (retval < 0) {
+        git_reference_iterator_free(iter);
+        EGIT_CHECK_ERROR(retval);
+    }
+    if (git_repository_config_snapshot(&ctx.config, ctx.repo) < 0) {
+        giterr_clear();
+        ctx.config = NULL;
+    }
+    if (ctx.ahead_behind || ctx.time)
+        ctx.graph = egit_cgraph_get(ctx.repo);
+
+    size_t count = 0, alloc = 64;
+    emacs_value *values = (emacs_value*) malloc(alloc * sizeof(emacs_value));
+    bool quit = false;
+
+    git_reference *ref;
+    while ((retval = git_reference_next(&ref, iter)) == 0) {
+        if (count == alloc) {
+            alloc *= 2;
+            values = (emacs_value*) realloc(values, alloc * sizeof(emacs_value));
+        }
+        retval = snapshot_record(&values[count], env, &ctx, ref);
+        git_reference_free(ref);
+        if (retval < 0)
+            break;
+        if (++count % 256 == 0 && (quit = em_should_quit(env)))
+            break;
+    }
+    if (retval == GIT_ITEROVER)
+        retval = 0;
+
+    emacs_value ret = retval == 0 && !quit ? em_vector(env, values, count) : esym_nil;
+
+    free(values);
+    for (size_t i = 0; i < ctx.nremotes; i++) {
+        free(ctx.remotes[i].name);
+        git_remote_free(ctx.remotes[i].remote);
+    }
+    free(ctx.remotes);
+    git_config_free(ctx.config);
+    git_odb_free(ctx.odb);
+    git_reference_iterator_free(iter);
+
+    EGIT_CHECK_ERROR(retval);
+    return ret;
+}
@@ -40,4 +40,6 @@ EGIT_DEFUN(reference_foreach, emacs_value _repo, emacs_value func);
 EGIT_DEFUN(reference_foreach_glob, emacs_value _repo, emacs_value _glob, emacs_value func);
 EGIT_DEFUN(reference_foreach_name, emacs_value _repo, emacs_value func);
 
+EGIT_DEFUN(reference_snapshot, emacs_value _repo, emacs_value _glob, emacs_value columns);
+
 #endif /* EGIT_REFERENCE_H */
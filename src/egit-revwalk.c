@@ -1,3 +1,4 @@
+#include <regex.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -5,7 +6,9 @@
 
 #include "egit.h"
 #include "interface.h"
+#include "egit-pool.h"
 #include "egit-revwalk.h"
+#include "egit-search.h"
 
 
 // =============================================================================
@@ -178,6 +181,7 @@ emacs_value egit_revwalk_reset(emacs_env *env, emacs_value _revwalk)
     EGIT_ASSERT_REVWALK(_revwalk);
     git_revwalk *revwalk = EGIT_EXTRACT(_revwalk);
     git_revwalk_reset(revwalk);
+    egit_state_set((egit_object*) EM_EXTRACT_USER_PTR(_revwalk), NULL, NULL);
     return esym_nil;
 }
 
@@ -208,6 +212,377 @@ emacs_value egit_revwalk_sorting(emacs_env *env, emacs_value _revwalk, emacs_val
 }
 
 
+// =============================================================================
+// Filters
+
+/**
+ * A declarative filter on the commits produced by a walk.
+ * Negative values of max_count and max_parents mean no limit.
+ */
+typedef struct {
+    git_repository *repo;
+    intmax_t max_count;
+    bool has_since, has_until;
+    intmax_t since, until;
+    char *author, *committer;
+    bool ignore_case;
+    intmax_t min_parents, max_parents;
+    bool first_parent;
+    intmax_t count;
+
+    // Compiled from author and committer once parsing is done
+    bool has_author, has_committer;
+    egit_search_pattern author_pattern, committer_pattern;
+    egit_search_buf scratch;
+} revwalk_filter;
+
+static void revwalk_filter_dispose(revwalk_filter *filter)
+{
+    if (filter->has_author)
+        egit_search_pattern_dispose(&filter->author_pattern);
+    if (filter->has_committer)
+        egit_search_pattern_dispose(&filter->committer_pattern);
+    free(filter->scratch.ptr);
+    free(filter->author);
+    free(filter->committer);
+}
+
+/**
+ * Compile an author or committer regexp, like git does for --author.
+ */
+static bool revwalk_filter_compile(
+    bool *has, egit_search_pattern *pattern, revwalk_filter *filter, const char *regexp)
+{
+    if (!regexp)
+        return true;
+    *has = egit_search_pattern_init(pattern, regexp, true, filter->ignore_case, REG_NEWLINE | REG_NOSUB);
+    return *has;
+}
+
+static bool revwalk_filter_parse(
+    revwalk_filter *filter, emacs_env *env, emacs_value spec, git_repository *repo)
+{
+    memset(filter, 0, sizeof(revwalk_filter));
+    filter->repo = repo;
+    filter->max_count = -1;
+    filter->max_parents = -1;
+
+    for (; em_consp(env, spec); spec = em_cdr(env, spec)) {
+        emacs_value cell = em_car(env, spec);
+        if (!em_assert(env, esym_consp, cell))
+            goto error;
+        emacs_value key = em_car(env, cell), value = em_cdr(env, cell);
+
+        if (EM_EQ(key, esym_author) || EM_EQ(key, esym_committer)) {
+            if (!em_assert(env, esym_stringp, value))
+                goto error;
+            char **field = EM_EQ(key, esym_author) ? &filter->author : &filter->committer;
+            free(*field);
+            *field = EM_EXTRACT_STRING(value);
+        }
+        else if (EM_EQ(key, esym_ignore_case))
+            filter->ignore_case = EM_EXTRACT_BOOLEAN(value);
+        else if (EM_EQ(key, esym_first_parent))
+            filter->first_parent = EM_EXTRACT_BOOLEAN(value);
+        else if (EM_EQ(key, esym_max_count) || EM_EQ(key, esym_since) || EM_EQ(key, esym_until) ||
+                 EM_EQ(key, esym_min_parents) || EM_EQ(key, esym_max_parents)) {
+            if (!em_assert(env, esym_integerp, value))
+                goto error;
+            intmax_t n = EM_EXTRACT_INTEGER(value);
+            if (EM_EQ(key, esym_max_count)) filter->max_count = n;
+            else if (EM_EQ(key, esym_min_parents)) filter->min_parents = n;
+            else if (EM_EQ(key, esym_max_parents)) filter->max_parents = n;
+            else if (EM_EQ(key, esym_since)) {
+                filter->has_since = true;
+                filter->since = n;
+            }
+            else {
+                filter->has_until = true;
+                filter->until = n;
+            }
+        }
+        else {
+            em_signal_wrong_value(env, key);
+            goto error;
+        }
+    }
+
+    if (EM_EXTRACT_BOOLEAN(spec)) {
+        em_signal_wrong_type(env, esym_listp, spec);
+        goto error;
+    }
+
+    if (!revwalk_filter_compile(&filter->has_author, &filter->author_pattern, filter,
+                                filter->author)) {
+        em_signal_wrong_value(env, EM_STRING(filter->author));
+        goto error;
+    }
+    if (!revwalk_filter_compile(&filter->has_committer, &filter->committer_pattern, filter,
+                                filter->committer)) {
+        em_signal_wrong_value(env, EM_STRING(filter->committer));
+        goto error;
+    }
+    return true;
+
+  error:
+    revwalk_filter_dispose(filter);
+    return false;
+}
+
+/**
+ * Match SIG against PATTERN somewhere in "Name <email>", like git.
+ */
+static bool revwalk_filter_ident(
+    revwalk_filter *filter, const git_signature *sig, bool has, const egit_search_pattern *pattern)
+{
+    if (!has)
+        return true;
+
+    size_t len = strlen(sig->name) + strlen(sig->email) + 4;
+    char *ident = (char*) malloc(len);
+    snprintf(ident, len, "%s <%s>", sig->name, sig->email);
+    bool match = egit_search_match(pattern, &filter->scratch, ident, len - 1);
+    free(ident);
+    return match;
+}
+
+/**
+ * Return true if FILTER needs the commit object to decide on a commit.
+ */
+static bool revwalk_filter_needs_commit(revwalk_filter *filter)
+{
+    return filter->has_since || filter->has_until || filter->author || filter->committer ||
+        filter->min_parents > 0 || filter->max_parents >= 0 || filter->first_parent;
+}
+
+static bool revwalk_filter_match(revwalk_filter *filter, git_commit *commit)
+{
+    intmax_t nparents = git_commit_parentcount(commit);
+    git_time_t time = git_commit_time(commit);
+    return nparents >= filter->min_parents &&
+        (filter->max_parents < 0 || nparents <= filter->max_parents) &&
+        (!filter->has_since || time >= filter->since) &&
+        (!filter->has_until || time <= filter->until) &&
+        revwalk_filter_ident(filter, git_commit_author(commit),
+                             filter->has_author, &filter->author_pattern) &&
+        revwalk_filter_ident(filter, git_commit_committer(commit),
+                             filter->has_committer, &filter->committer_pattern);
+}
+
+
+// =============================================================================
+// Filter state
+
+/**
+ * Number of consecutive commits older than the since date that must be seen,
+ * with no younger commits pending, before a walk is cut short. Same as git.
+ */
+#define REVWALK_SLOP 5
+
+enum {
+    REVWALK_WALKED = 1 << 0,    // Returned by the walker
+    REVWALK_PARENT = 1 << 1,    // Parent of a walked commit
+    REVWALK_FOLLOWED = 1 << 2,  // Parent followed from a walked commit
+    REVWALK_DATED = 1 << 3,     // Commit time compared to the since date
+    REVWALK_YOUNG = 1 << 4      // Not older than the since date
+};
+
+typedef struct {
+    git_oid oid;
+    unsigned flags;
+} revwalk_mark;
+
+/**
+ * The state of the first-parent and since filters on a walker. It is kept on
+ * the wrapper of the walker for as long as the walk lasts, so that a walk
+ * paged through with `libgit-revwalk-next-n' produces the same commits as an
+ * uninterrupted one. Unlike `git_revwalk_simplify_first_parent' and hide
+ * callbacks, this doesn't change the walker itself.
+ */
+typedef struct {
+    revwalk_mark *marks;
+    size_t size, used;
+    size_t young_pending, old_streak;
+    bool order_broken;
+
+    // The filter settings the marks were computed for
+    bool first_parent, has_since;
+    intmax_t since;
+} revwalk_state;
+
+static size_t revwalk_mark_slot(revwalk_state *state, const git_oid *oid)
+{
+    size_t hash;
+    memcpy(&hash, oid->id, sizeof(hash));
+    size_t i = hash & (state->size - 1);
+    while (state->marks[i].flags && !git_oid_equal(&state->marks[i].oid, oid))
+        i = (i + 1) & (state->size - 1);
+    return i;
+}
+
+/**
+ * Add FLAGS to the marks of OID, and return the marks it had before.
+ */
+static unsigned revwalk_mark_set(revwalk_state *state, const git_oid *oid, unsigned flags)
+{
+    if (2 * (state->used + 1) > state->size) {
+        revwalk_mark *old = state->marks;
+        size_t oldsize = state->size;
+        state->size = oldsize ? 2 * oldsize : 256;
+        state->marks = (revwalk_mark*) calloc(state->size, sizeof(revwalk_mark));
+        for (size_t i = 0; i < oldsize; i++)
+            if (old[i].flags)
+                state->marks[revwalk_mark_slot(state, &old[i].oid)] = old[i];
+        free(old);
+    }
+
+    revwalk_mark *mark = &state->marks[revwalk_mark_slot(state, oid)];
+    unsigned prev = mark->flags;
+    if (!prev) {
+        git_oid_cpy(&mark->oid, oid);
+        state->used++;
+    }
+    mark->flags |= flags;
+    return prev;
+}
+
+static void revwalk_state_free(void *_state)
+{
+    revwalk_state *state = (revwalk_state*) _state;
+    free(state->marks);
+    free(state);
+}
+
+/**
+ * Get the state for FILTER on the walker with wrapper WRAPPER. A state left by
+ * a previous call with different first-parent or since settings is dropped,
+ * since its marks don't apply, and a fresh one is started. Calls without
+ * either setting drop it as well, see revwalk_filter_next.
+ */
+static revwalk_state *revwalk_state_get(egit_object *wrapper, revwalk_filter *filter)
+{
+    revwalk_state *state = (revwalk_state*) egit_state_get(wrapper, revwalk_state_free);
+    if (state && state->first_parent == filter->first_parent &&
+        state->has_since == filter->has_since && state->since == filter->since)
+        return state;
+
+    state = (revwalk_state*) calloc(1, sizeof(revwalk_state));
+    state->first_parent = filter->first_parent;
+    state->has_since = filter->has_since;
+    state->since = filter->since;
+    egit_state_set(wrapper, state, revwalk_state_free);
+    return state;
+}
+
+/**
+ * Record COMMIT, just returned by the walker, in STATE.
+ * Set FOLLOWED to whether COMMIT is on a followed line of history,
+ * and STOP to whether the rest of the walk can only produce commits
+ * older than the since date of FILTER.
+ */
+static int revwalk_state_update(
+    bool *followed, bool *stop, revwalk_state *state, revwalk_filter *filter,
+    git_commit *commit)
+{
+    unsigned flags = revwalk_mark_set(state, git_commit_id(commit), REVWALK_WALKED);
+    *followed = !filter->first_parent || !(flags & REVWALK_PARENT) || (flags & REVWALK_FOLLOWED);
+    *stop = false;
+    if (flags & REVWALK_YOUNG)
+        state->young_pending--;
+
+    size_t nparents = git_commit_parentcount(commit);
+    for (size_t i = 0; i < nparents; i++) {
+        const git_oid *parent = git_commit_parent_id(commit, i);
+        bool follow = *followed && (!filter->first_parent || i == 0);
+        unsigned pflags = revwalk_mark_set(
+            state, parent, REVWALK_PARENT | (follow ? REVWALK_FOLLOWED : 0));
+
+        // A parent coming before its child means the walk is not in
+        // (roughly) reverse chronological order, so we can never stop early
+        if (pflags & REVWALK_WALKED) {
+            state->order_broken = true;
+            continue;
+        }
+        if (!follow || !filter->has_since || (pflags & REVWALK_DATED))
+            continue;
+
+        git_commit *pcommit;
+        int retval = git_commit_lookup(&pcommit, filter->repo, parent);
+        if (retval < 0)
+            return retval;
+        bool young = git_commit_time(pcommit) >= filter->since;
+        git_commit_free(pcommit);
+        revwalk_mark_set(state, parent, REVWALK_DATED | (young ? REVWALK_YOUNG : 0));
+        if (young)
+            state->young_pending++;
+    }
+
+    if (filter->has_since && *followed) {
+        if (git_commit_time(commit) >= filter->since)
+            state->old_streak = 0;
+        else
+            state->old_streak++;
+        *stop = !state->order_broken && state->young_pending == 0 &&
+            state->old_streak >= REVWALK_SLOP;
+    }
+    return 0;
+}
+
+/**
+ * Get the next commit from the walker with wrapper WRAPPER that passes FILTER.
+ * If the since date of FILTER ends the walk early, the walker is reset, as it
+ * would be at the end of the walk.
+ */
+static int revwalk_filter_next(git_oid *out, egit_object *wrapper, revwalk_filter *filter)
+{
+    if (filter->max_count >= 0 && filter->count >= filter->max_count)
+        return GIT_ITEROVER;
+
+    git_revwalk *walk = wrapper->ptr;
+    revwalk_state *state = NULL;
+    if (filter->first_parent || filter->has_since)
+        state = revwalk_state_get(wrapper, filter);
+    else if (egit_state_get(wrapper, revwalk_state_free))
+        egit_state_set(wrapper, NULL, NULL);
+
+    while (true) {
+        int retval = git_revwalk_next(out, walk);
+        if (retval == GIT_ITEROVER)
+            egit_state_set(wrapper, NULL, NULL);
+        if (retval < 0)
+            return retval;
+
+        if (!revwalk_filter_needs_commit(filter)) {
+            filter->count++;
+            return 0;
+        }
+
+        git_commit *commit;
+        retval = git_commit_lookup(&commit, filter->repo, out);
+        if (retval < 0)
+            return retval;
+
+        bool followed = true, stop = false;
+        if (state)
+            retval = revwalk_state_update(&followed, &stop, state, filter, commit);
+        bool match = retval == 0 && followed && revwalk_filter_match(filter, commit);
+        git_commit_free(commit);
+
+        if (retval < 0)
+            return retval;
+        if (stop) {
+            egit_state_set(wrapper, NULL, NULL);
+            git_revwalk_reset(walk);
+            return GIT_ITEROVER;
+        }
+        if (match) {
+            filter->count++;
+            return 0;
+        }
+    }
+}
+
+
 // =============================================================================
 // Foreach
 
@@ -233,33 +608,54 @@ static int revwalk_hide_callback(const git_oid *oid, void *payload)
     return EM_EXTRACT_BOOLEAN(retval);
 }
 
-EGIT_DOC(revwalk_foreach, "REVWALK FUNC &optional HIDE-PRED",
+EGIT_DOC(revwalk_foreach, "REVWALK FUNC &optional HIDE-PRED FILTER",
          "Walk through the revision walker REVWALK.\n"
          "FUNC will be called for each commit in order, with the\n"
          "commit ID as its only argument.\n\n"
          "If HIDE-PRED is given, it must be a function taking a\n"
          "commit ID as its only argument, returning non-nil if\n"
-         "that commit and its parents should be hidden.");
+         "that commit and its parents should be hidden.\n\n"
+         "FILTER is an alist of conditions evaluated natively, without\n"
+         "calling into Lisp for each commit. The keys are:\n"
+         "- `max-count': stop after this many commits\n"
+         "- `since', `until': only commits with a commit time (in seconds\n"
+         "  since the epoch) not before or not after this. Like git, the walk\n"
+         "  ends once only commits older than `since' are left.\n"
+         "- `author', `committer': a basic regular expression to match\n"
+         "  somewhere in \"Name <email>\", like `git log --author'\n"
+         "- `ignore-case': if non-nil, match `author' and `committer'\n"
+         "  regardless of case\n"
+         "- `min-parents', `max-parents': bounds on the number of parents,\n"
+         "  for example (max-parents . 1) to leave out merges\n"
+         "- `first-parent': if non-nil, follow only first parents. This only\n"
+         "  hides the commits on side branches, the walker still visits them,\n"
+         "  so it costs as much as a full walk. When the walker is not used\n"
+         "  for anything else, `libgit-revwalk-simplify-first-parent' is\n"
+         "  cheaper, since it keeps side branches out of the walk.");
 emacs_value egit_revwalk_foreach(
-    emacs_env *env, emacs_value _revwalk, emacs_value func, emacs_value hide_pred)
+    emacs_env *env, emacs_value _revwalk, emacs_value func, emacs_value hide_pred,
+    emacs_value _filter)
 {
     EGIT_ASSERT_REVWALK(_revwalk);
     EM_ASSERT_FUNCTION(func);
+    if (EM_EXTRACT_BOOLEAN(hide_pred))
+        EM_ASSERT_FUNCTION(hide_pred);
 
     git_revwalk *revwalk = EGIT_EXTRACT(_revwalk);
+    egit_object *wrapper = (egit_object*) EM_EXTRACT_USER_PTR(_revwalk);
 
-    hide_context *ctx = NULL;
-    if (EM_EXTRACT_BOOLEAN(hide_pred)) {
-        EM_ASSERT_FUNCTION(hide_pred);
-        ctx = malloc(sizeof(hide_context));
-        *ctx = (hide_context) {env, hide_pred};
-        git_revwalk_add_hide_cb(revwalk, &revwalk_hide_callback, ctx);
-    }
+    revwalk_filter filter;
+    if (!revwalk_filter_parse(&filter, env, _filter, git_revwalk_repository(revwalk)))
+        return esym_nil;
+    hide_context ctx = {env, hide_pred};
+    if (EM_EXTRACT_BOOLEAN(hide_pred))
+        git_revwalk_add_hide_cb(revwalk, &revwalk_hide_callback, &ctx);
 
     // Since both the hide callback and the main function may trigger errors,
     // we must check for non-local exits on both ends of the loop body
     git_oid oid;
-    while (GIT_ITEROVER != git_revwalk_next(&oid, revwalk)) {
+    int retval;
+    while ((retval = revwalk_filter_next(&oid, wrapper, &filter)) == 0) {
         if (env->non_local_exit_check(env))
             goto cleanup;
 
@@ -272,8 +668,311 @@ emacs_value egit_revwalk_foreach(
     }
 
   cleanup:
-    free(ctx);
-    git_revwalk_add_hide_cb(revwalk, NULL, NULL);
+    if (EM_EXTRACT_BOOLEAN(hide_pred))
+        git_revwalk_add_hide_cb(revwalk, NULL, NULL);
     git_revwalk_reset(revwalk);
+    egit_state_set(wrapper, NULL, NULL);
+    revwalk_filter_dispose(&filter);
+    if (retval != GIT_ITEROVER && !env->non_local_exit_check(env))
+        EGIT_CHECK_ERROR(retval);
     return esym_nil;
 }
+
+
+// =============================================================================
+// Stepping
+
+EGIT_DOC(revwalk_next, "REVWALK",
+         "Return the ID of the next commit in REVWALK, or nil if there are none.\n"
+         "Unlike `libgit-revwalk-foreach', the walker is not reset, so subsequent\n"
+         "calls continue where the previous one left off.");
+emacs_value egit_revwalk_next(emacs_env *env, emacs_value _revwalk)
+{
+    EGIT_ASSERT_REVWALK(_revwalk);
+    git_revwalk *revwalk = EGIT_EXTRACT(_revwalk);
+
+    git_oid oid;
+    int retval = git_revwalk_next(&oid, revwalk);
+    if (retval == GIT_ITEROVER) {
+        egit_state_set((egit_object*) EM_EXTRACT_USER_PTR(_revwalk), NULL, NULL);
+        return esym_nil;
+    }
+    EGIT_CHECK_ERROR(retval);
+
+    const char *oid_s = git_oid_tostr_s(&oid);
+    return EM_STRING(oid_s);
+}
+
+EGIT_DOC(revwalk_next_n, "REVWALK N &optional FILTER",
+         "Return a vector with the IDs of the next N commits in REVWALK.\n"
+         "The vector is shorter than N if the walk is exhausted, and empty if\n"
+         "there are no more commits. The walker is not reset, so subsequent\n"
+         "calls continue where the previous one left off.\n\n"
+         "If FILTER is given, only commits matching it are counted and\n"
+         "returned. See `libgit-revwalk-foreach' for its format. Its\n"
+         "`max-count' applies to this call only. The state of `first-parent'\n"
+         "and `since' carries over between calls with the same values, and\n"
+         "starts afresh when they change.");
+emacs_value egit_revwalk_next_n(
+    emacs_env *env, emacs_value _revwalk, emacs_value _n, emacs_value _filter)
+{
+    EGIT_ASSERT_REVWALK(_revwalk);
+    EM_ASSERT_INTEGER(_n);
+
+    git_revwalk *revwalk = EGIT_EXTRACT(_revwalk);
+    egit_object *wrapper = (egit_object*) EM_EXTRACT_USER_PTR(_revwalk);
+    intmax_t n = EM_EXTRACT_INTEGER(_n);
+    if (n < 0) {
+        em_signal_args_out_of_range(env, n);
+        return esym_nil;
+    }
+
+    revwalk_filter filter;
+    if (!revwalk_filter_parse(&filter, env, _filter, git_revwalk_repository(revwalk)))
+        return esym_nil;
+
+    // Don't trust N for the initial allocation, it may be much larger than the walk
+    size_t alloc = n < 256 ? (n > 0 ? n : 1) : 256, count = 0;
+    emacs_value *oids = (emacs_value*) malloc(alloc * sizeof(emacs_value));
+
+    git_oid oid;
+    int retval = 0;
+    while ((intmax_t) count < n) {
+        retval = revwalk_filter_next(&oid, wrapper, &filter);
+        if (retval < 0)
+            break;
+
+        if (count == alloc) {
+            alloc *= 2;
+            oids = (emacs_value*) realloc(oids, alloc * sizeof(emacs_value));
+        }
+        const char *oid_s = git_oid_tostr_s(&oid);
+        oids[count++] = EM_STRING(oid_s);
+    }
+
+    revwalk_filter_dispose(&filter);
+
+    if (retval < 0 && retval != GIT_ITEROVER) {
+        free(oids);
+        EGIT_CHECK_ERROR(retval);
+    }
+
+    emacs_value ret = em_vector(env, oids, count);
+    free(oids);
+    return ret;
+}
+
+
+// =============================================================================
+// Searching
+
+// Number of commits handed to the worker pool at a time
+#define SEARCH_BATCH 512
+
+typedef enum {
+    SEARCH_MESSAGE = 1,
+    SEARCH_AUTHOR = 2,
+    SEARCH_COMMITTER = 4
+} search_field;
+
+typedef struct {
+    int fields;
+    egit_search_pattern pattern;
+    const char *repo_path;
+
+    git_oid *oids;
+    bool *matches;
+} search_ctx;
+
+typedef struct {
+    git_odb *odb;
+    egit_search_buf buf;
+} search_worker;
+
+/**
+ * Match an author or committer header line. Like git, the timestamp is not
+ * part of the match, so only "Name <email>" is searched.
+ */
+static bool search_match_ident(
+    const search_ctx *ctx, search_worker *worker, const char *line, size_t len)
+{
+    const char *end = line + len;
+    while (end > line && end[-1] != '>')
+        end--;
+    return egit_search_match(&ctx->pattern, &worker->buf, line,
+                             end > line ? (size_t) (end - line) : len);
+}
+
+static int search_worker_init(void **state, void *payload)
+{
+    search_ctx *ctx = (search_ctx*) payload;
+    search_worker *worker = (search_worker*) calloc(1, sizeof(search_worker));
+    *state = worker;
+
+    git_repository *repo;
+    int retval = git_repository_open(&repo, ctx->repo_path);
+    if (retval < 0)
+        return retval;
+    retval = git_repository_odb(&worker->odb, repo);
+    git_repository_free(repo);
+    return retval;
+}
+
+static void search_worker_free(void *state, void *payload)
+{
+    (void) payload;
+    search_worker *worker = (search_worker*) state;
+    if (!worker)
+        return;
+    git_odb_free(worker->odb);
+    free(worker->buf.ptr);
+    free(worker);
+}
+
+/**
+ * Search the raw buffer of a commit, without parsing it into a git_commit.
+ */
+static int search_task(size_t index, void *state, void *payload)
+{
+    search_ctx *ctx = (search_ctx*) payload;
+    search_worker *worker = (search_worker*) state;
+
+    git_odb_object *obj;
+    int retval = git_odb_read(&obj, worker->odb, &ctx->oids[index]);
+    if (retval < 0)
+        return retval;
+
+    const char *data = (const char*) git_odb_object_data(obj);
+    const char *end = data + git_odb_object_size(obj);
+    bool match = false;
+
+    // Header lines up to the first empty line, then the message
+    const char *line = data;
+    while (!match && line < end && *line != '\n') {
+        const char *eol = memchr(line, '\n', end - line);
+        if (!eol)
+            eol = end;
+        size_t len = eol - line;
+
+        if ((ctx->fields & SEARCH_AUTHOR) && len > 7 && memcmp(line, "author ", 7) == 0)
+            match = search_match_ident(ctx, worker, line + 7, len - 7);
+        else if ((ctx->fields & SEARCH_COMMITTER) && len > 10 && memcmp(line, "committer ", 10) == 0)
+            match = search_match_ident(ctx, worker, line + 10, len - 10);
+        line = eol + 1;
+    }
+
+    if (!match && (ctx->fields & SEARCH_MESSAGE) && line < end)
+        match = egit_search_match(&ctx->pattern, &worker->buf, line + 1, end - line - 1);
+
+    ctx->matches[index] = match;
+    git_odb_object_free(obj);
+    return 0;
+}
+
+static bool search_fields_parse(int *out, emacs_env *env, emacs_value list)
+{
+    *out = SEARCH_MESSAGE;
+    if (!EM_EXTRACT_BOOLEAN(list))
+        return true;
+    if (em_assert_list(env, esym_nil, list) < 0)
+        return false;
+
+    *out = 0;
+    for (; em_consp(env, list); list = em_cdr(env, list)) {
+        emacs_value sym = em_car(env, list);
+        if (EM_EQ(sym, esym_message)) *out |= SEARCH_MESSAGE;
+        else if (EM_EQ(sym, esym_author)) *out |= SEARCH_AUTHOR;
+        else if (EM_EQ(sym, esym_committer)) *out |= SEARCH_COMMITTER;
+        else {
+            em_signal_wrong_value(env, sym);
+            return false;
+        }
+    }
+    return true;
+}
+
+EGIT_DOC(revwalk_search, "REVWALK PATTERN &optional FIELDS REGEXP IGNORE-CASE LIMIT",
+         "Return a vector of the IDs of commits in REVWALK matching PATTERN.\n"
+         "FIELDS is a list of symbols among `message' (the default), `author'\n"
+         "and `committer', and a commit matches if PATTERN is found in any of\n"
+         "them. Authors and committers are matched as \"Name <email>\".\n\n"
+         "PATTERN is a fixed string, or a basic regular expression if REGEXP is\n"
+         "non-nil. If IGNORE-CASE is non-nil, the search is case-insensitive.\n"
+         "The commits are searched on a pool of threads.\n\n"
+         "The revwalk is not reset, so subsequent calls return the next page\n"
+         "of results. Commits are searched in batches, and the search stops at\n"
+         "the end of the first batch with at least LIMIT matches, so more than\n"
+         "LIMIT IDs may be returned. The next call resumes right after them.");
+emacs_value egit_revwalk_search(
+    emacs_env *env, emacs_value _revwalk, emacs_value _pattern, emacs_value _fields,
+    emacs_value regexp, emacs_value ignore_case, emacs_value _limit)
+{
+    EGIT_ASSERT_REVWALK(_revwalk);
+    EM_ASSERT_STRING(_pattern);
+    intmax_t limit = -1;
+    if (EM_EXTRACT_BOOLEAN(_limit)) {
+        EM_ASSERT_INTEGER(_limit);
+        limit = EM_EXTRACT_INTEGER(_limit);
+    }
+
+    search_ctx ctx;
+    if (!search_fields_parse(&ctx.fields, env, _fields))
+        return esym_nil;
+
+    git_revwalk *walk = EGIT_EXTRACT(_revwalk);
+    egit_object *wrapper = (egit_object*) EM_EXTRACT_USER_PTR(_revwalk);
+    ctx.repo_path = git_repository_path(git_revwalk_repository(walk));
+
+    char *needle = EM_EXTRACT_STRING(_pattern);
+    if (!egit_search_pattern_init(&ctx.pattern, needle, EM_EXTRACT_BOOLEAN(regexp),
+                                  EM_EXTRACT_BOOLEAN(ignore_case), REG_NEWLINE | REG_NOSUB)) {
+        free(needle);
+        em_signal_wrong_value(env, _pattern);
+        return esym_nil;
+    }
+
+    ctx.oids = (git_oid*) malloc(SEARCH_BATCH * sizeof(git_oid));
+    ctx.matches = (bool*) malloc(SEARCH_BATCH * sizeof(bool));
+    egit_pool *pool = egit_pool_new(0, search_worker_init, search_task, search_worker_free, &ctx);
+
+    size_t alloc = 64, count = 0;
+    emacs_value *ids = (emacs_value*) malloc(alloc * sizeof(emacs_value));
+    bool done = limit == 0;
+    int retval = 0;
+
+    while (!done && retval == 0) {
+        size_t n;
+        retval = egit_search_next_batch(ctx.oids, SEARCH_BATCH, &n, &done, wrapper);
+        if (retval < 0 || (retval = egit_pool_run(pool, n)) < 0)
+            break;
+
+        for (size_t i = 0; i < n; i++) {
+            if (!ctx.matches[i])
+                continue;
+            if (count == alloc) {
+                alloc *= 2;
+                ids = (emacs_value*) realloc(ids, alloc * sizeof(emacs_value));
+            }
+            const char *oid_s = git_oid_tostr_s(&ctx.oids[i]);
+            ids[count++] = EM_STRING(oid_s);
+        }
+
+        if ((limit >= 0 && (intmax_t) count >= limit) || em_should_quit(env))
+            done = true;
+    }
+
+    egit_pool_free(pool);
+    free(ctx.matches);
+    free(ctx.oids);
+    egit_search_pattern_dispose(&ctx.pattern);
+    free(needle);
+
+    if (retval < 0) {
+        free(ids);
+        EGIT_CHECK_ERROR(retval);
+    }
+
+    emacs_value ret = em_vector(env, ids, count);
+    free(ids);
+    return ret;
+}
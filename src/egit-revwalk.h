@@ -21,6 +21,13 @@ EGIT_DEFUN(revwalk_reset, emacs_value _revwalk);
 EGIT_DEFUN(revwalk_simplify_first_parent, emacs_value _revwalk);
 EGIT_DEFUN(revwalk_sorting, emacs_value _revwalk, emacs_value _mode);
 
-EGIT_DEFUN(revwalk_foreach, emacs_value _revwalk, emacs_value _func, emacs_value _hide_pred);
+EGIT_DEFUN(revwalk_foreach, emacs_value _revwalk, emacs_value _func, emacs_value _hide_pred,
+           emacs_value _filter);
+
+EGIT_DEFUN(revwalk_next, emacs_value _revwalk);
+EGIT_DEFUN(revwalk_next_n, emacs_value _revwalk, emacs_value _n, emacs_value _filter);
+
+EGIT_DEFUN(revwalk_search, emacs_value _revwalk, emacs_value _pattern, emacs_value _fields,
+           emacs_value regexp, emacs_value ignore_case, emacs_value _limit);
 
 #endif /* EGIT_REVWALK_H */
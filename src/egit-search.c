@@ -0,0 +1,119 @@
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "git2.h"
+
+#include "egit-search.h"
+
+
+// =============================================================================
+// Helpers
+
+/**
+ * Return the position of the first occurrence of the needle in BUF at or
+ * after START, or LEN if there is none.
+ */
+static size_t search_find(
+    const egit_search_pattern *pattern, const char *buf, size_t start, size_t len)
+{
+    const unsigned char *needle = (const unsigned char*) pattern->needle;
+    const unsigned char *hay = (const unsigned char*) buf;
+    const unsigned char *fold = pattern->fold;
+    size_t m = pattern->needle_len;
+    if (m == 0)
+        return start;
+
+    for (size_t pos = start; pos + m <= len; pos += pattern->skip[fold[hay[pos + m - 1]]]) {
+        size_t i = m;
+        while (i > 0 && fold[hay[pos + i - 1]] == fold[needle[i - 1]])
+            i--;
+        if (i == 0)
+            return pos;
+    }
+    return len;
+}
+
+
+// =============================================================================
+// Patterns
+
+bool egit_search_pattern_init(
+    egit_search_pattern *pattern, const char *needle, bool regexp, bool icase, int regex_flags)
+{
+    pattern->regexp = regexp;
+    pattern->needle = needle;
+    pattern->needle_len = strlen(needle);
+
+    if (regexp)
+        return regcomp(&pattern->regex, needle, regex_flags | (icase ? REG_ICASE : 0)) == 0;
+
+    for (int c = 0; c < 256; c++)
+        pattern->fold[c] = icase ? tolower(c) : c;
+
+    size_t m = pattern->needle_len;
+    for (size_t i = 0; i < 256; i++)
+        pattern->skip[i] = m;
+    for (size_t i = 0; i + 1 < m; i++)
+        pattern->skip[pattern->fold[(unsigned char) needle[i]]] = m - 1 - i;
+    return true;
+}
+
+void egit_search_pattern_dispose(egit_search_pattern *pattern)
+{
+    if (pattern->regexp)
+        regfree(&pattern->regex);
+}
+
+
+// =============================================================================
+// Matching
+
+size_t egit_search_count(const egit_search_pattern *pattern, const char *buf, size_t len)
+{
+    size_t m = pattern->needle_len, count = 0, pos = 0;
+    if (m == 0)
+        return 0;
+
+    while ((pos = search_find(pattern, buf, pos, len)) < len) {
+        count++;
+        pos += m;
+    }
+    return count;
+}
+
+bool egit_search_match(
+    const egit_search_pattern *pattern, egit_search_buf *scratch, const char *buf, size_t len)
+{
+    if (!pattern->regexp)
+        return pattern->needle_len == 0 || search_find(pattern, buf, 0, len) < len;
+
+    if (len + 1 > scratch->alloc) {
+        scratch->alloc = len + 1;
+        scratch->ptr = (char*) realloc(scratch->ptr, scratch->alloc);
+    }
+    memcpy(scratch->ptr, buf, len);
+    scratch->ptr[len] = '\0';
+    return regexec(&pattern->regex, scratch->ptr, 0, NULL, 0) == 0;
+}
+
+
+// =============================================================================
+// Batches
+
+int egit_search_next_batch(
+    git_oid *oids, size_t n, size_t *count, bool *exhausted, egit_object *walk)
+{
+    int retval = 0;
+    *count = 0;
+    *exhausted = false;
+    while (*count < n && (retval = git_revwalk_next(&oids[*count], walk->ptr)) == 0)
+        (*count)++;
+
+    if (retval == GIT_ITEROVER) {
+        egit_state_set(walk, NULL, NULL);
+        *exhausted = true;
+        return 0;
+    }
+    return retval;
+}
@@ -0,0 +1,75 @@
+#include <regex.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "git2.h"
+
+#include "egit.h"
+
+#ifndef EGIT_SEARCH_H
+#define EGIT_SEARCH_H
+
+/**
+ * A search pattern, either a fixed string found with the Boyer-Moore-Horspool
+ * algorithm, or a POSIX regular expression. A pattern is read-only once
+ * initialized, so it can be shared between the workers of a pool.
+ */
+typedef struct {
+    bool regexp;
+    const char *needle;
+    size_t needle_len;
+    unsigned char fold[256];
+    size_t skip[256];
+    regex_t regex;
+} egit_search_pattern;
+
+/**
+ * Scratch space for matching a regexp, which needs a NUL-terminated string.
+ * Each worker has its own. Zero-initialize it, and free PTR when done.
+ */
+typedef struct {
+    char *ptr;
+    size_t alloc;
+} egit_search_buf;
+
+/**
+ * Initialize a search pattern.
+ * @param pattern The pattern to initialize.
+ * @param needle The string or regexp, which must outlive the pattern.
+ * @param regexp If true, compile NEEDLE as a regexp with REGEX_FLAGS.
+ * @param icase If true, ignore (ASCII) case.
+ * @param regex_flags Flags for regcomp, REG_ICASE is added with ICASE.
+ * @return False if NEEDLE is not a valid regexp.
+ */
+bool egit_search_pattern_init(
+    egit_search_pattern *pattern, const char *needle, bool regexp, bool icase, int regex_flags);
+
+/**
+ * Free the resources held by a search pattern.
+ */
+void egit_search_pattern_dispose(egit_search_pattern *pattern);
+
+/**
+ * Count the non-overlapping occurrences of a fixed string pattern in BUF.
+ */
+size_t egit_search_count(const egit_search_pattern *pattern, const char *buf, size_t len);
+
+/**
+ * Return true if PATTERN matches somewhere in BUF.
+ */
+bool egit_search_match(
+    const egit_search_pattern *pattern, egit_search_buf *scratch, const char *buf, size_t len);
+
+/**
+ * Read the next batch of up to N commits from a walker, to be searched on a pool.
+ * When the walk ends, any state kept on the walker is dropped.
+ * @param oids Where to store the commit IDs.
+ * @param count Where to store the number of commits read.
+ * @param exhausted Set to true if the walk has ended.
+ * @param walk The wrapper of the walker.
+ * @return Zero, or a negative error code from the walker.
+ */
+int egit_search_next_batch(
+    git_oid *oids, size_t n, size_t *count, bool *exhausted, egit_object *walk);
+
+#endif /* EGIT_SEARCH_H */
@@ -50,10 +50,22 @@ emacs_value egit_tree_lookup_prefix(emacs_env *env, emacs_value _repo, emacs_val
 // =============================================================================
 // Getters
 
-EGIT_DOC(tree_entry_byid, "TREE ID",
+/**
+ * Return an entry borrowed from the tree _TREE, either as a list or as an
+ * opaque tree entry keeping the tree alive.
+ */
+static emacs_value tree_entry_borrowed(
+    emacs_env *env, const git_tree_entry *entry, emacs_value _tree, emacs_value opaque)
+{
+    if (EM_EXTRACT_BOOLEAN(opaque))
+        return egit_wrap(env, EGIT_TREE_ENTRY, entry, EM_EXTRACT_USER_PTR(_tree));
+    return egit_tree_entry_to_emacs(env, entry);
+}
+
+EGIT_DOC(tree_entry_byid, "TREE ID &optional OPAQUE",
          "Retrieve an entry from TREE by ID.\n"
          "See `tree-entry-byindex' for a description of the return value.");
-emacs_value egit_tree_entry_byid(emacs_env *env, emacs_value _tree, emacs_value _oid)
+emacs_value egit_tree_entry_byid(emacs_env *env, emacs_value _tree, emacs_value _oid, emacs_value opaque)
 {
     EGIT_ASSERT_TREE(_tree);
     EM_ASSERT_STRING(_oid);
@@ -63,10 +75,10 @@ emacs_value egit_tree_entry_byid(emacs_env *env, emacs_value _tree, emacs_value
     const git_tree_entry *entry = git_tree_entry_byid(tree, &oid);
     if (!entry)
         return esym_nil; // TODO: Should we signal an error instead?
-    return egit_tree_entry_to_emacs(env, entry);
+    return tree_entry_borrowed(env, entry, _tree, opaque);
 }
 
-EGIT_DOC(tree_entry_byindex, "TREE N",
+EGIT_DOC(tree_entry_byindex, "TREE N &optional OPAQUE",
          "Return the Nth entry in TREE.\n"
          "The return value is a list of four elements:\n"
          "  (MODE TYPE ID FILENAME)\n\n"
@@ -82,8 +94,12 @@ EGIT_DOC(tree_entry_byindex, "TREE N",
          "- `tree'\n"
          "- `blob'\n"
          "- `tag'\n\n"
-         "ID is the object ID, and FILENAME is the relative path.");
-emacs_value egit_tree_entry_byindex(emacs_env *env, emacs_value _tree, emacs_value _index)
+         "ID is the object ID, and FILENAME is the relative path.\n\n"
+         "If OPAQUE is non-nil, return a tree entry object instead, whose fields\n"
+         "are only converted when asked for, see `libgit-tree-entry-name',\n"
+         "`libgit-tree-entry-filemode', `libgit-tree-entry-type' and\n"
+         "`libgit-tree-entry-id'.");
+emacs_value egit_tree_entry_byindex(emacs_env *env, emacs_value _tree, emacs_value _index, emacs_value opaque)
 {
     EGIT_ASSERT_TREE(_tree);
     EM_ASSERT_INTEGER(_index);
@@ -94,13 +110,13 @@ emacs_value egit_tree_entry_byindex(emacs_env *env, emacs_value _tree, emacs_val
         em_signal_args_out_of_range(env, index);
         return esym_nil;
     }
-    return egit_tree_entry_to_emacs(env, entry);
+    return tree_entry_borrowed(env, entry, _tree, opaque);
 }
 
-EGIT_DOC(tree_entry_byname, "TREE FILENAME",
+EGIT_DOC(tree_entry_byname, "TREE FILENAME &optional OPAQUE",
          "Retrieve an entry from TREE by FILENAME.\n"
          "See `tree-entry-byindex' for a description of the return value.");
-emacs_value egit_tree_entry_byname(emacs_env *env, emacs_value _tree, emacs_value _name)
+emacs_value egit_tree_entry_byname(emacs_env *env, emacs_value _tree, emacs_value _name, emacs_value opaque)
 {
     EGIT_ASSERT_TREE(_tree);
     EM_ASSERT_STRING(_name);
@@ -110,13 +126,13 @@ emacs_value egit_tree_entry_byname(emacs_env *env, emacs_value _tree, emacs_valu
     free(name);
     if (!entry)
         return esym_nil; // TODO: Should we signal an error instead?
-    return egit_tree_entry_to_emacs(env, entry);
+    return tree_entry_borrowed(env, entry, _tree, opaque);
 }
 
-EGIT_DOC(tree_entry_bypath, "TREE PATH",
+EGIT_DOC(tree_entry_bypath, "TREE PATH &optional OPAQUE",
          "Retrieve an entry from TREE, or any of its subtrees, by PATH.\n"
          "See `tree-entry-byindex' for a description of the return value.");
-emacs_value egit_tree_entry_bypath(emacs_env *env, emacs_value _tree, emacs_value _path)
+emacs_value egit_tree_entry_bypath(emacs_env *env, emacs_value _tree, emacs_value _path, emacs_value opaque)
 {
     EGIT_ASSERT_TREE(_tree);
     EM_ASSERT_STRING(_path);
@@ -126,11 +142,204 @@ emacs_value egit_tree_entry_bypath(emacs_env *env, emacs_value _tree, emacs_valu
     int retval = git_tree_entry_bypath(&entry, tree, path);
     free(path);
     EGIT_CHECK_ERROR(retval);
+
+    // The entry is owned, not borrowed from TREE
+    if (EM_EXTRACT_BOOLEAN(opaque))
+        return egit_wrap(env, EGIT_TREE_ENTRY, entry, NULL);
+
     emacs_value ret = egit_tree_entry_to_emacs(env, entry);
     git_tree_entry_free(entry);
     return ret;
 }
 
+typedef struct {
+    char *path;
+    size_t index;
+} tree_path;
+
+static int tree_path_cmp(const void *a, const void *b)
+{
+    const tree_path *pa = (const tree_path*) a, *pb = (const tree_path*) b;
+    int cmp = strcmp(pa->path, pb->path);
+    if (cmp)
+        return cmp;
+    return pa->index < pb->index ? -1 : pa->index > pb->index;
+}
+
+/**
+ * Subtrees of the directories leading to the last looked up path. Level 0 is
+ * the root tree, and level I is the subtree at the first DIRLEN[I] bytes of
+ * DIR, which end with a slash.
+ */
+typedef struct {
+    git_repository *repo;
+    const char *dir;
+    git_tree **trees;
+    size_t *dirlen;
+    size_t depth, alloc;
+    char *name;
+    size_t name_alloc;
+} tree_path_cache;
+
+/**
+ * Copy the LEN bytes at NAME to a NUL-terminated buffer owned by CACHE.
+ */
+static const char *tree_path_name(tree_path_cache *cache, const char *name, size_t len)
+{
+    if (len + 1 > cache->name_alloc) {
+        cache->name_alloc = 2 * (len + 1);
+        cache->name = (char*) realloc(cache->name, cache->name_alloc);
+    }
+    memcpy(cache->name, name, len);
+    cache->name[len] = '\0';
+    return cache->name;
+}
+
+/**
+ * Look up PATH, reusing the subtrees of the previous path where they share
+ * leading directories.
+ * @return Zero, GIT_ENOTFOUND, or another error code.
+ */
+static int tree_path_lookup(const git_tree_entry **out, tree_path_cache *cache, const char *path)
+{
+    size_t len = strlen(path);
+    bool want_tree = len > 0 && path[len - 1] == '/';
+    if (want_tree)
+        len--;
+    size_t dirlen = len;
+    while (dirlen > 0 && path[dirlen - 1] != '/')
+        dirlen--;
+    if (len == dirlen)
+        return GIT_ENOTFOUND;
+
+    // Since paths are sorted, the previous path's directories are reused
+    // as long as they are still a prefix of this one
+    while (cache->depth > 0) {
+        size_t n = cache->dirlen[cache->depth];
+        if (n <= dirlen && !strncmp(path, cache->dir, n))
+            break;
+        git_tree_free(cache->trees[cache->depth]);
+        cache->depth--;
+    }
+    cache->dir = path;
+
+    while (cache->dirlen[cache->depth] < dirlen) {
+        size_t start = cache->dirlen[cache->depth];
+        const char *end = memchr(path + start, '/', dirlen - start);
+        const char *name = tree_path_name(cache, path + start, end - path - start);
+        const git_tree_entry *entry = name[0] ?
+            git_tree_entry_byname(cache->trees[cache->depth], name) : NULL;
+        if (!entry || git_tree_entry_type(entry) != GIT_OBJ_TREE)
+            return GIT_ENOTFOUND;
+
+        git_tree *subtree;
+        int retval = git_tree_lookup(&subtree, cache->repo, git_tree_entry_id(entry));
+        if (retval < 0)
+            return retval;
+
+        if (++cache->depth == cache->alloc) {
+            cache->alloc *= 2;
+            cache->trees = (git_tree**) realloc(cache->trees, cache->alloc * sizeof(git_tree*));
+            cache->dirlen = (size_t*) realloc(cache->dirlen, cache->alloc * sizeof(size_t));
+        }
+        cache->trees[cache->depth] = subtree;
+        cache->dirlen[cache->depth] = end - path + 1;
+    }
+
+    const char *name = tree_path_name(cache, path + dirlen, len - dirlen);
+    const git_tree_entry *entry = git_tree_entry_byname(cache->trees[cache->depth], name);
+    if (!entry || (want_tree && git_tree_entry_type(entry) != GIT_OBJ_TREE))
+        return GIT_ENOTFOUND;
+    *out = entry;
+    return 0;
+}
+
+EGIT_DOC(tree_entries_bypath, "TREE PATHS &optional OPAQUE",
+         "Retrieve entries from TREE, or any of its subtrees, by PATHS.\n"
+         "PATHS is a list or vector of strings. Return a vector in the same\n"
+         "order, whose elements are as described in `tree-entry-byindex', or\n"
+         "nil for paths that don't exist.\n\n"
+         "This is like calling `tree-entry-bypath' for each path, except that\n"
+         "the paths are sorted first, so each subtree is read only once.");
+emacs_value egit_tree_entries_bypath(emacs_env *env, emacs_value _tree, emacs_value _paths, emacs_value opaque)
+{
+    EGIT_ASSERT_TREE(_tree);
+    git_tree *tree = EGIT_EXTRACT(_tree);
+
+    bool vectorp = em_vectorp(env, _paths);
+    ptrdiff_t count = vectorp ? env->vec_size(env, _paths) : em_assert_list(env, esym_nil, _paths);
+    if (count < 0 || env->non_local_exit_check(env) != emacs_funcall_exit_return)
+        return esym_nil;
+
+    tree_path *paths = (tree_path*) calloc(count ? count : 1, sizeof(tree_path));
+    for (ptrdiff_t i = 0; i < count; i++) {
+        emacs_value _path = vectorp ? env->vec_get(env, _paths, i) : em_car(env, _paths);
+        if (!vectorp)
+            _paths = em_cdr(env, _paths);
+        if (!em_assert(env, esym_stringp, _path)) {
+            for (ptrdiff_t j = 0; j < i; j++)
+                free(paths[j].path);
+            free(paths);
+            return esym_nil;
+        }
+        paths[i].path = EM_EXTRACT_STRING(_path);
+        paths[i].index = i;
+    }
+    qsort(paths, count, sizeof(tree_path), tree_path_cmp);
+
+    tree_path_cache cache;
+    memset(&cache, 0, sizeof(tree_path_cache));
+    cache.repo = git_tree_owner(tree);
+    cache.alloc = 16;
+    cache.trees = (git_tree**) malloc(cache.alloc * sizeof(git_tree*));
+    cache.dirlen = (size_t*) malloc(cache.alloc * sizeof(size_t));
+    cache.trees[0] = tree;
+    cache.dirlen[0] = 0;
+
+    int retval = 0;
+    emacs_value *values = (emacs_value*) malloc((count ? count : 1) * sizeof(emacs_value));
+    for (ptrdiff_t i = 0; i < count; i++) {
+        if (i % 4096 == 4095 && em_should_quit(env)) {
+            retval = GIT_EUSER;
+            break;
+        }
+
+        const git_tree_entry *entry;
+        retval = tree_path_lookup(&entry, &cache, paths[i].path);
+        emacs_value value = esym_nil;
+        if (retval == 0 && EM_EXTRACT_BOOLEAN(opaque)) {
+            // Subtrees are freed below, so opaque entries are owned copies
+            git_tree_entry *copy;
+            retval = git_tree_entry_dup(&copy, entry);
+            if (retval == 0)
+                value = egit_wrap(env, EGIT_TREE_ENTRY, copy, NULL);
+        }
+        else if (retval == 0)
+            value = egit_tree_entry_to_emacs(env, entry);
+        else if (retval == GIT_ENOTFOUND)
+            retval = 0;
+        if (retval < 0)
+            break;
+        values[paths[i].index] = value;
+    }
+
+    emacs_value ret = retval == 0 ? em_vector(env, values, count) : esym_nil;
+
+    for (size_t i = 1; i <= cache.depth; i++)
+        git_tree_free(cache.trees[i]);
+    free(cache.trees);
+    free(cache.dirlen);
+    free(cache.name);
+    for (ptrdiff_t i = 0; i < count; i++)
+        free(paths[i].path);
+    free(paths);
+    free(values);
+
+    if (retval != GIT_EUSER)
+        EGIT_CHECK_ERROR(retval);
+    return ret;
+}
+
 EGIT_DOC(tree_entrycount, "TREE", "Return the number of entries in TREE.");
 emacs_value egit_tree_entrycount(emacs_env *env, emacs_value _tree)
 {
@@ -160,6 +369,76 @@ emacs_value egit_tree_owner(emacs_env *env, emacs_value _tree)
 }
 
 
+// =============================================================================
+// Getters - tree entry
+
+EGIT_DOC(tree_entry_name, "ENTRY", "Return the file name of the tree ENTRY.");
+emacs_value egit_tree_entry_name(emacs_env *env, emacs_value _entry)
+{
+    EGIT_ASSERT_TREE_ENTRY(_entry);
+    git_tree_entry *entry = EGIT_EXTRACT(_entry);
+    return EM_STRING(git_tree_entry_name(entry));
+}
+
+EGIT_DOC(tree_entry_filemode, "ENTRY",
+         "Return the file mode of the tree ENTRY.\n"
+         "See `libgit-tree-entry-byindex' for the possible values.");
+emacs_value egit_tree_entry_filemode(emacs_env *env, emacs_value _entry)
+{
+    EGIT_ASSERT_TREE_ENTRY(_entry);
+    git_tree_entry *entry = EGIT_EXTRACT(_entry);
+    return em_findenum_filemode(git_tree_entry_filemode(entry));
+}
+
+EGIT_DOC(tree_entry_type, "ENTRY",
+         "Return the type of the object the tree ENTRY points to.\n"
+         "See `libgit-tree-entry-byindex' for the possible values.");
+emacs_value egit_tree_entry_type(emacs_env *env, emacs_value _entry)
+{
+    EGIT_ASSERT_TREE_ENTRY(_entry);
+    git_tree_entry *entry = EGIT_EXTRACT(_entry);
+    return em_findenum_otype(git_tree_entry_type(entry));
+}
+
+EGIT_DOC(tree_entry_id, "ENTRY", "Return the ID of the object the tree ENTRY points to.");
+emacs_value egit_tree_entry_id(emacs_env *env, emacs_value _entry)
+{
+    EGIT_ASSERT_TREE_ENTRY(_entry);
+    git_tree_entry *entry = EGIT_EXTRACT(_entry);
+    const char *oid_s = git_oid_tostr_s(git_tree_entry_id(entry));
+    return EM_STRING(oid_s);
+}
+
+EGIT_DOC(tree_entry_cmp, "ENTRY1 ENTRY2",
+         "Compare two tree entries in the order git sorts trees.\n"
+         "Return a negative number, zero or a positive number if ENTRY1 sorts\n"
+         "before, with or after ENTRY2.");
+emacs_value egit_tree_entry_cmp(emacs_env *env, emacs_value _entry1, emacs_value _entry2)
+{
+    EGIT_ASSERT_TREE_ENTRY(_entry1);
+    EGIT_ASSERT_TREE_ENTRY(_entry2);
+    git_tree_entry *entry1 = EGIT_EXTRACT(_entry1);
+    git_tree_entry *entry2 = EGIT_EXTRACT(_entry2);
+    return EM_INTEGER(git_tree_entry_cmp(entry1, entry2));
+}
+
+EGIT_DOC(tree_entry_to_object, "REPO ENTRY",
+         "Look up the object in REPO that the tree ENTRY points to.");
+emacs_value egit_tree_entry_to_object(emacs_env *env, emacs_value _repo, emacs_value _entry)
+{
+    EGIT_ASSERT_REPOSITORY(_repo);
+    EGIT_ASSERT_TREE_ENTRY(_entry);
+    git_repository *repo = EGIT_EXTRACT(_repo);
+    git_tree_entry *entry = EGIT_EXTRACT(_entry);
+
+    git_object *obj;
+    int retval = git_tree_entry_to_object(&obj, repo, entry);
+    EGIT_CHECK_ERROR(retval);
+
+    return egit_wrap(env, EGIT_OBJECT, obj, EM_EXTRACT_USER_PTR(_repo));
+}
+
+
 // =============================================================================
 // Tree walk
 
@@ -210,3 +489,198 @@ emacs_value egit_tree_walk(emacs_env *env, emacs_value _tree, emacs_value order,
 
     return esym_nil;
 }
+
+
+// =============================================================================
+// Tree listing
+
+typedef struct {
+    emacs_env *env;
+    git_repository *repo;
+    git_pathspec *pathspec;
+    git_strarray prefixes;      /**< Literal leading directories of the pathspecs. */
+    bool prune;                 /**< Whether subtrees may be skipped using PREFIXES. */
+    intmax_t max_depth;
+
+    char *path;
+    size_t path_alloc;
+
+    emacs_value *values[4];     /**< Paths, modes, types and IDs. */
+    size_t count, alloc, visited;
+} tree_list_ctx;
+
+/**
+ * Compute the literal directory prefix of each pathspec, so that subtrees
+ * that can't contain matches are not loaded. Pathspecs with magic or
+ * exclusions disable pruning.
+ */
+static void tree_list_prefixes(tree_list_ctx *ctx, const git_strarray *specs)
+{
+    ctx->prune = specs->count > 0;
+    ctx->prefixes.count = specs->count;
+    ctx->prefixes.strings = (char**) calloc(specs->count ? specs->count : 1, sizeof(char*));
+
+    for (size_t i = 0; i < specs->count; i++) {
+        const char *spec = specs->strings[i];
+        if (spec[0] == ':' || spec[0] == '!') {
+            ctx->prune = false;
+            continue;
+        }
+        size_t len = strcspn(spec, "*?[\\");
+        char *prefix = (char*) malloc(len + 1);
+        memcpy(prefix, spec, len);
+        prefix[len] = '\0';
+        ctx->prefixes.strings[i] = prefix;
+    }
+}
+
+/**
+ * Return true if DIR (ending with a slash) may contain paths matching a prefix.
+ */
+static bool tree_list_may_match(tree_list_ctx *ctx, const char *dir, size_t len)
+{
+    if (!ctx->prune)
+        return true;
+
+    for (size_t i = 0; i < ctx->prefixes.count; i++) {
+        const char *prefix = ctx->prefixes.strings[i];
+        size_t plen = strlen(prefix);
+        size_t n = plen < len ? plen : len;
+        if (!strncmp(prefix, dir, n))
+            return true;
+    }
+    return false;
+}
+
+static void tree_list_push(tree_list_ctx *ctx, const git_tree_entry *entry)
+{
+    emacs_env *env = ctx->env;
+
+    if (ctx->count == ctx->alloc) {
+        ctx->alloc = ctx->alloc ? 2 * ctx->alloc : 256;
+        for (int i = 0; i < 4; i++)
+            ctx->values[i] = (emacs_value*) realloc(ctx->values[i], ctx->alloc * sizeof(emacs_value));
+    }
+
+    size_t i = ctx->count++;
+    ctx->values[0][i] = EM_STRING(ctx->path);
+    ctx->values[1][i] = em_findenum_filemode(git_tree_entry_filemode(entry));
+    ctx->values[2][i] = em_findenum_otype(git_tree_entry_type(entry));
+    ctx->values[3][i] = EM_STRING(git_oid_tostr_s(git_tree_entry_id(entry)));
+}
+
+static int tree_list_walk(tree_list_ctx *ctx, const git_tree *tree, size_t len, intmax_t depth)
+{
+    size_t count = git_tree_entrycount(tree);
+    for (size_t i = 0; i < count; i++) {
+        const git_tree_entry *entry = git_tree_entry_byindex(tree, i);
+        const char *name = git_tree_entry_name(entry);
+        size_t name_len = strlen(name);
+
+        if (len + name_len + 2 > ctx->path_alloc) {
+            ctx->path_alloc = 2 * (len + name_len + 2);
+            ctx->path = (char*) realloc(ctx->path, ctx->path_alloc);
+        }
+        memcpy(ctx->path + len, name, name_len + 1);
+
+        bool descend = git_tree_entry_type(entry) == GIT_OBJ_TREE && depth < ctx->max_depth;
+        if (!descend) {
+            if (!ctx->pathspec || git_pathspec_matches_path(ctx->pathspec, 0, ctx->path))
+                tree_list_push(ctx, entry);
+            if (++ctx->visited % 4096 == 0 && em_should_quit(ctx->env))
+                return GIT_EUSER;
+            continue;
+        }
+
+        ctx->path[len + name_len] = '/';
+        ctx->path[len + name_len + 1] = '\0';
+        if (!tree_list_may_match(ctx, ctx->path, len + name_len + 1))
+            continue;
+
+        git_tree *subtree;
+        int retval = git_tree_lookup(&subtree, ctx->repo, git_tree_entry_id(entry));
+        if (retval < 0)
+            return retval;
+        retval = tree_list_walk(ctx, subtree, len + name_len + 1, depth + 1);
+        git_tree_free(subtree);
+        if (retval < 0)
+            return retval;
+    }
+
+    return 0;
+}
+
+EGIT_DOC(tree_list, "TREE &optional RECURSIVE PATHSPEC MAX-DEPTH",
+         "List the entries of TREE, like `git ls-tree'.\n"
+         "Return a list (PATHS MODES TYPES IDS) of four vectors of equal length,\n"
+         "where element I of each vector describes entry I. PATHS are relative\n"
+         "to TREE, and MODES and TYPES are symbols as in `libgit-tree-entry-byindex'.\n\n"
+         "If RECURSIVE is non-nil, descend into subtrees and list their entries\n"
+         "instead of the subtrees themselves, like `git ls-tree -r'. MAX-DEPTH\n"
+         "limits the descent: subtrees MAX-DEPTH levels below TREE are listed\n"
+         "but not entered.\n\n"
+         "If PATHSPEC is given, it is either a pathspec object or a list of\n"
+         "pathspec strings, and only matching entries are listed. Subtrees that\n"
+         "can't contain matches are not read.");
+emacs_value egit_tree_list(
+    emacs_env *env, emacs_value _tree, emacs_value recursive,
+    emacs_value _pathspec, emacs_value _max_depth)
+{
+    EGIT_ASSERT_TREE(_tree);
+
+    tree_list_ctx ctx;
+    memset(&ctx, 0, sizeof(tree_list_ctx));
+    ctx.env = env;
+    ctx.max_depth = EM_EXTRACT_BOOLEAN(recursive) ? INTMAX_MAX : 0;
+    if (EM_EXTRACT_BOOLEAN(_max_depth)) {
+        EM_ASSERT_INTEGER(_max_depth);
+        intmax_t max_depth = EM_EXTRACT_INTEGER(_max_depth);
+        if (max_depth < ctx.max_depth)
+            ctx.max_depth = max_depth;
+    }
+
+    git_tree *tree = EGIT_EXTRACT(_tree);
+    ctx.repo = git_tree_owner(tree);
+
+    int retval = 0;
+    bool own_pathspec = false;
+    if (egit_get_type(env, _pathspec) == EGIT_PATHSPEC)
+        ctx.pathspec = EGIT_EXTRACT(_pathspec);
+    else if (EM_EXTRACT_BOOLEAN(_pathspec)) {
+        git_strarray specs;
+        if (!egit_strarray_from_list(&specs, env, _pathspec))
+            return esym_nil;
+        retval = git_pathspec_new(&ctx.pathspec, &specs);
+        if (retval == 0) {
+            own_pathspec = true;
+            tree_list_prefixes(&ctx, &specs);
+        }
+        egit_strarray_dispose(&specs);
+        EGIT_CHECK_ERROR(retval);
+    }
+
+    ctx.path_alloc = 256;
+    ctx.path = (char*) malloc(ctx.path_alloc);
+    ctx.path[0] = '\0';
+    retval = tree_list_walk(&ctx, tree, 0, 0);
+
+    emacs_value ret = esym_nil;
+    if (retval == 0) {
+        emacs_value vectors[4];
+        for (int i = 0; i < 4; i++)
+            vectors[i] = em_vector(env, ctx.values[i], ctx.count);
+        ret = em_list(env, vectors, 4);
+    }
+
+    for (int i = 0; i < 4; i++)
+        free(ctx.values[i]);
+    free(ctx.path);
+    if (ctx.prefixes.strings)
+        egit_strarray_dispose(&ctx.prefixes);
+    if (own_pathspec)
+        git_pathspec_free(ctx.pathspec);
+
+    if (retval != GIT_EUSER)
+        EGIT_CHECK_ERROR(retval);
+    return ret;
+}
@@ -6,14 +6,24 @@
 EGIT_DEFUN(tree_lookup, emacs_value _repo, emacs_value _oid);
 EGIT_DEFUN(tree_lookup_prefix, emacs_value _repo, emacs_value _oid);
 
-EGIT_DEFUN(tree_entry_byid, emacs_value _tree, emacs_value _oid);
-EGIT_DEFUN(tree_entry_byindex, emacs_value _tree, emacs_value _index);
-EGIT_DEFUN(tree_entry_byname, emacs_value _tree, emacs_value _name);
-EGIT_DEFUN(tree_entry_bypath, emacs_value _tree, emacs_value _path);
+EGIT_DEFUN(tree_entry_byid, emacs_value _tree, emacs_value _oid, emacs_value opaque);
+EGIT_DEFUN(tree_entry_byindex, emacs_value _tree, emacs_value _index, emacs_value opaque);
+EGIT_DEFUN(tree_entry_byname, emacs_value _tree, emacs_value _name, emacs_value opaque);
+EGIT_DEFUN(tree_entry_bypath, emacs_value _tree, emacs_value _path, emacs_value opaque);
+EGIT_DEFUN(tree_entries_bypath, emacs_value _tree, emacs_value _paths, emacs_value opaque);
 EGIT_DEFUN(tree_entrycount, emacs_value _tree);
 EGIT_DEFUN(tree_id, emacs_value _tree);
 EGIT_DEFUN(tree_owner, emacs_value _tree);
 
+EGIT_DEFUN(tree_entry_name, emacs_value _entry);
+EGIT_DEFUN(tree_entry_filemode, emacs_value _entry);
+EGIT_DEFUN(tree_entry_type, emacs_value _entry);
+EGIT_DEFUN(tree_entry_id, emacs_value _entry);
+EGIT_DEFUN(tree_entry_cmp, emacs_value _entry1, emacs_value _entry2);
+EGIT_DEFUN(tree_entry_to_object, emacs_value _repo, emacs_value _entry);
+
 EGIT_DEFUN(tree_walk, emacs_value _tree, emacs_value order, emacs_value function);
+EGIT_DEFUN(tree_list, emacs_value _tree, emacs_value recursive, emacs_value _pathspec,
+           emacs_value _max_depth);
 
 #endif /* EGIT_TREE_H */
@@ -41,10 +41,11 @@ emacs_value egit_treebuilder_entrycount(emacs_env *env, emacs_value _builder)
     return EM_INTEGER(git_treebuilder_entrycount(bld));
 }
 
-EGIT_DOC(treebuilder_get, "BUILDER PATH",
+EGIT_DOC(treebuilder_get, "BUILDER PATH &optional OPAQUE",
          "Get the entry in BUILDER associated with PATH.\n"
-         "See `libgit-tree-entry-byindex' for more information.");
-emacs_value egit_treebuilder_get(emacs_env *env, emacs_value _builder, emacs_value _path)
+         "See `libgit-tree-entry-byindex' for more information. An opaque entry\n"
+         "is a copy, so it is not affected by later changes to BUILDER.");
+emacs_value egit_treebuilder_get(emacs_env *env, emacs_value _builder, emacs_value _path, emacs_value opaque)
 {
     EGIT_ASSERT_TREEBUILDER(_builder);
     EM_ASSERT_STRING(_path);
@@ -56,6 +57,13 @@ emacs_value egit_treebuilder_get(emacs_env *env, emacs_value _builder, emacs_val
 
     if (!entry)
         return esym_nil;
+
+    if (EM_EXTRACT_BOOLEAN(opaque)) {
+        git_tree_entry *copy;
+        int retval = git_tree_entry_dup(&copy, entry);
+        EGIT_CHECK_ERROR(retval);
+        return egit_wrap(env, EGIT_TREE_ENTRY, copy, NULL);
+    }
     return egit_tree_entry_to_emacs(env, entry);
 }
 
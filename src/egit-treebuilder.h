@@ -6,7 +6,7 @@
 EGIT_DEFUN(treebuilder_new, emacs_value _repo, emacs_value _tree);
 
 EGIT_DEFUN(treebuilder_entrycount, emacs_value _builder);
-EGIT_DEFUN(treebuilder_get, emacs_value _builder, emacs_value _path);
+EGIT_DEFUN(treebuilder_get, emacs_value _builder, emacs_value _path, emacs_value opaque);
 
 EGIT_DEFUN(treebuilder_clear, emacs_value _builder);
 EGIT_DEFUN(treebuilder_insert, emacs_value _builder, emacs_value _path,
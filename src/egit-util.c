@@ -65,8 +65,9 @@ int egit_cred_dup(git_cred **out, git_cred *cred)
     }
 }
 
-// TODO: This should probably be exposed as an opaque structure too,
-// for consistency.
+// Lookups can also return opaque EGIT_TREE_ENTRY objects, which convert their
+// fields lazily. This list form is kept for compatibility, and for entries that
+// only live during a callback, such as in tree walks.
 emacs_value egit_tree_entry_to_emacs(emacs_env *env, const git_tree_entry *entry)
 {
     git_filemode_t mode = git_tree_entry_filemode(entry);
@@ -10,6 +10,7 @@
 
 #include "interface.h"
 #include "egit-annotated-commit.h"
+#include "egit-apply.h"
 #include "egit-blame.h"
 #include "egit-blob.h"
 #include "egit-branch.h"
@@ -17,18 +18,23 @@
 #include "egit-cherrypick.h"
 #include "egit-clone.h"
 #include "egit-commit.h"
+#include "egit-commit-graph.h"
 #include "egit-config.h"
 #include "egit-cred.h"
 #include "egit-describe.h"
 #include "egit-diff.h"
 #include "egit-graph.h"
+#include "egit-graph-layout.h"
 #include "egit-ignore.h"
 #include "egit-index.h"
 #include "egit-libgit2.h"
+#include "egit-log.h"
 #include "egit-merge.h"
 #include "egit-message.h"
 #include "egit-object.h"
+#include "egit-odb.h"
 #include "egit-pathspec.h"
+#include "egit-pickaxe.h"
 #include "egit-reference.h"
 #include "egit-reflog.h"
 #include "egit-refspec.h"
@@ -111,6 +117,8 @@ void egit_finalize(void* _obj)
     case EGIT_REFLOG:
     case EGIT_REMOTE:
     case EGIT_REPOSITORY:
+    case EGIT_REVWALK:
+    case EGIT_TREE:
         obj->refcount--;
         if (obj->refcount != 0)
             return;
@@ -121,6 +129,9 @@ void egit_finalize(void* _obj)
     egit_signal_free(_obj);
 #endif
 
+    // The state may refer to the object, so it goes first
+    egit_state_set(obj, NULL, NULL);
+
     // Free the object based on its type
     // For types that only expose weak pointers to the parent, this should be a no-op
     switch (obj->type) {
@@ -143,6 +154,13 @@ void egit_finalize(void* _obj)
     case EGIT_TREEBUILDER: git_treebuilder_free(obj->ptr); break;
     case EGIT_PATHSPEC: git_pathspec_free(obj->ptr); break;
     case EGIT_PATHSPEC_MATCH_LIST: git_pathspec_match_list_free(obj->ptr); break;
+    case EGIT_GRAPH_LAYOUT: egit_layout_free(obj->ptr); break;
+    case EGIT_BLAME_JOB: egit_blame_job_free(obj->ptr); break;
+    case EGIT_TREE_ENTRY:
+        // Entries with a parent tree are borrowed from it, the others are owned
+        if (!parent)
+            git_tree_entry_free(obj->ptr);
+        break;
     default: break;
     }
 
@@ -174,6 +192,8 @@ emacs_value egit_wrap(emacs_env *env, egit_type type, const void* data, egit_obj
     wrapper->type = type;
     wrapper->ptr = (void*) data;
     wrapper->parent = parent;
+    wrapper->state = NULL;
+    wrapper->state_free = NULL;
 
     // This has no effect for types that are not reference-counted
     wrapper->refcount = 1;
@@ -185,6 +205,19 @@ emacs_value egit_wrap(emacs_env *env, egit_type type, const void* data, egit_obj
     return EM_USER_PTR(wrapper, egit_finalize);
 }
 
+void *egit_state_get(egit_object *obj, egit_state_free_cb state_free)
+{
+    return obj->state_free == state_free ? obj->state : NULL;
+}
+
+void egit_state_set(egit_object *obj, void *state, egit_state_free_cb state_free)
+{
+    if (obj->state_free)
+        obj->state_free(obj->state);
+    obj->state = state;
+    obj->state_free = state ? state_free : NULL;
+}
+
 typedef emacs_value (*func_0)(emacs_env*);
 typedef emacs_value (*func_1)(emacs_env*, emacs_value);
 typedef emacs_value (*func_2)(emacs_env*, emacs_value, emacs_value);
@@ -303,6 +336,9 @@ static emacs_value egit_typeof(emacs_env *env, emacs_value val)
     case EGIT_REFLOG_ENTRY: return esym_reflog_entry;
     case EGIT_REVWALK: return esym_revwalk;
     case EGIT_TREEBUILDER: return esym_treebuilder;
+    case EGIT_GRAPH_LAYOUT: return esym_graph_layout;
+    case EGIT_BLAME_JOB: return esym_blame_job;
+    case EGIT_TREE_ENTRY: return esym_tree_entry;
     default: return esym_nil;
     }
 }
@@ -317,6 +353,7 @@ static emacs_value egit_typeof(emacs_env *env, emacs_value val)
 TYPECHECKER(ANNOTATED_COMMIT, annotated_commit, "annotated commit");
 TYPECHECKER(BLAME, blame, "blame");
 TYPECHECKER(BLAME_HUNK, blame_hunk, "blame hunk");
+TYPECHECKER(BLAME_JOB, blame_job, "blame job");
 TYPECHECKER(COMMIT, commit, "commit");
 TYPECHECKER(BLOB, blob, "blob");
 TYPECHECKER(CONFIG, config, "config");
@@ -326,6 +363,7 @@ TYPECHECKER(DIFF_DELTA, diff_delta, "diff delta");
 TYPECHECKER(DIFF_BINARY, diff_binary, "diff binary");
 TYPECHECKER(DIFF_HUNK, diff_hunk, "diff hunk");
 TYPECHECKER(DIFF_LINE, diff_line, "diff line");
+TYPECHECKER(GRAPH_LAYOUT, graph_layout, "graph layout");
 TYPECHECKER(INDEX, index, "index.");
 TYPECHECKER(INDEX_ENTRY, index_entry, "index entry");
 TYPECHECKER(PATHSPEC, pathspec, "pathspec");
@@ -342,6 +380,7 @@ TYPECHECKER(SUBMODULE, submodule, "submodule");
 TYPECHECKER(TAG, tag, "tag");
 TYPECHECKER(TRANSACTION, transaction, "transaction");
 TYPECHECKER(TREE, tree, "tree");
+TYPECHECKER(TREE_ENTRY, tree_entry, "tree entry");
 TYPECHECKER(TREEBUILDER, treebuilder, "treebuilder");
 
 #undef TYPECHECKER
@@ -380,6 +419,7 @@ void egit_init(emacs_env *env)
     DEFUN("libgit-annotated-commit-p", annotated_commit_p, 1, 1);
     DEFUN("libgit-blame-p", blame_p, 1, 1);
     DEFUN("libgit-blame-hunk-p", blame_hunk_p, 1, 1);
+    DEFUN("libgit-blame-job-p", blame_job_p, 1, 1);
     DEFUN("libgit-blob-p", blob_p, 1, 1);
     DEFUN("libgit-commit-p", commit_p, 1, 1);
     DEFUN("libgit-config-p", config_p, 1, 1);
@@ -389,6 +429,7 @@ void egit_init(emacs_env *env)
     DEFUN("libgit-diff-binary-p", diff_binary_p, 1, 1);
     DEFUN("libgit-diff-hunk-p", diff_hunk_p, 1, 1);
     DEFUN("libgit-diff-line-p", diff_line_p, 1, 1);
+    DEFUN("libgit-graph-layout-p", graph_layout_p, 1, 1);
     DEFUN("libgit-index-p", index_p, 1, 1);
     DEFUN("libgit-index-entry-p", index_entry_p, 1, 1);
     DEFUN("libgit-object-p", object_p, 1, 1);
@@ -406,6 +447,7 @@ void egit_init(emacs_env *env)
     DEFUN("libgit-tag-p", tag_p, 1, 1);
     DEFUN("libgit-transaction-p", transaction_p, 1, 1);
     DEFUN("libgit-tree-p", tree_p, 1, 1);
+    DEFUN("libgit-tree-entry-p", tree_entry_p, 1, 1);
     DEFUN("libgit-treebuilder-p", treebuilder_p, 1, 1);
 
     // Libgit2 (not namespaced as others!)
@@ -419,11 +461,16 @@ void egit_init(emacs_env *env)
     DEFUN("libgit-annotated-commit-lookup", annotated_commit_lookup, 2, 2);
     DEFUN("libgit-annotated-commit-id", annotated_commit_id, 1, 1);
 
+    // Apply
+    DEFUN("libgit-apply", apply, 2, 4);
+
     // Blame
     DEFUN("libgit-blame-file", blame_file, 2, 3);
+    DEFUN("libgit-blame-buffer", blame_buffer, 2, 2);
     DEFUN("libgit-blame-get-hunk-byindex", blame_get_hunk_byindex, 2, 2);
     DEFUN("libgit-blame-get-hunk-byline", blame_get_hunk_byline, 2, 2);
     DEFUN("libgit-blame-get-hunk-count", blame_get_hunk_count, 1, 1);
+    DEFUN("libgit-blame-hunks", blame_hunks, 1, 1);
 
     DEFUN("libgit-blame-hunk-commit-id", blame_hunk_commit_id, 1, 2);
     DEFUN("libgit-blame-hunk-lines", blame_hunk_lines, 1, 1);
@@ -431,6 +478,14 @@ void egit_init(emacs_env *env)
     DEFUN("libgit-blame-hunk-signature", blame_hunk_signature, 1, 2);
     DEFUN("libgit-blame-hunk-start-line-number", blame_hunk_start_line_number, 1, 2);
 
+    DEFUN("libgit-blame-cache-set-limit", blame_cache_set_limit, 1, 1);
+    DEFUN("libgit-blame-file-hunks", blame_file_hunks, 2, 3);
+
+    DEFUN("libgit-blame-file-incremental", blame_file_incremental, 2, 3);
+    DEFUN("libgit-blame-job-poll", blame_job_poll, 1, 1);
+    DEFUN("libgit-blame-job-done-p", blame_job_done_p, 1, 1);
+    DEFUN("libgit-blame-job-cancel", blame_job_cancel, 1, 1);
+
     // Blob
     DEFUN("libgit-blob-create-fromdisk", blob_create_fromdisk, 2, 2);
     DEFUN("libgit-blob-create-fromstring", blob_create_fromstring, 2, 2);
@@ -444,6 +499,9 @@ void egit_init(emacs_env *env)
     DEFUN("libgit-blob-owner", blob_owner, 1, 1);
     DEFUN("libgit-blob-rawcontent", blob_rawcontent, 1, 1);
     DEFUN("libgit-blob-rawsize", blob_rawsize, 1, 1);
+    DEFUN("libgit-blob-read-range", blob_read_range, 3, 3);
+
+    DEFUN("libgit-blob-insert", blob_insert, 1, 3);
 
     // Branch
     DEFUN("libgit-branch-create", branch_create, 3, 4);
@@ -494,6 +552,11 @@ void egit_init(emacs_env *env)
 
     DEFUN("libgit-commit-create", commit_create, 6, 7);
 
+    // Commit-graph
+    DEFUN("libgit-commit-graph-write", commit_graph_write, 1, 1);
+    DEFUN("libgit-commit-graph-generation", commit_graph_generation, 2, 2);
+    DEFUN("libgit-commit-graph-topo-order", commit_graph_topo_order, 2, 3);
+
     // Config
     DEFUN("libgit-config-new", config_new, 0, 0);
     DEFUN("libgit-config-open-default", config_open_default, 0, 0);
@@ -541,6 +604,7 @@ void egit_init(emacs_env *env)
     DEFUN("libgit-diff-tree-to-tree", diff_tree_to_tree, 1, 4);
     DEFUN("libgit-diff-tree-to-workdir", diff_tree_to_workdir, 1, 3);
     DEFUN("libgit-diff-tree-to-workdir-with-index", diff_tree_to_workdir_with_index, 1, 3);
+    DEFUN("libgit-diff-from-buffer", diff_from_buffer, 1, 1);
     DEFUN("libgit-diff-find-similar", diff_find_similar, 1, 2);
 
     DEFUN("libgit-diff-foreach", diff_foreach, 2, 5);
@@ -568,12 +632,19 @@ void egit_init(emacs_env *env)
     DEFUN("libgit-graph-ahead-behind", graph_ahead_behind, 3, 3);
     DEFUN("libgit-graph-descendant-p", graph_descendant_p, 3, 3);
 
+    DEFUN("libgit-graph-layout-new", graph_layout_new, 1, 1);
+    DEFUN("libgit-graph-layout-next", graph_layout_next, 2, 2);
+    DEFUN("libgit-graph-layout-add", graph_layout_add, 2, 2);
+    DEFUN("libgit-graph-layout-lanes", graph_layout_lanes, 1, 1);
+
     // Ignore
     DEFUN("libgit-ignore-add-rule", add_rule, 2, 2);
     DEFUN("libgit-ignore-clear-internal-rules", clear_internal_rules, 1, 1);
     DEFUN("libgit-ignore-path-ignored-p", path_ignored_p, 2, 2);
 
     // Index
+    DEFUN("libgit-index-new", index_new, 1, 2);
+
     DEFUN("libgit-index-caps", index_caps, 1, 1);
     DEFUN("libgit-index-checksum", index_checksum, 1, 1);
     DEFUN("libgit-index-conflict-foreach", index_conflict_foreach, 2, 2);
@@ -581,6 +652,7 @@ void egit_init(emacs_env *env)
     DEFUN("libgit-index-entry-id", index_entry_id, 1, 1);
     DEFUN("libgit-index-entry-path", index_entry_path, 1, 1);
     DEFUN("libgit-index-entry-stage", index_entry_stage, 1, 1);
+    DEFUN("libgit-index-entries", index_entries, 1, 2);
     DEFUN("libgit-index-entrycount", index_entrycount, 1, 1);
     DEFUN("libgit-index-get-byindex", index_get_byindex, 2, 2);
     DEFUN("libgit-index-get-bypath", index_get_bypath, 2, 3);
@@ -591,11 +663,22 @@ void egit_init(emacs_env *env)
 
     DEFUN("libgit-index-add-all", index_add_all, 1, 4);
     DEFUN("libgit-index-add-bypath", index_add_bypath, 2, 2);
+    DEFUN("libgit-index-add-frombuffer", index_add_frombuffer, 3, 4);
+    DEFUN("libgit-index-add-paths", index_add_paths, 2, 3);
     DEFUN("libgit-index-clear", index_clear, 1, 1);
     DEFUN("libgit-index-read", index_read, 1, 2);
+    DEFUN("libgit-index-read-tree", index_read_tree, 2, 2);
+    DEFUN("libgit-index-remove", index_remove, 2, 3);
     DEFUN("libgit-index-write", index_write, 1, 1);
     DEFUN("libgit-index-write-tree", index_write_tree, 1, 2);
 
+    DEFUN("libgit-index-stage-lines", index_stage_lines, 3, 4);
+    DEFUN("libgit-index-unstage-lines", index_unstage_lines, 3, 3);
+
+    // Log
+    DEFUN("libgit-log", log, 2, 5);
+    DEFUN("libgit-log-path", log_path, 2, 6);
+
     // Merge
     DEFUN("libgit-merge", merge, 2, 4);
     DEFUN("libgit-merge-analysis", merge_analysis, 2, 2);
@@ -615,6 +698,15 @@ void egit_init(emacs_env *env)
     DEFUN("libgit-object-owner", object_owner, 1, 1);
     DEFUN("libgit-object-short-id", object_short_id, 1, 1);
 
+    // ODB
+    DEFUN("libgit-odb-headers", odb_headers, 2, 3);
+    DEFUN("libgit-odb-read-header", odb_read_header, 2, 2);
+    DEFUN("libgit-odb-read-many", odb_read_many, 2, 4);
+
+    // OID
+    DEFUN("libgit-oid-abbrev-many", oid_abbrev_many, 2, 3);
+    DEFUN("libgit-oid-resolve-many", oid_resolve_many, 2, 2);
+
     // Pathspec
     DEFUN("libgit-pathspec-new", pathspec_new, 1, 1);
     DEFUN("libgit-pathspec-matches-path", pathspec_matches_path, 3, 3);
@@ -628,6 +720,9 @@ void egit_init(emacs_env *env)
     DEFUN("libgit-pathspec-match-tree", pathspec_match_tree, 3, 3);
     DEFUN("libgit-pathspec-match-diff", pathspec_match_diff, 3, 3);
 
+    // Pickaxe
+    DEFUN("libgit-pickaxe", pickaxe, 2, 5);
+
     // Reference
     DEFUN("libgit-reference-create", reference_create, 3, 5);
     DEFUN("libgit-reference-create-matching", reference_create_matching, 3, 6);
@@ -664,6 +759,8 @@ void egit_init(emacs_env *env)
     DEFUN("libgit-reference-foreach-glob", reference_foreach_glob, 3, 3);
     DEFUN("libgit-reference-foreach-name", reference_foreach_name, 2, 2);
 
+    DEFUN("libgit-reference-snapshot", reference_snapshot, 1, 3);
+
     // Reflog
     DEFUN("libgit-reflog-read", reflog_read, 1, 2);
     DEFUN("libgit-reflog-entry-byindex", reflog_entry_byindex, 2, 2);
@@ -772,7 +869,10 @@ void egit_init(emacs_env *env)
     DEFUN("libgit-revwalk-simplifiy-first-parent", revwalk_simplify_first_parent, 1, 1);
     DEFUN("libgit-revwalk-sorting", revwalk_sorting, 1, 2);
 
-    DEFUN("libgit-revwalk-foreach", revwalk_foreach, 2, 3);
+    DEFUN("libgit-revwalk-foreach", revwalk_foreach, 2, 4);
+    DEFUN("libgit-revwalk-next", revwalk_next, 1, 1);
+    DEFUN("libgit-revwalk-next-n", revwalk_next_n, 2, 3);
+    DEFUN("libgit-revwalk-search", revwalk_search, 2, 6);
 
     // Signature
     DEFUN("libgit-signature-default", signature_default, 1, 1);
@@ -846,18 +946,27 @@ void egit_init(emacs_env *env)
     DEFUN("libgit-tree-id", tree_id, 1, 1);
     DEFUN("libgit-tree-owner", tree_owner, 1, 1);
 
-    DEFUN("libgit-tree-entry-byid", tree_entry_byid, 2, 2);
-    DEFUN("libgit-tree-entry-byindex", tree_entry_byindex, 2, 2);
-    DEFUN("libgit-tree-entry-byname", tree_entry_byname, 2, 2);
-    DEFUN("libgit-tree-entry-bypath", tree_entry_bypath, 2, 2);
+    DEFUN("libgit-tree-entry-byid", tree_entry_byid, 2, 3);
+    DEFUN("libgit-tree-entry-byindex", tree_entry_byindex, 2, 3);
+    DEFUN("libgit-tree-entry-byname", tree_entry_byname, 2, 3);
+    DEFUN("libgit-tree-entry-bypath", tree_entry_bypath, 2, 3);
+    DEFUN("libgit-tree-entries-bypath", tree_entries_bypath, 2, 3);
     DEFUN("libgit-tree-entrycount", tree_entrycount, 1, 1);
 
+    DEFUN("libgit-tree-entry-name", tree_entry_name, 1, 1);
+    DEFUN("libgit-tree-entry-filemode", tree_entry_filemode, 1, 1);
+    DEFUN("libgit-tree-entry-type", tree_entry_type, 1, 1);
+    DEFUN("libgit-tree-entry-id", tree_entry_id, 1, 1);
+    DEFUN("libgit-tree-entry-cmp", tree_entry_cmp, 2, 2);
+    DEFUN("libgit-tree-entry-to-object", tree_entry_to_object, 2, 2);
+
     DEFUN("libgit-tree-walk", tree_walk, 3, 3);
+    DEFUN("libgit-tree-list", tree_list, 1, 4);
 
     // Treebuilder
     DEFUN("libgit-treebuilder-new", treebuilder_new, 1, 2);
     DEFUN("libgit-treebuilder-entrycount", treebuilder_entrycount, 1, 1);
-    DEFUN("libgit-treebuilder-get", treebuilder_get, 2, 2);
+    DEFUN("libgit-treebuilder-get", treebuilder_get, 2, 3);
     DEFUN("libgit-treebuilder-clear", treebuilder_clear, 1, 1);
     DEFUN("libgit-treebuilder-insert", treebuilder_insert, 4, 4);
     DEFUN("libgit-treebuilder-remove", treebuilder_remove, 2, 2);
@@ -40,6 +40,10 @@
 #define EGIT_ASSERT_BLOB(val)                                           \
     do { if (!egit_assert_type(env, (val), EGIT_BLOB, esym_libgit_blob_p)) return esym_nil; } while (0)
 
+// Assert that VAL is a blame job, signal an error and return otherwise.
+#define EGIT_ASSERT_BLAME_JOB(val)                                      \
+    do { if (!egit_assert_type(env, (val), EGIT_BLAME_JOB, esym_libgit_blame_job_p)) return esym_nil; } while (0)
+
 // Assert that VAL is a git blame hunk, signal an error and return otherwise.
 #define EGIT_ASSERT_BLAME_HUNK(val)                                     \
     do { if (!egit_assert_type(env, (val), EGIT_BLAME_HUNK, esym_libgit_blame_hunk_p)) return esym_nil; } while (0)
@@ -76,6 +80,10 @@
 #define EGIT_ASSERT_DIFF_LINE(val)                                     \
     do { if (!egit_assert_type(env, (val), EGIT_DIFF_LINE, esym_libgit_diff_line_p)) return esym_nil; } while (0)
 
+// Assert that VAL is a graph layout, signal an error and return otherwise.
+#define EGIT_ASSERT_GRAPH_LAYOUT(val)                                   \
+    do { if (!egit_assert_type(env, (val), EGIT_GRAPH_LAYOUT, esym_libgit_graph_layout_p)) return esym_nil; } while (0)
+
 // Assert that VAL is a git index, signal an error and return otherwise.
 #define EGIT_ASSERT_INDEX(val)                                          \
     do { if (!egit_assert_type(env, (val), EGIT_INDEX, esym_libgit_index_p)) return esym_nil; } while (0)
@@ -148,6 +156,10 @@
 #define EGIT_ASSERT_TREE(val)                                           \
     do { if (!egit_assert_type(env, (val), EGIT_TREE, esym_libgit_tree_p)) return esym_nil; } while (0)
 
+// Assert that VAL is a tree entry, signal an error and return otherwise.
+#define EGIT_ASSERT_TREE_ENTRY(val)                                     \
+    do { if (!egit_assert_type(env, (val), EGIT_TREE_ENTRY, esym_libgit_tree_entry_p)) return esym_nil; } while (0)
+
 // Assert that VAL is a treebuilder, signal an error and return otherwise.
 #define EGIT_ASSERT_TREEBUILDER(val)                                    \
     do { if (!egit_assert_type(env, (val), EGIT_TREEBUILDER, esym_libgit_treebuilder_p)) return esym_nil; } while (0)
@@ -276,7 +288,10 @@ typedef enum {
     EGIT_REFLOG,
     EGIT_REFLOG_ENTRY,
     EGIT_REVWALK,
-    EGIT_TREEBUILDER
+    EGIT_TREEBUILDER,
+    EGIT_GRAPH_LAYOUT,
+    EGIT_BLAME_JOB,
+    EGIT_TREE_ENTRY
 } egit_type;
 
 /**
@@ -292,11 +307,18 @@ typedef enum {
  */
 typedef struct egit_object_s egit_object;
 
+/**
+ * Function freeing the state attached to a wrapper.
+ */
+typedef void (*egit_state_free_cb)(void *state);
+
 struct egit_object_s {
     egit_type type;             /**< Type of object stored. */
     ptrdiff_t refcount;         /**< Reference count. */
     void *ptr;                  /**< Pointer to git_??? structure. */
     egit_object *parent;        /**< Optional pointer to parent wrapper. */
+    void *state;                /**< Optional state kept between calls, e.g. during a walk. */
+    egit_state_free_cb state_free; /**< Function freeing the state, also identifying its kind. */
 };
 
 /**
@@ -351,6 +373,23 @@ void egit_finalize(void* _obj);
  */
 emacs_value egit_wrap(emacs_env *env, egit_type type, const void* ptr, egit_object *parent);
 
+/**
+ * Get the state attached to a wrapper.
+ * @param obj The wrapper.
+ * @param state_free The function freeing the kind of state wanted.
+ * @return The state, or NULL if there is none or it is of another kind.
+ */
+void *egit_state_get(egit_object *obj, egit_state_free_cb state_free);
+
+/**
+ * Attach state to a wrapper, freeing any state it had before.
+ * The state is freed along with the wrapper.
+ * @param obj The wrapper.
+ * @param state The new state, or NULL to only free the old one.
+ * @param state_free The function freeing the new state.
+ */
+void egit_state_set(egit_object *obj, void *state, egit_state_free_cb state_free);
+
 /**
  * If libgit2 signaled an error, dispatch that error to Emacs.
  * @param env The active Emacs environment.
@@ -162,11 +162,21 @@ emacs_value em_list(emacs_env *env, emacs_value *objects, ptrdiff_t nobjects)
     return env->funcall(env, esym_list, nobjects, objects);
 }
 
+emacs_value em_vector(emacs_env *env, emacs_value *objects, ptrdiff_t nobjects)
+{
+    return env->funcall(env, esym_vector, nobjects, objects);
+}
+
 bool em_listp(emacs_env *env, emacs_value object)
 {
     return EM_EXTRACT_BOOLEAN(em_funcall(env, esym_listp, 1, object));
 }
 
+bool em_vectorp(emacs_env *env, emacs_value object)
+{
+    return EM_EXTRACT_BOOLEAN(em_funcall(env, esym_vectorp, 1, object));
+}
+
 ptrdiff_t em_length(emacs_env *env, emacs_value sequence)
 {
     emacs_value result = em_funcall(env, esym_length, 1, sequence);
@@ -251,11 +261,23 @@ void em_insert(emacs_env *env, const char *ptr, size_t length)
     em_funcall(env, esym_insert, 1, env->make_string(env, ptr, length));
 }
 
+bool em_buffer_multibyte_p(emacs_env *env)
+{
+    return EM_EXTRACT_BOOLEAN(em_funcall(env, esym_symbol_value, 1, esym_enable_multibyte_characters));
+}
+
 emacs_value em_string_as_unibyte(emacs_env *env, emacs_value str)
 {
     return em_funcall(env, esym_string_as_unibyte, 1, str);
 }
 
+bool em_should_quit(emacs_env *env)
+{
+    if (env->size < (ptrdiff_t) sizeof(struct emacs_env_26))
+        return false;
+    return env->should_quit(env);
+}
+
 
 // =============================================================================
 // Symbol <-> enum map functions
@@ -286,6 +308,7 @@ static bool em_findsym(esym_enumval *out, emacs_env *env, emacs_value value, esy
         return retval;                                                  \
     }
 
+MKFINDSYM(git_apply_location_t, apply_location);
 MKFINDSYM(git_branch_t, branch);
 MKFINDSYM(git_checkout_strategy_t, checkout_strategy);
 MKFINDSYM(git_config_level_t, config_level);
@@ -415,6 +438,7 @@ bool em_setflags_alist(void *out, emacs_env *env, emacs_value alist,
     }
 
 MKGETLIST(git_credtype_t, credtype);
+MKGETLIST(int, idxentry);
 MKGETLIST(int, indexcap);
 MKGETLIST(git_merge_analysis_t, merge_analysis);
 MKGETLIST(git_status_t, status);
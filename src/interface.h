@@ -227,6 +227,14 @@ emacs_value em_cdr(emacs_env *env, emacs_value cell);
  */
 emacs_value em_list(emacs_env *env, emacs_value *objects, ptrdiff_t nobjects);
 
+/**
+ * Call (vector OBJECTS...) in Emacs.
+ * @param env The active Emacs environment.
+ * @param objects Array of objects.
+ * @param nobjects Number of \p objects.
+ */
+emacs_value em_vector(emacs_env *env, emacs_value *objects, ptrdiff_t nobjects);
+
 /**
  * Call (listp OBJECT) in Emacs.
  * @param env The active Emacs environment.
@@ -234,6 +242,13 @@ emacs_value em_list(emacs_env *env, emacs_value *objects, ptrdiff_t nobjects);
  */
 bool em_listp(emacs_env *env, emacs_value object);
 
+/**
+ * Call (vectorp OBJECT) in Emacs.
+ * @param env The active Emacs environment.
+ * @param object An emacs value.
+ */
+bool em_vectorp(emacs_env *env, emacs_value object);
+
 /**
  * Call (length SEQUENCE) in Emacs.
  * @param env The active Emacs environment.
@@ -310,15 +325,27 @@ bool em_encode_time(emacs_env *env, emacs_value time, intmax_t *timestamp, intma
  */
 void em_insert(emacs_env *env, const char *ptr, size_t length);
 
+/**
+ * Return the value of enable-multibyte-characters in the current buffer.
+ */
+bool em_buffer_multibyte_p(emacs_env *env);
+
 /**
  * Convert an emacs string to unibyte.
  */
 emacs_value em_string_as_unibyte(emacs_env *env, emacs_value str);
 
+/**
+ * Check whether the user has requested a quit.
+ * Always false in Emacs versions before 26.
+ */
+bool em_should_quit(emacs_env *env);
+
 
 // =============================================================================
 // Symbol <-> enum map functions
 
+bool em_findsym_apply_location(git_apply_location_t *out, emacs_env *env, emacs_value value, bool required);
 bool em_findsym_branch(git_branch_t *out, emacs_env *env, emacs_value value, bool required);
 bool em_findsym_checkout_strategy(git_checkout_strategy_t *out, emacs_env *env, emacs_value value, bool required);
 bool em_findsym_config_level(git_config_level_t *out, emacs_env *env, emacs_value value, bool required);
@@ -368,6 +395,7 @@ bool em_setflags_list(void *out, emacs_env *env, emacs_value list, bool required
 bool em_setflags_alist(void *out, emacs_env *env, emacs_value alist, bool required, setter *setter);
 
 emacs_value em_getlist_credtype(emacs_env *env, git_credtype_t value);
+emacs_value em_getlist_idxentry(emacs_env *env, int value);
 emacs_value em_getlist_indexcap(emacs_env *env, int value);
 emacs_value em_getlist_merge_analysis(emacs_env *env, git_merge_analysis_t value);
 emacs_value em_getlist_status(emacs_env *env, git_status_t value);
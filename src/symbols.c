@@ -5,11 +5,14 @@
 #include "symbols.h"
 #include "git2.h"
 
+emacs_value esym_abbrev;
 emacs_value esym_abbreviated_size;
 emacs_value esym_abort;
 emacs_value esym_added;
+emacs_value esym_ahead_behind;
 emacs_value esym_all;
 emacs_value esym_always_use_long_format;
+emacs_value esym_ambiguous;
 emacs_value esym_annotated_commit;
 emacs_value esym_any;
 emacs_value esym_app;
@@ -18,14 +21,22 @@ emacs_value esym_apply_mailbox;
 emacs_value esym_apply_mailbox_or_rebase;
 emacs_value esym_args_out_of_range;
 emacs_value esym_assq;
+emacs_value esym_assume_valid;
+emacs_value esym_author;
+emacs_value esym_author_email;
+emacs_value esym_author_name;
+emacs_value esym_author_time;
 emacs_value esym_auto;
 emacs_value esym_base;
 emacs_value esym_baseline;
 emacs_value esym_bisect;
 emacs_value esym_blame;
 emacs_value esym_blame_hunk;
+emacs_value esym_blame_job;
 emacs_value esym_blob;
 emacs_value esym_blob_executable;
+emacs_value esym_both;
+emacs_value esym_branch;
 emacs_value esym_break_rewrites;
 emacs_value esym_break_rewrites_for_renames_only;
 emacs_value esym_break_rewrite_threshold;
@@ -38,6 +49,10 @@ emacs_value esym_checkout;
 emacs_value esym_cherrypick;
 emacs_value esym_cherrypick_sequence;
 emacs_value esym_commit;
+emacs_value esym_committer;
+emacs_value esym_committer_email;
+emacs_value esym_committer_name;
+emacs_value esym_committer_time;
 emacs_value esym_config;
 emacs_value esym_conflict;
 emacs_value esym_conflicted;
@@ -67,6 +82,7 @@ emacs_value esym_dirty_suffix;
 emacs_value esym_disable_pathspec_match;
 emacs_value esym_download_tags;
 emacs_value esym_enable_fast_untracked_dirs;
+emacs_value esym_enable_multibyte_characters;
 emacs_value esym_encode_time;
 emacs_value esym_exclude_submodules;
 emacs_value esym_expand_file_name;
@@ -95,6 +111,7 @@ emacs_value esym_flags;
 emacs_value esym_force;
 emacs_value esym_force_binary;
 emacs_value esym_force_text;
+emacs_value esym_fork_out;
 emacs_value esym_from_owner;
 emacs_value esym_functionp;
 emacs_value esym_giterr;
@@ -132,6 +149,7 @@ emacs_value esym_giterr_tree;
 emacs_value esym_giterr_worktree;
 emacs_value esym_giterr_zlib;
 emacs_value esym_global;
+emacs_value esym_graph_layout;
 emacs_value esym_hard;
 emacs_value esym_headers;
 emacs_value esym_hostkey_libssh2;
@@ -169,11 +187,13 @@ emacs_value esym_index_renamed;
 emacs_value esym_index_typechange;
 emacs_value esym_insert;
 emacs_value esym_integerp;
+emacs_value esym_intent_to_add;
 emacs_value esym_interhunk_lines;
 emacs_value esym_last;
 emacs_value esym_length;
 emacs_value esym_libgit_annotated_commit_p;
 emacs_value esym_libgit_blame_hunk_p;
+emacs_value esym_libgit_blame_job_p;
 emacs_value esym_libgit_blame_p;
 emacs_value esym_libgit_blob_p;
 emacs_value esym_libgit_commit_p;
@@ -184,6 +204,7 @@ emacs_value esym_libgit_diff_delta_p;
 emacs_value esym_libgit_diff_hunk_p;
 emacs_value esym_libgit_diff_line_p;
 emacs_value esym_libgit_diff_p;
+emacs_value esym_libgit_graph_layout_p;
 emacs_value esym_libgit_index_entry_p;
 emacs_value esym_libgit_index_p;
 emacs_value esym_libgit_object_p;
@@ -200,6 +221,7 @@ emacs_value esym_libgit_signature_p;
 emacs_value esym_libgit_submodule_p;
 emacs_value esym_libgit_tag_p;
 emacs_value esym_libgit_transaction_p;
+emacs_value esym_libgit_tree_entry_p;
 emacs_value esym_libgit_tree_p;
 emacs_value esym_libgit_treebuilder_p;
 emacs_value esym_link;
@@ -207,12 +229,17 @@ emacs_value esym_list;
 emacs_value esym_listp;
 emacs_value esym_local;
 emacs_value esym_max_candidates_tags;
+emacs_value esym_max_count;
 emacs_value esym_max_line;
+emacs_value esym_max_parents;
 emacs_value esym_max_size;
 emacs_value esym_md5;
 emacs_value esym_merge;
+emacs_value esym_merge_in;
+emacs_value esym_message;
 emacs_value esym_metric;
 emacs_value esym_min_line;
+emacs_value esym_min_parents;
 emacs_value esym_minimal;
 emacs_value esym_mixed;
 emacs_value esym_modified;
@@ -231,18 +258,23 @@ emacs_value esym_no_refresh;
 emacs_value esym_no_symlinks;
 emacs_value esym_none;
 emacs_value esym_normal;
+emacs_value esym_note;
 emacs_value esym_notify;
 emacs_value esym_notify_when;
 emacs_value esym_nsec;
 emacs_value esym_object;
 emacs_value esym_off;
+emacs_value esym_oid;
 emacs_value esym_old;
 emacs_value esym_old_prefix;
 emacs_value esym_oldest_commit;
 emacs_value esym_on;
 emacs_value esym_ondemand;
 emacs_value esym_only_follow_first_parent;
+emacs_value esym_other;
 emacs_value esym_ours;
+emacs_value esym_parents;
+emacs_value esym_pass;
 emacs_value esym_patch;
 emacs_value esym_patch_header;
 emacs_value esym_pathspec;
@@ -291,9 +323,11 @@ emacs_value esym_show_untracked_content;
 emacs_value esym_sideband_progress;
 emacs_value esym_signature;
 emacs_value esym_simplify_alnum;
+emacs_value esym_since;
 emacs_value esym_skip;
 emacs_value esym_skip_binary_check;
 emacs_value esym_skip_reuc;
+emacs_value esym_skip_worktree;
 emacs_value esym_soft;
 emacs_value esym_sort_case_insensitively;
 emacs_value esym_sort_case_sensitively;
@@ -310,6 +344,7 @@ emacs_value esym_stringp;
 emacs_value esym_style_diff3;
 emacs_value esym_style_merge;
 emacs_value esym_submodule;
+emacs_value esym_summary;
 emacs_value esym_symbol_value;
 emacs_value esym_symbolic;
 emacs_value esym_system;
@@ -328,6 +363,7 @@ emacs_value esym_track_copies_same_file;
 emacs_value esym_transaction;
 emacs_value esym_transfer_progress;
 emacs_value esym_tree;
+emacs_value esym_tree_entry;
 emacs_value esym_treebuilder;
 emacs_value esym_type;
 emacs_value esym_typechange;
@@ -336,6 +372,7 @@ emacs_value esym_union;
 emacs_value esym_unmodified;
 emacs_value esym_unreadable;
 emacs_value esym_unspecified;
+emacs_value esym_until;
 emacs_value esym_untracked;
 emacs_value esym_up_to_date;
 emacs_value esym_update_fetchhead;
@@ -348,6 +385,7 @@ emacs_value esym_user_ptrp;
 emacs_value esym_username;
 emacs_value esym_userpass_plaintext;
 emacs_value esym_vector;
+emacs_value esym_vectorp;
 emacs_value esym_wd_added;
 emacs_value esym_wd_deleted;
 emacs_value esym_wd_index_modified;
@@ -355,6 +393,7 @@ emacs_value esym_wd_modified;
 emacs_value esym_wd_uninitialized;
 emacs_value esym_wd_untracked;
 emacs_value esym_wd_wd_modified;
+emacs_value esym_workdir;
 emacs_value esym_workdir_only;
 emacs_value esym_wrong_type_argument;
 emacs_value esym_wrong_value_argument;
@@ -366,6 +405,13 @@ emacs_value esym_wt_typechange;
 emacs_value esym_wt_unreadable;
 emacs_value esym_x509;
 emacs_value esym_xdg;
+esym_map esym_apply_location_map[5] = {
+    {&esym_workdir, {.apply_location = GIT_APPLY_LOCATION_WORKDIR}},
+    {&esym_index, {.apply_location = GIT_APPLY_LOCATION_INDEX}},
+    {&esym_both, {.apply_location = GIT_APPLY_LOCATION_BOTH}},
+    {&esym_nil, {.apply_location = GIT_APPLY_LOCATION_WORKDIR}},
+    {NULL, {0}}
+};
 esym_map esym_blame_flag_map[8] = {
     {&esym_normal, {.blame_flag = GIT_BLAME_NORMAL}},
     {&esym_track_copies_same_file, {.blame_flag = GIT_BLAME_TRACK_COPIES_SAME_FILE}},
@@ -570,6 +616,12 @@ esym_map esym_indexcap_map[5] = {
     {&esym_from_owner, {.indexcap = GIT_INDEXCAP_FROM_OWNER}},
     {NULL, {0}}
 };
+esym_map esym_idxentry_map[4] = {
+    {&esym_assume_valid, {.idxentry = GIT_IDXENTRY_VALID}},
+    {&esym_intent_to_add, {.idxentry = GIT_IDXENTRY_INTENT_TO_ADD}},
+    {&esym_skip_worktree, {.idxentry = GIT_IDXENTRY_SKIP_WORKTREE}},
+    {NULL, {0}}
+};
 esym_map esym_merge_analysis_map[6] = {
     {&esym_none, {.merge_analysis = GIT_MERGE_ANALYSIS_NONE}},
     {&esym_normal, {.merge_analysis = GIT_MERGE_ANALYSIS_NORMAL}},
@@ -778,11 +830,14 @@ esym_map esym_diff_find_map[15] = {
 
 void esyms_init(emacs_env *env)
 {
+    esym_abbrev = env->make_global_ref(env, env->intern(env, "abbrev"));
     esym_abbreviated_size = env->make_global_ref(env, env->intern(env, "abbreviated-size"));
     esym_abort = env->make_global_ref(env, env->intern(env, "abort"));
     esym_added = env->make_global_ref(env, env->intern(env, "added"));
+    esym_ahead_behind = env->make_global_ref(env, env->intern(env, "ahead-behind"));
     esym_all = env->make_global_ref(env, env->intern(env, "all"));
     esym_always_use_long_format = env->make_global_ref(env, env->intern(env, "always-use-long-format"));
+    esym_ambiguous = env->make_global_ref(env, env->intern(env, "ambiguous"));
     esym_annotated_commit = env->make_global_ref(env, env->intern(env, "annotated-commit"));
     esym_any = env->make_global_ref(env, env->intern(env, "any"));
     esym_app = env->make_global_ref(env, env->intern(env, "app"));
@@ -791,14 +846,22 @@ void esyms_init(emacs_env *env)
     esym_apply_mailbox_or_rebase = env->make_global_ref(env, env->intern(env, "apply-mailbox-or-rebase"));
     esym_args_out_of_range = env->make_global_ref(env, env->intern(env, "args-out-of-range"));
     esym_assq = env->make_global_ref(env, env->intern(env, "assq"));
+    esym_assume_valid = env->make_global_ref(env, env->intern(env, "assume-valid"));
+    esym_author = env->make_global_ref(env, env->intern(env, "author"));
+    esym_author_email = env->make_global_ref(env, env->intern(env, "author-email"));
+    esym_author_name = env->make_global_ref(env, env->intern(env, "author-name"));
+    esym_author_time = env->make_global_ref(env, env->intern(env, "author-time"));
     esym_auto = env->make_global_ref(env, env->intern(env, "auto"));
     esym_base = env->make_global_ref(env, env->intern(env, "base"));
     esym_baseline = env->make_global_ref(env, env->intern(env, "baseline"));
     esym_bisect = env->make_global_ref(env, env->intern(env, "bisect"));
     esym_blame = env->make_global_ref(env, env->intern(env, "blame"));
     esym_blame_hunk = env->make_global_ref(env, env->intern(env, "blame-hunk"));
+    esym_blame_job = env->make_global_ref(env, env->intern(env, "blame-job"));
     esym_blob = env->make_global_ref(env, env->intern(env, "blob"));
     esym_blob_executable = env->make_global_ref(env, env->intern(env, "blob-executable"));
+    esym_both = env->make_global_ref(env, env->intern(env, "both"));
+    esym_branch = env->make_global_ref(env, env->intern(env, "branch"));
     esym_break_rewrites = env->make_global_ref(env, env->intern(env, "break-rewrites"));
     esym_break_rewrites_for_renames_only = env->make_global_ref(env, env->intern(env, "break-rewrites-for-renames-only"));
     esym_break_rewrite_threshold = env->make_global_ref(env, env->intern(env, "break_rewrite_threshold"));
@@ -811,6 +874,10 @@ void esyms_init(emacs_env *env)
     esym_cherrypick = env->make_global_ref(env, env->intern(env, "cherrypick"));
     esym_cherrypick_sequence = env->make_global_ref(env, env->intern(env, "cherrypick-sequence"));
     esym_commit = env->make_global_ref(env, env->intern(env, "commit"));
+    esym_committer = env->make_global_ref(env, env->intern(env, "committer"));
+    esym_committer_email = env->make_global_ref(env, env->intern(env, "committer-email"));
+    esym_committer_name = env->make_global_ref(env, env->intern(env, "committer-name"));
+    esym_committer_time = env->make_global_ref(env, env->intern(env, "committer-time"));
     esym_config = env->make_global_ref(env, env->intern(env, "config"));
     esym_conflict = env->make_global_ref(env, env->intern(env, "conflict"));
     esym_conflicted = env->make_global_ref(env, env->intern(env, "conflicted"));
@@ -840,6 +907,7 @@ void esyms_init(emacs_env *env)
     esym_disable_pathspec_match = env->make_global_ref(env, env->intern(env, "disable-pathspec-match"));
     esym_download_tags = env->make_global_ref(env, env->intern(env, "download-tags"));
     esym_enable_fast_untracked_dirs = env->make_global_ref(env, env->intern(env, "enable-fast-untracked-dirs"));
+    esym_enable_multibyte_characters = env->make_global_ref(env, env->intern(env, "enable-multibyte-characters"));
     esym_encode_time = env->make_global_ref(env, env->intern(env, "encode-time"));
     esym_exclude_submodules = env->make_global_ref(env, env->intern(env, "exclude-submodules"));
     esym_expand_file_name = env->make_global_ref(env, env->intern(env, "expand-file-name"));
@@ -868,6 +936,7 @@ void esyms_init(emacs_env *env)
     esym_force = env->make_global_ref(env, env->intern(env, "force"));
     esym_force_binary = env->make_global_ref(env, env->intern(env, "force-binary"));
     esym_force_text = env->make_global_ref(env, env->intern(env, "force-text"));
+    esym_fork_out = env->make_global_ref(env, env->intern(env, "fork-out"));
     esym_from_owner = env->make_global_ref(env, env->intern(env, "from-owner"));
     esym_functionp = env->make_global_ref(env, env->intern(env, "functionp"));
     esym_giterr = env->make_global_ref(env, env->intern(env, "giterr"));
@@ -905,6 +974,7 @@ void esyms_init(emacs_env *env)
     esym_giterr_worktree = env->make_global_ref(env, env->intern(env, "giterr-worktree"));
     esym_giterr_zlib = env->make_global_ref(env, env->intern(env, "giterr-zlib"));
     esym_global = env->make_global_ref(env, env->intern(env, "global"));
+    esym_graph_layout = env->make_global_ref(env, env->intern(env, "graph-layout"));
     esym_hard = env->make_global_ref(env, env->intern(env, "hard"));
     esym_headers = env->make_global_ref(env, env->intern(env, "headers"));
     esym_hostkey_libssh2 = env->make_global_ref(env, env->intern(env, "hostkey-libssh2"));
@@ -942,11 +1012,13 @@ void esyms_init(emacs_env *env)
     esym_index_typechange = env->make_global_ref(env, env->intern(env, "index-typechange"));
     esym_insert = env->make_global_ref(env, env->intern(env, "insert"));
     esym_integerp = env->make_global_ref(env, env->intern(env, "integerp"));
+    esym_intent_to_add = env->make_global_ref(env, env->intern(env, "intent-to-add"));
     esym_interhunk_lines = env->make_global_ref(env, env->intern(env, "interhunk-lines"));
     esym_last = env->make_global_ref(env, env->intern(env, "last"));
     esym_length = env->make_global_ref(env, env->intern(env, "length"));
     esym_libgit_annotated_commit_p = env->make_global_ref(env, env->intern(env, "libgit-annotated-commit-p"));
     esym_libgit_blame_hunk_p = env->make_global_ref(env, env->intern(env, "libgit-blame-hunk-p"));
+    esym_libgit_blame_job_p = env->make_global_ref(env, env->intern(env, "libgit-blame-job-p"));
     esym_libgit_blame_p = env->make_global_ref(env, env->intern(env, "libgit-blame-p"));
     esym_libgit_blob_p = env->make_global_ref(env, env->intern(env, "libgit-blob-p"));
     esym_libgit_commit_p = env->make_global_ref(env, env->intern(env, "libgit-commit-p"));
@@ -957,6 +1029,7 @@ void esyms_init(emacs_env *env)
     esym_libgit_diff_hunk_p = env->make_global_ref(env, env->intern(env, "libgit-diff-hunk-p"));
     esym_libgit_diff_line_p = env->make_global_ref(env, env->intern(env, "libgit-diff-line-p"));
     esym_libgit_diff_p = env->make_global_ref(env, env->intern(env, "libgit-diff-p"));
+    esym_libgit_graph_layout_p = env->make_global_ref(env, env->intern(env, "libgit-graph-layout-p"));
     esym_libgit_index_entry_p = env->make_global_ref(env, env->intern(env, "libgit-index-entry-p"));
     esym_libgit_index_p = env->make_global_ref(env, env->intern(env, "libgit-index-p"));
     esym_libgit_object_p = env->make_global_ref(env, env->intern(env, "libgit-object-p"));
@@ -973,6 +1046,7 @@ void esyms_init(emacs_env *env)
     esym_libgit_submodule_p = env->make_global_ref(env, env->intern(env, "libgit-submodule-p"));
     esym_libgit_tag_p = env->make_global_ref(env, env->intern(env, "libgit-tag-p"));
     esym_libgit_transaction_p = env->make_global_ref(env, env->intern(env, "libgit-transaction-p"));
+    esym_libgit_tree_entry_p = env->make_global_ref(env, env->intern(env, "libgit-tree-entry-p"));
     esym_libgit_tree_p = env->make_global_ref(env, env->intern(env, "libgit-tree-p"));
     esym_libgit_treebuilder_p = env->make_global_ref(env, env->intern(env, "libgit-treebuilder-p"));
     esym_link = env->make_global_ref(env, env->intern(env, "link"));
@@ -980,12 +1054,17 @@ void esyms_init(emacs_env *env)
     esym_listp = env->make_global_ref(env, env->intern(env, "listp"));
     esym_local = env->make_global_ref(env, env->intern(env, "local"));
     esym_max_candidates_tags = env->make_global_ref(env, env->intern(env, "max-candidates-tags"));
+    esym_max_count = env->make_global_ref(env, env->intern(env, "max-count"));
     esym_max_line = env->make_global_ref(env, env->intern(env, "max-line"));
+    esym_max_parents = env->make_global_ref(env, env->intern(env, "max-parents"));
     esym_max_size = env->make_global_ref(env, env->intern(env, "max-size"));
     esym_md5 = env->make_global_ref(env, env->intern(env, "md5"));
     esym_merge = env->make_global_ref(env, env->intern(env, "merge"));
+    esym_merge_in = env->make_global_ref(env, env->intern(env, "merge-in"));
+    esym_message = env->make_global_ref(env, env->intern(env, "message"));
     esym_metric = env->make_global_ref(env, env->intern(env, "metric"));
     esym_min_line = env->make_global_ref(env, env->intern(env, "min-line"));
+    esym_min_parents = env->make_global_ref(env, env->intern(env, "min-parents"));
     esym_minimal = env->make_global_ref(env, env->intern(env, "minimal"));
     esym_mixed = env->make_global_ref(env, env->intern(env, "mixed"));
     esym_modified = env->make_global_ref(env, env->intern(env, "modified"));
@@ -1004,18 +1083,23 @@ void esyms_init(emacs_env *env)
     esym_no_symlinks = env->make_global_ref(env, env->intern(env, "no-symlinks"));
     esym_none = env->make_global_ref(env, env->intern(env, "none"));
     esym_normal = env->make_global_ref(env, env->intern(env, "normal"));
+    esym_note = env->make_global_ref(env, env->intern(env, "note"));
     esym_notify = env->make_global_ref(env, env->intern(env, "notify"));
     esym_notify_when = env->make_global_ref(env, env->intern(env, "notify-when"));
     esym_nsec = env->make_global_ref(env, env->intern(env, "nsec"));
     esym_object = env->make_global_ref(env, env->intern(env, "object"));
     esym_off = env->make_global_ref(env, env->intern(env, "off"));
+    esym_oid = env->make_global_ref(env, env->intern(env, "oid"));
     esym_old = env->make_global_ref(env, env->intern(env, "old"));
     esym_old_prefix = env->make_global_ref(env, env->intern(env, "old-prefix"));
     esym_oldest_commit = env->make_global_ref(env, env->intern(env, "oldest-commit"));
     esym_on = env->make_global_ref(env, env->intern(env, "on"));
     esym_ondemand = env->make_global_ref(env, env->intern(env, "ondemand"));
     esym_only_follow_first_parent = env->make_global_ref(env, env->intern(env, "only-follow-first-parent"));
+    esym_other = env->make_global_ref(env, env->intern(env, "other"));
     esym_ours = env->make_global_ref(env, env->intern(env, "ours"));
+    esym_parents = env->make_global_ref(env, env->intern(env, "parents"));
+    esym_pass = env->make_global_ref(env, env->intern(env, "pass"));
     esym_patch = env->make_global_ref(env, env->intern(env, "patch"));
     esym_patch_header = env->make_global_ref(env, env->intern(env, "patch-header"));
     esym_pathspec = env->make_global_ref(env, env->intern(env, "pathspec"));
@@ -1064,9 +1148,11 @@ void esyms_init(emacs_env *env)
     esym_sideband_progress = env->make_global_ref(env, env->intern(env, "sideband-progress"));
     esym_signature = env->make_global_ref(env, env->intern(env, "signature"));
     esym_simplify_alnum = env->make_global_ref(env, env->intern(env, "simplify-alnum"));
+    esym_since = env->make_global_ref(env, env->intern(env, "since"));
     esym_skip = env->make_global_ref(env, env->intern(env, "skip"));
     esym_skip_binary_check = env->make_global_ref(env, env->intern(env, "skip-binary-check"));
     esym_skip_reuc = env->make_global_ref(env, env->intern(env, "skip-reuc"));
+    esym_skip_worktree = env->make_global_ref(env, env->intern(env, "skip-worktree"));
     esym_soft = env->make_global_ref(env, env->intern(env, "soft"));
     esym_sort_case_insensitively = env->make_global_ref(env, env->intern(env, "sort-case-insensitively"));
     esym_sort_case_sensitively = env->make_global_ref(env, env->intern(env, "sort-case-sensitively"));
@@ -1083,6 +1169,7 @@ void esyms_init(emacs_env *env)
     esym_style_diff3 = env->make_global_ref(env, env->intern(env, "style-diff3"));
     esym_style_merge = env->make_global_ref(env, env->intern(env, "style-merge"));
     esym_submodule = env->make_global_ref(env, env->intern(env, "submodule"));
+    esym_summary = env->make_global_ref(env, env->intern(env, "summary"));
     esym_symbol_value = env->make_global_ref(env, env->intern(env, "symbol-value"));
     esym_symbolic = env->make_global_ref(env, env->intern(env, "symbolic"));
     esym_system = env->make_global_ref(env, env->intern(env, "system"));
@@ -1101,6 +1188,7 @@ void esyms_init(emacs_env *env)
     esym_transaction = env->make_global_ref(env, env->intern(env, "transaction"));
     esym_transfer_progress = env->make_global_ref(env, env->intern(env, "transfer-progress"));
     esym_tree = env->make_global_ref(env, env->intern(env, "tree"));
+    esym_tree_entry = env->make_global_ref(env, env->intern(env, "tree-entry"));
     esym_treebuilder = env->make_global_ref(env, env->intern(env, "treebuilder"));
     esym_type = env->make_global_ref(env, env->intern(env, "type"));
     esym_typechange = env->make_global_ref(env, env->intern(env, "typechange"));
@@ -1109,6 +1197,7 @@ void esyms_init(emacs_env *env)
     esym_unmodified = env->make_global_ref(env, env->intern(env, "unmodified"));
     esym_unreadable = env->make_global_ref(env, env->intern(env, "unreadable"));
     esym_unspecified = env->make_global_ref(env, env->intern(env, "unspecified"));
+    esym_until = env->make_global_ref(env, env->intern(env, "until"));
     esym_untracked = env->make_global_ref(env, env->intern(env, "untracked"));
     esym_up_to_date = env->make_global_ref(env, env->intern(env, "up-to-date"));
     esym_update_fetchhead = env->make_global_ref(env, env->intern(env, "update-fetchhead"));
@@ -1121,6 +1210,7 @@ void esyms_init(emacs_env *env)
     esym_username = env->make_global_ref(env, env->intern(env, "username"));
     esym_userpass_plaintext = env->make_global_ref(env, env->intern(env, "userpass-plaintext"));
     esym_vector = env->make_global_ref(env, env->intern(env, "vector"));
+    esym_vectorp = env->make_global_ref(env, env->intern(env, "vectorp"));
     esym_wd_added = env->make_global_ref(env, env->intern(env, "wd-added"));
     esym_wd_deleted = env->make_global_ref(env, env->intern(env, "wd-deleted"));
     esym_wd_index_modified = env->make_global_ref(env, env->intern(env, "wd-index-modified"));
@@ -1128,6 +1218,7 @@ void esyms_init(emacs_env *env)
     esym_wd_uninitialized = env->make_global_ref(env, env->intern(env, "wd-uninitialized"));
     esym_wd_untracked = env->make_global_ref(env, env->intern(env, "wd-untracked"));
     esym_wd_wd_modified = env->make_global_ref(env, env->intern(env, "wd-wd-modified"));
+    esym_workdir = env->make_global_ref(env, env->intern(env, "workdir"));
     esym_workdir_only = env->make_global_ref(env, env->intern(env, "workdir-only"));
     esym_wrong_type_argument = env->make_global_ref(env, env->intern(env, "wrong-type-argument"));
     esym_wrong_value_argument = env->make_global_ref(env, env->intern(env, "wrong-value-argument"));
@@ -9,6 +9,7 @@
 #define SYMBOLS_H
 
 typedef union {
+    git_apply_location_t apply_location;
     git_blame_flag_t blame_flag;
     git_branch_t branch;
     git_cert_ssh_t cert_ssh;
@@ -28,6 +29,7 @@ typedef union {
     git_filemode_t filemode;
     git_index_add_option_t index_add_option;
     int indexcap;
+    int idxentry;
     git_merge_analysis_t merge_analysis;
     git_merge_file_favor_t merge_file_favor;
     git_merge_file_flag_t merge_file_flag;
@@ -56,6 +58,7 @@ typedef struct {
     esym_enumval value;
 } esym_map;
 
+extern esym_map esym_apply_location_map[5];
 extern esym_map esym_blame_flag_map[8];
 extern esym_map esym_branch_map[4];
 extern esym_map esym_cert_ssh_map[3];
@@ -75,6 +78,7 @@ extern esym_map esym_fetch_prune_map[5];
 extern esym_map esym_filemode_map[7];
 extern esym_map esym_index_add_option_map[5];
 extern esym_map esym_indexcap_map[5];
+extern esym_map esym_idxentry_map[4];
 extern esym_map esym_merge_analysis_map[6];
 extern esym_map esym_merge_file_favor_map[5];
 extern esym_map esym_merge_file_flag_map[10];
@@ -96,11 +100,14 @@ extern esym_map esym_submodule_recurse_map[4];
 extern esym_map esym_submodule_update_map[5];
 extern esym_map esym_stage_map[5];
 extern esym_map esym_diff_find_map[15];
+extern emacs_value esym_abbrev;
 extern emacs_value esym_abbreviated_size;
 extern emacs_value esym_abort;
 extern emacs_value esym_added;
+extern emacs_value esym_ahead_behind;
 extern emacs_value esym_all;
 extern emacs_value esym_always_use_long_format;
+extern emacs_value esym_ambiguous;
 extern emacs_value esym_annotated_commit;
 extern emacs_value esym_any;
 extern emacs_value esym_app;
@@ -109,14 +116,22 @@ extern emacs_value esym_apply_mailbox;
 extern emacs_value esym_apply_mailbox_or_rebase;
 extern emacs_value esym_args_out_of_range;
 extern emacs_value esym_assq;
+extern emacs_value esym_assume_valid;
+extern emacs_value esym_author;
+extern emacs_value esym_author_email;
+extern emacs_value esym_author_name;
+extern emacs_value esym_author_time;
 extern emacs_value esym_auto;
 extern emacs_value esym_base;
 extern emacs_value esym_baseline;
 extern emacs_value esym_bisect;
 extern emacs_value esym_blame;
 extern emacs_value esym_blame_hunk;
+extern emacs_value esym_blame_job;
 extern emacs_value esym_blob;
 extern emacs_value esym_blob_executable;
+extern emacs_value esym_both;
+extern emacs_value esym_branch;
 extern emacs_value esym_break_rewrites;
 extern emacs_value esym_break_rewrites_for_renames_only;
 extern emacs_value esym_break_rewrite_threshold;
@@ -129,6 +144,10 @@ extern emacs_value esym_checkout;
 extern emacs_value esym_cherrypick;
 extern emacs_value esym_cherrypick_sequence;
 extern emacs_value esym_commit;
+extern emacs_value esym_committer;
+extern emacs_value esym_committer_email;
+extern emacs_value esym_committer_name;
+extern emacs_value esym_committer_time;
 extern emacs_value esym_config;
 extern emacs_value esym_conflict;
 extern emacs_value esym_conflicted;
@@ -158,6 +177,7 @@ extern emacs_value esym_dirty_suffix;
 extern emacs_value esym_disable_pathspec_match;
 extern emacs_value esym_download_tags;
 extern emacs_value esym_enable_fast_untracked_dirs;
+extern emacs_value esym_enable_multibyte_characters;
 extern emacs_value esym_encode_time;
 extern emacs_value esym_exclude_submodules;
 extern emacs_value esym_expand_file_name;
@@ -186,6 +206,7 @@ extern emacs_value esym_flags;
 extern emacs_value esym_force;
 extern emacs_value esym_force_binary;
 extern emacs_value esym_force_text;
+extern emacs_value esym_fork_out;
 extern emacs_value esym_from_owner;
 extern emacs_value esym_functionp;
 extern emacs_value esym_giterr;
@@ -223,6 +244,7 @@ extern emacs_value esym_giterr_tree;
 extern emacs_value esym_giterr_worktree;
 extern emacs_value esym_giterr_zlib;
 extern emacs_value esym_global;
+extern emacs_value esym_graph_layout;
 extern emacs_value esym_hard;
 extern emacs_value esym_headers;
 extern emacs_value esym_hostkey_libssh2;
@@ -260,11 +282,13 @@ extern emacs_value esym_index_renamed;
 extern emacs_value esym_index_typechange;
 extern emacs_value esym_insert;
 extern emacs_value esym_integerp;
+extern emacs_value esym_intent_to_add;
 extern emacs_value esym_interhunk_lines;
 extern emacs_value esym_last;
 extern emacs_value esym_length;
 extern emacs_value esym_libgit_annotated_commit_p;
 extern emacs_value esym_libgit_blame_hunk_p;
+extern emacs_value esym_libgit_blame_job_p;
 extern emacs_value esym_libgit_blame_p;
 extern emacs_value esym_libgit_blob_p;
 extern emacs_value esym_libgit_commit_p;
@@ -275,6 +299,7 @@ extern emacs_value esym_libgit_diff_delta_p;
 extern emacs_value esym_libgit_diff_hunk_p;
 extern emacs_value esym_libgit_diff_line_p;
 extern emacs_value esym_libgit_diff_p;
+extern emacs_value esym_libgit_graph_layout_p;
 extern emacs_value esym_libgit_index_entry_p;
 extern emacs_value esym_libgit_index_p;
 extern emacs_value esym_libgit_object_p;
@@ -291,6 +316,7 @@ extern emacs_value esym_libgit_signature_p;
 extern emacs_value esym_libgit_submodule_p;
 extern emacs_value esym_libgit_tag_p;
 extern emacs_value esym_libgit_transaction_p;
+extern emacs_value esym_libgit_tree_entry_p;
 extern emacs_value esym_libgit_tree_p;
 extern emacs_value esym_libgit_treebuilder_p;
 extern emacs_value esym_link;
@@ -298,12 +324,17 @@ extern emacs_value esym_list;
 extern emacs_value esym_listp;
 extern emacs_value esym_local;
 extern emacs_value esym_max_candidates_tags;
+extern emacs_value esym_max_count;
 extern emacs_value esym_max_line;
+extern emacs_value esym_max_parents;
 extern emacs_value esym_max_size;
 extern emacs_value esym_md5;
 extern emacs_value esym_merge;
+extern emacs_value esym_merge_in;
+extern emacs_value esym_message;
 extern emacs_value esym_metric;
 extern emacs_value esym_min_line;
+extern emacs_value esym_min_parents;
 extern emacs_value esym_minimal;
 extern emacs_value esym_mixed;
 extern emacs_value esym_modified;
@@ -322,18 +353,23 @@ extern emacs_value esym_no_refresh;
 extern emacs_value esym_no_symlinks;
 extern emacs_value esym_none;
 extern emacs_value esym_normal;
+extern emacs_value esym_note;
 extern emacs_value esym_notify;
 extern emacs_value esym_notify_when;
 extern emacs_value esym_nsec;
 extern emacs_value esym_object;
 extern emacs_value esym_off;
+extern emacs_value esym_oid;
 extern emacs_value esym_old;
 extern emacs_value esym_old_prefix;
 extern emacs_value esym_oldest_commit;
 extern emacs_value esym_on;
 extern emacs_value esym_ondemand;
 extern emacs_value esym_only_follow_first_parent;
+extern emacs_value esym_other;
 extern emacs_value esym_ours;
+extern emacs_value esym_parents;
+extern emacs_value esym_pass;
 extern emacs_value esym_patch;
 extern emacs_value esym_patch_header;
 extern emacs_value esym_pathspec;
@@ -382,9 +418,11 @@ extern emacs_value esym_show_untracked_content;
 extern emacs_value esym_sideband_progress;
 extern emacs_value esym_signature;
 extern emacs_value esym_simplify_alnum;
+extern emacs_value esym_since;
 extern emacs_value esym_skip;
 extern emacs_value esym_skip_binary_check;
 extern emacs_value esym_skip_reuc;
+extern emacs_value esym_skip_worktree;
 extern emacs_value esym_soft;
 extern emacs_value esym_sort_case_insensitively;
 extern emacs_value esym_sort_case_sensitively;
@@ -401,6 +439,7 @@ extern emacs_value esym_stringp;
 extern emacs_value esym_style_diff3;
 extern emacs_value esym_style_merge;
 extern emacs_value esym_submodule;
+extern emacs_value esym_summary;
 extern emacs_value esym_symbol_value;
 extern emacs_value esym_symbolic;
 extern emacs_value esym_system;
@@ -419,6 +458,7 @@ extern emacs_value esym_track_copies_same_file;
 extern emacs_value esym_transaction;
 extern emacs_value esym_transfer_progress;
 extern emacs_value esym_tree;
+extern emacs_value esym_tree_entry;
 extern emacs_value esym_treebuilder;
 extern emacs_value esym_type;
 extern emacs_value esym_typechange;
@@ -427,6 +467,7 @@ extern emacs_value esym_union;
 extern emacs_value esym_unmodified;
 extern emacs_value esym_unreadable;
 extern emacs_value esym_unspecified;
+extern emacs_value esym_until;
 extern emacs_value esym_untracked;
 extern emacs_value esym_up_to_date;
 extern emacs_value esym_update_fetchhead;
@@ -439,6 +480,7 @@ extern emacs_value esym_user_ptrp;
 extern emacs_value esym_username;
 extern emacs_value esym_userpass_plaintext;
 extern emacs_value esym_vector;
+extern emacs_value esym_vectorp;
 extern emacs_value esym_wd_added;
 extern emacs_value esym_wd_deleted;
 extern emacs_value esym_wd_index_modified;
@@ -446,6 +488,7 @@ extern emacs_value esym_wd_modified;
 extern emacs_value esym_wd_uninitialized;
 extern emacs_value esym_wd_untracked;
 extern emacs_value esym_wd_wd_modified;
+extern emacs_value esym_workdir;
 extern emacs_value esym_workdir_only;
 extern emacs_value esym_wrong_type_argument;
 extern emacs_value esym_wrong_value_argument;
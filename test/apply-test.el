@@ -0,0 +1,69 @@
+(defun apply-test-patch (content)
+  "Return the patch between the committed file and CONTENT, then restore it."
+  (write "file" content)
+  (prog1 (run "git" "diff")
+    (run "git" "checkout" "--" "file")))
+
+(ert-deftest apply-workdir ()
+  (with-temp-dir path
+    (init)
+    (commit-change "file" "Line1\nLine2\nLine3\n")
+    (let* ((patch (apply-test-patch "Line1\nLineX\nLine3\n"))
+           (repo (libgit-repository-open path))
+           (diff (libgit-diff-from-buffer patch)))
+      (should (libgit-diff-p diff))
+      (should (= 1 (libgit-diff-num-deltas diff)))
+      (should-not (libgit-apply repo diff 'workdir 'check))
+      (libgit-apply repo diff)
+      (should (string= "Line1\nLineX\nLine3\n" (read-file "file")))
+      (should (string= "" (run "git" "diff" "--cached"))))))
+
+(ert-deftest apply-index ()
+  (with-temp-dir path
+    (init)
+    (commit-change "file" "Line1\nLine2\nLine3\n")
+    (let* ((patch (apply-test-patch "Line1\nLineX\nLine3\n"))
+           (repo (libgit-repository-open path))
+           (diff (libgit-diff-from-buffer patch)))
+      (libgit-apply repo diff 'index)
+      (should (string= "Line1\nLine2\nLine3\n" (read-file "file")))
+      (should (string= "Line1\nLineX\nLine3\n" (run "git" "show" ":file"))))))
+
+(ert-deftest apply-both ()
+  (with-temp-dir path
+    (init)
+    (commit-change "file" "Line1\nLine2\nLine3\n")
+    (let* ((patch (apply-test-patch "Line1\nLineX\nLine3\n"))
+           (repo (libgit-repository-open path))
+           (diff (libgit-diff-from-buffer patch)))
+      (libgit-apply repo diff 'both)
+      (should (string= "Line1\nLineX\nLine3\n" (read-file "file")))
+      (should (string= "Line1\nLineX\nLine3\n" (run "git" "show" ":file"))))))
+
+(ert-deftest apply-check-conflicts ()
+  (with-temp-dir path
+    (init)
+    (commit-change "file" "A\nB\nC\nD\nE\nF\nG\nH\nI\nJ\nK\nL\nM\nN\nO\n")
+    (let* ((patch (apply-test-patch "A\nX\nC\nD\nE\nF\nG\nH\nI\nJ\nK\nL\nM\nY\nO\n"))
+           (repo (libgit-repository-open path))
+           (diff (libgit-diff-from-buffer patch)))
+      (should (= 1 (libgit-diff-num-deltas diff 'modified)))
+      ;; Only the second hunk conflicts with this change
+      (write "file" "A\nB\nC\nD\nE\nF\nG\nH\nI\nJ\nK\nL\nM\nZ\nO\n")
+      (should (equal '(("file" 1)) (libgit-apply repo diff 'workdir 'check)))
+      (should-not (libgit-apply repo diff 'index 'check))
+      (should (equal '(("file" 1)) (libgit-apply repo diff 'both 'check)))
+      ;; Nothing should have been modified
+      (should (string= "A\nB\nC\nD\nE\nF\nG\nH\nI\nJ\nK\nL\nM\nZ\nO\n" (read-file "file")))
+      (should-error (libgit-apply repo diff)))))
+
+(ert-deftest apply-check-missing-file ()
+  (with-temp-dir path
+    (init)
+    (commit-change "file" "Line1\nLine2\nLine3\n")
+    (let* ((patch (apply-test-patch "Line1\nLineX\nLine3\n"))
+           (repo (libgit-repository-open path))
+           (diff (libgit-diff-from-buffer patch)))
+      (delete-file "file")
+      (should (equal '(("file")) (libgit-apply repo diff 'workdir 'check)))
+      (should-not (libgit-apply repo diff 'index 'check)))))
@@ -38,6 +38,45 @@
              (count (libgit-blame-get-hunk-count blame)))
         (should (= 2 count))))))
 
+(ert-deftest blame-hunks ()
+  (with-temp-dir path
+    (init)
+    (commit-change "test" "foo\nbar\nbaz\n")
+    (let ((first (rev-parse)))
+      (commit-change "test" "foo\nbum\nbaz\n")
+      (let* ((second (rev-parse))
+             (repo (libgit-repository-open path))
+             (hunks (libgit-blame-hunks (libgit-blame-file repo "test"))))
+        (should (= 3 (length hunks)))
+        (should (equal (vector first first 1 1 1 "test") (cl-subseq (aref hunks 0) 0 6)))
+        (should (equal (vector second second 2 2 1 "test") (cl-subseq (aref hunks 1) 0 6)))
+        (should (equal (vector first first 3 3 1 "test") (cl-subseq (aref hunks 2) 0 6)))
+        (cl-loop for hunk across hunks
+                 do (should (string= "A U Thor" (aref hunk 6)))
+                 do (should (string= "author@example.com" (aref hunk 7)))
+                 do (should (integerp (aref hunk 8))))
+        ;; Repeated strings are shared
+        (should (eq (aref (aref hunks 0) 6) (aref (aref hunks 1) 6)))
+        (should (eq (aref (aref hunks 0) 0) (aref (aref hunks 2) 0)))))))
+
+(ert-deftest blame-buffer ()
+  (with-temp-dir path
+    (init)
+    (commit-change "test" "foo\nbar\nbaz\n")
+    (let* ((head (rev-parse))
+           (zero (make-string 40 ?0))
+           (repo (libgit-repository-open path))
+           (base (libgit-blame-file repo "test"))
+           (blame (libgit-blame-buffer base "foo\nnew\nbar\nbaz\n")))
+      (should (libgit-blame-p blame))
+      (should (string= head (libgit-blame-hunk-commit-id (libgit-blame-get-hunk-byline blame 1))))
+      (should (string= zero (libgit-blame-hunk-commit-id (libgit-blame-get-hunk-byline blame 2))))
+      (should-not (libgit-blame-hunk-signature (libgit-blame-get-hunk-byline blame 2)))
+      (should (string= head (libgit-blame-hunk-commit-id (libgit-blame-get-hunk-byline blame 3))))
+      (should (string= head (libgit-blame-hunk-commit-id (libgit-blame-get-hunk-byline blame 4))))
+      ;; The base blame is unchanged
+      (should (= 1 (libgit-blame-get-hunk-count base))))))
+
 (ert-deftest blame-file-options-commit-range ()
   (with-temp-dir path
     (init)
@@ -118,3 +157,89 @@
     (let* ((repo (libgit-repository-open path))
            (blame (libgit-blame-file repo "test")))
       (should (= 3 (libgit-blame-get-hunk-count blame))))))
+
+(ert-deftest blame-file-incremental ()
+  (with-temp-dir path
+    (init)
+    (commit-change "test" (mapconcat (lambda (i) (format "line %d\n" i)) (number-sequence 1 600) ""))
+    (let ((first (rev-parse)))
+      (commit-change "test" (concat (mapconcat (lambda (i) (format "line %d\n" i)) (number-sequence 1 299) "")
+                                    "changed\n"
+                                    (mapconcat (lambda (i) (format "line %d\n" i)) (number-sequence 301 600) "")))
+      (let* ((second (rev-parse))
+             (repo (libgit-repository-open path))
+             (job (libgit-blame-file-incremental repo "test" '((min-line . 290) (max-line . 310))))
+             hunks)
+        (should (libgit-blame-job-p job))
+        (with-timeout (10 (error "Incremental blame did not finish"))
+          (while (not (libgit-blame-job-done-p job))
+            (setq hunks (append hunks (libgit-blame-job-poll job)))
+            (sleep-for 0.01)))
+        ;; The visible range comes first
+        (should (= 290 (aref (car hunks) 2)))
+        ;; All lines are covered exactly once
+        (let ((covered (make-vector 601 0)))
+          (dolist (hunk hunks)
+            (dotimes (i (aref hunk 4))
+              (cl-incf (aref covered (+ i (aref hunk 2))))))
+          (should (equal (cdr (append covered nil)) (make-list 600 1))))
+        (dolist (hunk hunks)
+          (should (string= "test" (aref hunk 5)))
+          (should (string= "A U Thor" (aref hunk 6)))
+          (should (string= "author@example.com" (aref hunk 7)))
+          (should (integerp (aref hunk 8)))
+          (should (string= (if (and (<= (aref hunk 2) 300) (< 300 (+ (aref hunk 2) (aref hunk 4))))
+                               second first)
+                           (aref hunk 0))))
+        (should-not (libgit-blame-job-poll job))))))
+
+(ert-deftest blame-file-incremental-cancel ()
+  (with-temp-dir path
+    (init)
+    (commit-change "test" "foo\nbar\n")
+    (let* ((repo (libgit-repository-open path))
+           (job (libgit-blame-file-incremental repo "test"))
+           (bad (libgit-blame-file-incremental repo "missing")))
+      (libgit-blame-job-cancel job)
+      (with-timeout (10 (error "Incremental blame did not stop"))
+        (while (not (libgit-blame-job-done-p job))
+          (libgit-blame-job-poll job)
+          (sleep-for 0.01)))
+      (with-timeout (10 (error "Incremental blame did not fail"))
+        (should-error
+         (while t
+           (libgit-blame-job-poll bad)
+           (sleep-for 0.01))
+         :type 'giterr))
+      (should (libgit-blame-job-done-p bad)))))
+
+(ert-deftest blame-file-hunks-cache ()
+  (with-temp-dir path
+    (init)
+    (commit-change "test" "foo\nbar\nbaz\n")
+    (commit-change "test" "foo\nbum\nbaz\n")
+    (let* ((repo (libgit-repository-open path))
+           (cache-dir (expand-file-name ".git/egit-blame-cache" path))
+           (expected (libgit-blame-hunks (libgit-blame-file repo "test"))))
+      (unwind-protect
+          (progn
+            ;; Disabled by default
+            (should (equal expected (libgit-blame-file-hunks repo "test")))
+            (should-not (file-exists-p cache-dir))
+            (libgit-blame-cache-set-limit (* 1024 1024))
+            (should (equal expected (libgit-blame-file-hunks repo "test")))
+            (should (= 1 (length (directory-files cache-dir nil "\\`[0-9a-f]+\\'"))))
+            ;; Served from the cache
+            (should (equal expected (libgit-blame-file-hunks repo "test")))
+            ;; Options are part of the key
+            (should (= 1 (length (libgit-blame-file-hunks repo "test" '((max-line . 1))))))
+            (should (= 2 (length (directory-files cache-dir nil "\\`[0-9a-f]+\\'"))))
+            ;; Corrupt files are ignored
+            (dolist (file (directory-files cache-dir t "\\`[0-9a-f]+\\'"))
+              (write file "garbage"))
+            (should (equal expected (libgit-blame-file-hunks repo "test")))
+            ;; Old entries are evicted
+            (libgit-blame-cache-set-limit 1)
+            (libgit-blame-file-hunks repo "test" '((min-line . 2)))
+            (should (= 0 (length (directory-files cache-dir nil "\\`[0-9a-f]+\\'")))))
+        (libgit-blame-cache-set-limit nil)))))
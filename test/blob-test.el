@@ -60,3 +60,47 @@
         (should (libgit-blob-p blob))
         (should-not (multibyte-string-p (libgit-blob-rawcontent blob)))
         (should (equal cont (libgit-blob-rawcontent blob)))))))
+
+(ert-deftest blob-insert ()
+  (let ((text "line1\nl\303\251ne2\n")
+        (binary (unibyte-string ?\x7f ?\x45 ?\x4c ?\x46 ?\xb0 ?\x07 ?\x00 ?\xc3 ?\xff)))
+    (with-temp-dir path
+      (init)
+      (commit-change "text" text)
+      (commit-change "binary" binary)
+      (let* ((repo (libgit-repository-open path))
+             (text-blob (libgit-revparse-single repo "HEAD:text"))
+             (binary-blob (libgit-revparse-single repo "HEAD:binary")))
+        ;; Multibyte buffers decode UTF-8
+        (with-temp-buffer
+          (insert "<>")
+          (goto-char 2)
+          (should (= 13 (libgit-blob-insert text-blob)))
+          (should (string= "<line1\nléne2\n>" (buffer-string)))
+          (should (= 14 (point))))
+        (with-temp-buffer
+          (should (= 13 (libgit-blob-insert text-blob "text")))
+          (should (string= "line1\nléne2\n" (buffer-string))))
+        ;; Unibyte buffers get the bytes verbatim
+        (with-temp-buffer
+          (set-buffer-multibyte nil)
+          (should (= 9 (libgit-blob-insert binary-blob)))
+          (should (string= binary (buffer-string))))
+        (with-temp-buffer
+          (set-buffer-multibyte nil)
+          (libgit-blob-insert text-blob)
+          (should (string= text (buffer-string))))))))
+
+(ert-deftest blob-read-range ()
+  (let ((binary (unibyte-string ?\x7f ?\x45 ?\x4c ?\x46 ?\xb0 ?\x07 ?\x00 ?\xc3 ?\xff)))
+    (with-temp-dir path
+      (init)
+      (commit-change "binary" binary)
+      (let* ((repo (libgit-repository-open path))
+             (blob (libgit-revparse-single repo "HEAD:binary")))
+        (should (string= (substring binary 2 5) (libgit-blob-read-range blob 2 3)))
+        (should (string= (substring binary 7) (libgit-blob-read-range blob 7 100)))
+        (should (string= "" (libgit-blob-read-range blob 9 1)))
+        (should-not (multibyte-string-p (libgit-blob-read-range blob 0 9)))
+        (should-error (libgit-blob-read-range blob 10 1) :type 'args-out-of-range)
+        (should-error (libgit-blob-read-range blob -1 1) :type 'args-out-of-range)))))
@@ -0,0 +1,166 @@
+(ert-deftest commit-graph-write ()
+  (let (c1 c2 c3 c4 c5)
+    (with-temp-dir path
+      (init)
+      (commit-change "a" "1")
+      (setq c1 (rev-parse))
+      (run "git" "checkout" "-b" "branch")
+      (commit-change "a" "2")
+      (setq c2 (rev-parse))
+      (commit-change "a" "3")
+      (setq c3 (rev-parse))
+      (run "git" "checkout" "master")
+      (commit-change "b" "4")
+      (setq c4 (rev-parse))
+      (let ((repo (libgit-repository-open path)))
+        (should-not (libgit-commit-graph-generation repo c1))
+        (should (= 4 (libgit-commit-graph-write repo)))
+        (should (file-exists-p (concat path ".git/objects/info/commit-graph")))
+        (should (= 1 (libgit-commit-graph-generation repo c1)))
+        (should (= 3 (libgit-commit-graph-generation repo c3)))
+        (should (= 2 (libgit-commit-graph-generation repo c4)))
+        (commit-change "b" "5")
+        (setq c5 (rev-parse))
+        (should-not (libgit-commit-graph-generation repo c5))
+        (should (= 5 (libgit-commit-graph-write repo)))
+        (should (= 3 (libgit-commit-graph-generation repo c5)))))))
+
+(ert-deftest commit-graph-ancestry ()
+  (let (c1 c2 c3 c4 c5 c6 c7)
+    (with-temp-dir path
+      (init)
+      (commit-change "a" "1")
+      (setq c1 (rev-parse))
+      (run "git" "checkout" "-b" "branch")
+      (commit-change "a" "2")
+      (setq c2 (rev-parse))
+      (commit-change "a" "3")
+      (setq c3 (rev-parse))
+      (commit-change "a" "4")
+      (setq c4 (rev-parse))
+      (run "git" "checkout" "master")
+      (commit-change "a" "5")
+      (setq c5 (rev-parse))
+      (commit-change "a" "6")
+      (setq c6 (rev-parse))
+      (commit-change "a" "7")
+      (setq c7 (rev-parse))
+      (let ((repo (libgit-repository-open path)))
+        (libgit-commit-graph-write repo)
+        (should (equal '(0 . 0) (libgit-graph-ahead-behind repo c1 c1)))
+        (should (equal '(3 . 0) (libgit-graph-ahead-behind repo c4 c1)))
+        (should (equal '(0 . 2) (libgit-graph-ahead-behind repo c1 c3)))
+        (should (equal '(3 . 3) (libgit-graph-ahead-behind repo c4 c7)))
+        (should (libgit-graph-descendant-p repo c2 c1))
+        (should (libgit-graph-descendant-p repo c4 c2))
+        (should-not (libgit-graph-descendant-p repo c1 c3))
+        (should-not (libgit-graph-descendant-p repo c7 c2))
+        (should-not (libgit-graph-descendant-p repo c1 c1))))))
+
+(ert-deftest commit-graph-topo-order ()
+  (let (c1 c2 c3 c4 c5)
+    (with-temp-dir path
+      (init)
+      (commit-change "a" "1")
+      (setq c1 (rev-parse))
+      (run "git" "checkout" "-b" "branch")
+      (commit-change "a" "2")
+      (setq c2 (rev-parse))
+      (run "git" "checkout" "master")
+      (commit-change "b" "3")
+      (setq c3 (rev-parse))
+      (run "git" "merge" "--no-edit" "branch")
+      (setq c4 (rev-parse))
+      (commit-change "c" "4")
+      (setq c5 (rev-parse))
+      (let ((repo (libgit-repository-open path)))
+        (dolist (write '(nil t))
+          (when write (libgit-commit-graph-write repo))
+          (let ((order (append (libgit-commit-graph-topo-order repo (list c5)) nil)))
+            (should (= 5 (length order)))
+            (should (equal c5 (nth 0 order)))
+            (should (equal c4 (nth 1 order)))
+            (should (equal c1 (nth 4 order)))
+            (should (member c2 order))
+            (should (member c3 order)))
+          (should (equal (vector c5 c4)
+                         (libgit-commit-graph-topo-order repo (list c5) 2))))))))
+
+(ert-deftest commit-graph-verify ()
+  (let (c1)
+    (with-temp-dir path
+      (init)
+      (commit-change "a" "1")
+      (setq c1 (rev-parse))
+      (run "git" "checkout" "-b" "b1")
+      (commit-change "b" "2")
+      (run "git" "checkout" "-b" "b2" c1)
+      (commit-change "c" "3")
+      (run "git" "checkout" "master")
+      (commit-change "d" "4")
+      (run "git" "merge" "--no-edit" "b1" "b2")
+      (commit-change "e" "5")
+      (let ((repo (libgit-repository-open path)))
+        (should (= 6 (libgit-commit-graph-write repo)))
+        ;; Signals an error if git rejects the file
+        (run "git" "commit-graph" "verify")))))
+
+(ert-deftest commit-graph-read-git ()
+  (let (c1 c2 c3 c4 c5)
+    (with-temp-dir path
+      (init)
+      (commit-change "a" "1")
+      (setq c1 (rev-parse))
+      (run "git" "checkout" "-b" "branch")
+      (commit-change "a" "2")
+      (setq c2 (rev-parse))
+      (run "git" "checkout" "master")
+      (commit-change "b" "3")
+      (setq c3 (rev-parse))
+      (run "git" "merge" "--no-edit" "branch")
+      (setq c4 (rev-parse))
+      (commit-change "c" "4")
+      (setq c5 (rev-parse))
+      (run "git" "commit-graph" "write" "--reachable")
+      (let ((repo (libgit-repository-open path)))
+        (should (= 1 (libgit-commit-graph-generation repo c1)))
+        (should (= 2 (libgit-commit-graph-generation repo c2)))
+        (should (= 2 (libgit-commit-graph-generation repo c3)))
+        (should (= 3 (libgit-commit-graph-generation repo c4)))
+        (should (= 4 (libgit-commit-graph-generation repo c5)))
+        (should (libgit-graph-descendant-p repo c4 c2))
+        (should (libgit-graph-descendant-p repo c4 c3))
+        (should-not (libgit-graph-descendant-p repo c3 c2))
+        (should (equal '(3 . 0) (libgit-graph-ahead-behind repo c5 c3)))
+        (should (equal (vector c5 c4)
+                       (libgit-commit-graph-topo-order repo (list c5) 2)))))))
+
+(ert-deftest commit-graph-merge-bases ()
+  (let (c1 c2 c3 c4 c5 c6)
+    (with-temp-dir path
+      (init)
+      (commit-change "a" "1")
+      (setq c1 (rev-parse))
+      (run "git" "checkout" "-b" "branch")
+      (commit-change "b" "2")
+      (setq c2 (rev-parse))
+      (run "git" "checkout" "master")
+      (commit-change "c" "3")
+      (setq c3 (rev-parse))
+      ;; Criss-cross merge, with two merge bases
+      (run "git" "merge" "--no-edit" c2)
+      (setq c4 (rev-parse))
+      (run "git" "checkout" "branch")
+      (run "git" "merge" "--no-edit" c3)
+      (setq c5 (rev-parse))
+      (commit-change "d" "4")
+      (setq c6 (rev-parse))
+      (let ((repo (libgit-repository-open path)))
+        (dolist (write '(nil t))
+          (when write (libgit-commit-graph-write repo))
+          (should (equal (sort (list c2 c3) #'string<)
+                         (sort (libgit-merge-bases repo (list c4 c6)) #'string<)))
+          (should (member (libgit-merge-base repo (list c4 c6)) (list c2 c3)))
+          (should (equal c1 (libgit-merge-base repo (list c2 c3))))
+          (should (equal c2 (libgit-merge-base repo (list c2 c6))))
+          (should (equal c3 (libgit-merge-base repo (list c3 c2 c4)))))))))
@@ -56,3 +56,52 @@
         (should (libgit-graph-descendant-p repo c4 c2))
         (should-not (libgit-graph-descendant-p repo c7 c2))
         (should-not (libgit-graph-descendant-p repo c2 c7))))))
+
+(ert-deftest graph-layout ()
+  (let (c1 c2 c3 c4)
+    (with-temp-dir path
+      (init)
+      (commit-change "a" "1")
+      (setq c1 (rev-parse))
+      (run "git" "checkout" "-b" "branch")
+      (commit-change "b" "2")
+      (setq c2 (rev-parse))
+      (run "git" "checkout" "master")
+      (commit-change "c" "3")
+      (setq c3 (rev-parse))
+      (run "git" "merge" "--no-edit" "branch")
+      (setq c4 (rev-parse))
+      (let* ((repo (libgit-repository-open path))
+             (layout (libgit-graph-layout-new repo)))
+        (should (libgit-graph-layout-p layout))
+        (should (eq 'graph-layout (libgit-typeof layout)))
+        (should (equal (vector `(,c4 0 ((fork-out 0) (fork-out 1)))
+                               `(,c3 0 ((merge-in 0) (pass 1 1) (fork-out 0))))
+                       (libgit-graph-layout-add layout (list c4 c3))))
+        (should (equal (list c1 c2) (libgit-graph-layout-lanes layout)))
+        (should (equal (vector `(,c2 1 ((pass 0 0) (merge-in 1) (fork-out 1)))
+                               `(,c1 0 ((merge-in 0) (merge-in 1))))
+                       (libgit-graph-layout-add layout (list c2 c1))))
+        (should-not (libgit-graph-layout-lanes layout))
+        (should-error (libgit-graph-layout-next layout 1))))))
+
+(ert-deftest graph-layout-revwalk ()
+  (let (c1 c2 c3)
+    (with-temp-dir path
+      (init)
+      (commit-change "a" "1")
+      (setq c1 (rev-parse))
+      (commit-change "a" "2")
+      (setq c2 (rev-parse))
+      (commit-change "a" "3")
+      (setq c3 (rev-parse))
+      (let* ((repo (libgit-repository-open path))
+             (walk (libgit-revwalk-new repo))
+             (layout (progn (libgit-revwalk-push-head walk)
+                            (libgit-graph-layout-new walk))))
+        (should (equal (vector `(,c3 0 ((fork-out 0)))
+                               `(,c2 0 ((merge-in 0) (fork-out 0))))
+                       (libgit-graph-layout-next layout 2)))
+        (should (equal (vector `(,c1 0 ((merge-in 0))))
+                       (libgit-graph-layout-next layout 10)))
+        (should (equal [] (libgit-graph-layout-next layout 10)))))))
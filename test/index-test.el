@@ -27,6 +27,36 @@
         (should-not (string= (libgit-index-entry-id i2)
                              (caddr (libgit-tree-entry-byname tree "file2"))))))))
 
+(ert-deftest index-entries ()
+  (with-temp-dir path
+    (init)
+    (write "a" "top")
+    (write "dir/b" "nested content")
+    (write "dir/sub/c" "deeper")
+    (write "dirx/d" "not in dir")
+    (add "a" "dir/b" "dir/sub/c" "dirx/d")
+    (run "git" "update-index" "--skip-worktree" "a")
+    (let* ((repo (libgit-repository-open path))
+           (index (libgit-repository-index repo))
+           (entries (libgit-index-entries index)))
+      (should (equal '("a" "dir/b" "dir/sub/c" "dirx/d")
+                     (mapcar (lambda (e) (aref e 0)) entries)))
+      (let ((a (aref entries 0))
+            (b (aref entries 1)))
+        (should (string= (rev-parse ":a") (aref a 1)))
+        (should (eq 'blob (aref a 2)))
+        (should-not (aref a 3))
+        (should (equal '(skip-worktree) (aref a 4)))
+        (should-not (aref b 4))
+        (should (= 14 (aref b 5)))
+        (should (integerp (car (aref b 6)))))
+      (should (equal '("dir/b" "dir/sub/c")
+                     (mapcar (lambda (e) (aref e 0)) (libgit-index-entries index "dir"))))
+      (should (equal '("dir/sub/c")
+                     (mapcar (lambda (e) (aref e 0)) (libgit-index-entries index "dir/sub/"))))
+      (should (equal [] (libgit-index-entries index "nope")))
+      (should (= 4 (length (libgit-index-entries index "")))))))
+
 (ert-deftest index-conflicts ()
   (with-temp-dir path
     (init)
@@ -89,6 +119,52 @@
       (libgit-index-write index)
       (should-not (string-match-p "new file" (run "git" "status"))))))
 
+(ert-deftest index-add-paths ()
+  (with-temp-dir path
+    (init)
+    (write "a" "abcdef")
+    (write "dir/b" "ghijkl")
+    (write "c" "mnopqr")
+    (let* ((repo (libgit-repository-open path))
+           (index (libgit-repository-index repo))
+           (ids (libgit-index-add-paths index '("dir/b" "a") t)))
+      (should (equal (vector (run-nnl "git" "hash-object" "dir/b")
+                             (run-nnl "git" "hash-object" "a"))
+                     ids))
+      (should (= 0 (libgit-index-entrycount index)))
+      (should-error (libgit-object-lookup repo (aref ids 0)) :type 'giterr-odb)
+
+      (should (equal ids (libgit-index-add-paths index '("dir/b" "a"))))
+      (should (= 2 (libgit-index-entrycount index)))
+      (should (libgit-blob-p (libgit-object-lookup repo (aref ids 0))))
+      (let ((status (run "git" "status")))
+        (should (string-match-p "new file:\\s-+a$" status))
+        (should (string-match-p "new file:\\s-+dir/b$" status))
+        (should-not (string-match-p "new file:\\s-+c$" status)))
+      (should (string= "" (run "git" "diff")))
+
+      (should-error (libgit-index-add-paths index '("c" "nope")) :type 'giterr-index)
+      (should-error (libgit-index-add-paths index '("dir")) :type 'giterr-index)
+      (should (= 2 (libgit-index-entrycount index))))))
+
+(ert-deftest index-add-paths-stat ()
+  (with-temp-dir path
+    (init)
+    (run "git" "config" "core.filemode" "false")
+    (write "a" "abcdef")
+    (set-file-modes "a" #o755)
+    (let* ((repo (libgit-repository-open path))
+           (index (libgit-repository-index repo)))
+      (libgit-index-add-paths index '("a"))
+      (let ((entry (aref (libgit-index-entries index) 0))
+            (debug (run "git" "ls-files" "--debug" "a")))
+        ;; New files are not executable when the file mode is distrusted
+        (should (eq 'blob (aref entry 2)))
+        (should (string-match "mtime: \\([0-9]+\\):\\([0-9]+\\)" debug))
+        (should (equal (cons (string-to-number (match-string 1 debug))
+                             (string-to-number (match-string 2 debug)))
+                       (aref entry 6)))))))
+
 (ert-deftest index-add-all ()
   (with-temp-dir path
     (init)
@@ -198,6 +274,44 @@
       (libgit-index-read index)
       (should (= 2 (libgit-index-entrycount index))))))
 
+(ert-deftest index-new ()
+  (with-temp-dir path
+    (init)
+    (commit-change "a" "abcdef")
+    (commit-change "subdir/b" "ghijkl")
+    (let* ((repo (libgit-repository-open path))
+           (head (libgit-commit-tree (libgit-revparse-single repo "HEAD")))
+           (index (libgit-index-new repo head))
+           (index-file (expand-file-name ".git/index" path))
+           (mtime (file-attribute-modification-time (file-attributes index-file))))
+      (should-not (libgit-index-path index))
+      (should (= 2 (libgit-index-entrycount index)))
+      (should (string= (libgit-tree-id head) (libgit-index-write-tree index)))
+
+      (libgit-index-add-frombuffer index "new" "new content\n")
+      (libgit-index-add-frombuffer index "run" "#!/bin/sh\n" 'blob-executable)
+      (libgit-index-remove index "subdir/b")
+      (should (equal '("a" "new" "run")
+                     (mapcar #'libgit-index-entry-path
+                             (mapcar (lambda (i) (libgit-index-get-byindex index i))
+                                     '(0 1 2)))))
+
+      (let* ((tree (libgit-tree-lookup repo (libgit-index-write-tree index)))
+             (diff (libgit-diff-tree-to-index repo head index)))
+        (should (string= "new content\n"
+                         (libgit-blob-rawcontent (libgit-revparse-single
+                                                  repo (concat (libgit-tree-id tree) ":new")))))
+        (should (eq 'blob-executable (car (libgit-tree-entry-bypath tree "run"))))
+        (should (= 3 (libgit-diff-num-deltas diff)))
+        (should (= 2 (libgit-diff-num-deltas diff 'added)))
+        (should (= 1 (libgit-diff-num-deltas diff 'deleted))))
+
+      (libgit-index-read-tree index head)
+      (should (= 2 (libgit-index-entrycount index)))
+      (should-error (libgit-index-write index))
+      (should (equal mtime (file-attribute-modification-time (file-attributes index-file))))
+      (should (string= "" (run "git" "status" "--porcelain"))))))
+
 (ert-deftest index-write-tree ()
   (with-temp-dir path
     (init)
@@ -216,3 +330,70 @@
       (should (libgit-tree-entry-bypath tree "b"))
       (should (libgit-tree-entry-bypath tree "subdir/c"))
       (should-error (libgit-tree-entry-bypath tree "notfound") :type 'giterr-tree))))
+
+(ert-deftest index-stage-lines ()
+  (with-temp-dir path
+    (init)
+    (commit-change "file" "a\nb\nc\nd\ne\n")
+    (write "file" "a\nB\nc\nd\nE\nf\n")
+    (let* ((repo (libgit-repository-open path))
+           (index (libgit-repository-index repo))
+           (id (libgit-index-stage-lines index "file" '((?- 2 2) (?+ 2 2) (?+ 6 6)))))
+      (should (string= id (libgit-index-entry-id (libgit-index-get-bypath index "file"))))
+      (libgit-index-write index)
+      (should (string= "a\nB\nc\nd\ne\nf\n" (run "git" "show" ":file")))
+      (should (string= "a\nB\nc\nd\nE\nf\n" (read-file "file"))))))
+
+(ert-deftest index-stage-lines-content ()
+  (with-temp-dir path
+    (init)
+    (commit-change "file" "a\nb\nc\n")
+    (let* ((repo (libgit-repository-open path))
+           (index (libgit-repository-index repo)))
+      ;; Only the deletion is staged, the addition is left out
+      (libgit-index-stage-lines index "file" '((?- 3 3)) "a\nb\nx\n")
+      (libgit-index-write index)
+      (should (string= "a\nb\n" (run "git" "show" ":file"))))))
+
+(ert-deftest index-stage-lines-unselected-deletions ()
+  ;; Unselected deletions stay in place, before any staged additions
+  (dolist (case '(("a\nb\n" "a\nB\n" ((?+ 2 2)) "a\nb\nB\n")
+                  ("a\nb\nc\nd\n" "a\nX\nY\nd\n" ((?+ 2 3)) "a\nb\nc\nX\nY\nd\n")
+                  ("a\nb\nc\nd\n" "a\nX\nY\nd\n" ((?- 3 3) (?+ 2 2)) "a\nb\nX\nd\n")))
+    (with-temp-dir path
+      (init)
+      (commit-change "file" (nth 0 case))
+      (let* ((repo (libgit-repository-open path))
+             (index (libgit-repository-index repo)))
+        (libgit-index-stage-lines index "file" (nth 2 case) (nth 1 case))
+        (libgit-index-write index)
+        (should (string= (nth 3 case) (run "git" "show" ":file")))))))
+
+(ert-deftest index-stage-lines-stat ()
+  (with-temp-dir path
+    (init)
+    (commit-change "file" "a\nb\n")
+    (write "file" "a\nB\n")
+    (let* ((repo (libgit-repository-open path))
+           (index (libgit-repository-index repo)))
+      (libgit-index-stage-lines index "file" '((?- 2 2) (?+ 2 2)))
+      ;; The stat data is cleared, like with `git update-index --cacheinfo'
+      (let ((entry (aref (libgit-index-entries index) 0)))
+        (should (= 0 (aref entry 5)))
+        (should (equal '(0 . 0) (aref entry 6)))))))
+
+(ert-deftest index-unstage-lines ()
+  (with-temp-dir path
+    (init)
+    (commit-change "file" "a\nb\nc\n")
+    (write "file" "a\nX\nc\nd\n")
+    (add "file")
+    (let* ((repo (libgit-repository-open path))
+           (index (libgit-repository-index repo)))
+      (libgit-index-unstage-lines index "file" '((?+ 4 4)))
+      (libgit-index-write index)
+      (should (string= "a\nX\nc\n" (run "git" "show" ":file")))
+      (libgit-index-unstage-lines index "file" '((?- 2 2) (?+ 2 2)))
+      (libgit-index-write index)
+      (should (string= "a\nb\nc\n" (run "git" "show" ":file")))
+      (should (string= "a\nX\nc\nd\n" (read-file "file"))))))
@@ -0,0 +1,123 @@
+(ert-deftest log-columns ()
+  (with-temp-dir path
+    (init)
+    (commit-change "a" "abc" "first")
+    (commit-change "b" "abc" "second\n\nbody")
+    (let* ((repo (libgit-repository-open path))
+           (log (libgit-log repo '(oid parents summary author-name author-email tree))))
+      (should (= 2 (length log)))
+      (should (equal (aref log 0)
+                     (vector (rev-parse) (list (rev-parse "HEAD~")) "second"
+                             "A U Thor" "author@example.com" (rev-parse "HEAD^{tree}"))))
+      (should (equal (aref log 1)
+                     (vector (rev-parse "HEAD~") nil "first"
+                             "A U Thor" "author@example.com" (rev-parse "HEAD~^{tree}")))))))
+
+(ert-deftest log-times-and-abbrev ()
+  (with-temp-dir path
+    (init)
+    (commit-change "a" "abc")
+    (let* ((repo (libgit-repository-open path))
+           (record (aref (libgit-log repo '(abbrev author-time committer-time)) 0)))
+      (should (string-prefix-p (aref record 0) (rev-parse)))
+      (should (= (aref record 1)
+                 (string-to-number (run-nnl "git" "log" "-1" "--format=%at"))))
+      (should (= (aref record 2)
+                 (string-to-number (run-nnl "git" "log" "-1" "--format=%ct")))))))
+
+(ert-deftest log-paging ()
+  (with-temp-dir path
+    (init)
+    (commit-change "a" "abc")
+    (commit-change "b" "abc")
+    (commit-change "c" "abc")
+    (commit-change "d" "abc")
+    (let ((repo (libgit-repository-open path)))
+      (should (equal (vector (vector (rev-parse "HEAD~1")) (vector (rev-parse "HEAD~2")))
+                     (libgit-log repo '(oid) 1 2)))
+      (should (equal (vector (vector (rev-parse "HEAD~3")))
+                     (libgit-log repo '(oid) 3 10)))
+      (should (equal [] (libgit-log repo '(oid) 10)))
+      (should (equal (vector (vector (rev-parse "HEAD~1")))
+                     (libgit-log repo '(oid) nil nil "HEAD~2..HEAD~1")))
+      (should-error (libgit-log repo '(bogus))))))
+
+(ert-deftest log-revwalk ()
+  (with-temp-dir path
+    (init)
+    (commit-change "a" "abc")
+    (commit-change "b" "abc")
+    (commit-change "c" "abc")
+    (let* ((repo (libgit-repository-open path))
+           (walk (libgit-revwalk-new repo)))
+      (libgit-revwalk-push-head walk)
+      (should (equal (vector (vector (rev-parse "HEAD")))
+                     (libgit-log walk '(oid) nil 1)))
+      ;; The walker is not reset between calls
+      (should (equal (vector (vector (rev-parse "HEAD~1")) (vector (rev-parse "HEAD~2")))
+                     (libgit-log walk '(oid)))))))
+
+(ert-deftest log-path ()
+  (let (c1 c3 c4 c5)
+    (with-temp-dir path
+      (init)
+      (commit-change "a" "1")
+      (setq c1 (rev-parse))
+      (commit-change "b" "1")
+      (commit-change "a" "2")
+      (setq c3 (rev-parse))
+      (commit-change "dir/x" "1")
+      (setq c4 (rev-parse))
+      (commit-change "dir/y" "1")
+      (setq c5 (rev-parse))
+      (let ((repo (libgit-repository-open path)))
+        (should (equal (vector c3 c1) (libgit-log-path repo '("a"))))
+        (should (equal (vector c5 c4) (libgit-log-path repo '("dir"))))
+        (should (equal (vector c4) (libgit-log-path repo '("dir/x"))))
+        (should (equal (vector c4 c3 c1) (libgit-log-path repo '("a" "dir/x/"))))
+        (should (equal [] (libgit-log-path repo '("nonexistent"))))
+        (should (equal (vector c3) (libgit-log-path repo '("a") 0 1)))
+        (should (equal (vector c1) (libgit-log-path repo '("a") 1)))
+        (should (equal (vector c3) (libgit-log-path repo '("a") nil nil "HEAD~3..HEAD")))
+        ;; Paging through a walker
+        (let ((walk (libgit-revwalk-new repo)))
+          (libgit-revwalk-sorting walk '(topological time))
+          (libgit-revwalk-push-head walk)
+          (should (equal (vector c5) (libgit-log-path walk '("dir") 0 1)))
+          (should (equal (vector c4) (libgit-log-path walk '("dir") 0 1)))
+          (should (equal [] (libgit-log-path walk '("dir") 0 1)))
+          (libgit-revwalk-push-head walk)
+          (should (equal (vector c3) (libgit-log-path walk '("a") 0 1)))
+          (should (equal (vector c1) (libgit-log-path walk '("a"))))
+          (should (equal [] (libgit-log-path walk '("a")))))))))
+
+(ert-deftest log-path-merge ()
+  (with-temp-dir path
+    (init)
+    (commit-change "a" "1")
+    (create-branch "branch")
+    (commit-change "b" "1")
+    (checkout "master")
+    (commit-change "a" "2")
+    (merge "branch")
+    (let ((repo (libgit-repository-open path)))
+      (dolist (file '("a" "b"))
+        (should (equal (vconcat (split-string (run-nnl "git" "log" "--format=%H" "--" file)))
+                       (libgit-log-path repo (list file))))))))
+
+(ert-deftest log-path-follow ()
+  (let (c1 c2 c3)
+    (with-temp-dir path
+      (init)
+      (commit-change "a" "line 1\nline 2\nline 3\n")
+      (setq c1 (rev-parse))
+      (run "git" "mv" "a" "b")
+      (commit "rename")
+      (setq c2 (rev-parse))
+      (commit-change "b" "line 1\nline 2\nline 3\nline 4\n")
+      (setq c3 (rev-parse))
+      (let ((repo (libgit-repository-open path)))
+        (should (equal (vector c3 c2) (libgit-log-path repo '("b"))))
+        (should (equal (vector (cons c3 "b") (cons c2 "b") (cons c1 "a"))
+                       (libgit-log-path repo '("b") nil nil nil t)))
+        (should-error (libgit-log-path repo '("a" "b") nil nil nil t))))))
@@ -0,0 +1,75 @@
+(ert-deftest odb-read-many ()
+  (with-temp-dir path
+    (init)
+    (commit-change "a" "alpha\n")
+    (commit-change "b" "beta beta\n")
+    (let* ((repo (libgit-repository-open path))
+           (a (libgit-object-id (libgit-revparse-single repo "HEAD:a")))
+           (b (libgit-object-id (libgit-revparse-single repo "HEAD:b")))
+           (tree (libgit-object-id (libgit-revparse-single repo "HEAD^{tree}"))))
+      (should (equal [] (libgit-odb-read-many repo nil)))
+      (should (equal ["alpha\n" "beta beta\n" "alpha\n"]
+                     (libgit-odb-read-many repo (list a b a))))
+      (let ((result (libgit-odb-read-many repo (list tree b) nil t)))
+        (should (eq 'tree (car (aref result 0))))
+        (should (equal '(blob 10 "beta beta\n") (aref result 1))))
+      (should-error (libgit-odb-read-many repo (list a "0123456789abcdef0123456789abcdef01234567"))
+                    :type 'giterr-odb))))
+
+(ert-deftest odb-read-many-max-bytes ()
+  (with-temp-dir path
+    (init)
+    (commit-change "a" "alpha\n")
+    (commit-change "b" "beta beta\n")
+    (let* ((repo (libgit-repository-open path))
+           (a (libgit-object-id (libgit-revparse-single repo "HEAD:a")))
+           (b (libgit-object-id (libgit-revparse-single repo "HEAD:b"))))
+      (should (equal ["alpha\n" nil nil]
+                     (libgit-odb-read-many repo (list a b a) 10)))
+      (should (equal ["alpha\n" "beta beta\n" nil]
+                     (libgit-odb-read-many repo (list a b a) 16)))
+      (should (equal [(blob 6 nil)] (libgit-odb-read-many repo (list a) 0 t))))))
+
+(ert-deftest odb-headers ()
+  (with-temp-dir path
+    (init)
+    (commit-change "a" "alpha\n")
+    (let* ((repo (libgit-repository-open path))
+           (a (libgit-object-id (libgit-revparse-single repo "HEAD:a")))
+           (commit (libgit-object-id (libgit-revparse-single repo "HEAD")))
+           (missing "0123456789abcdef0123456789abcdef01234567"))
+      (should (equal '(blob . 6) (libgit-odb-read-header repo a)))
+      (should (eq 'commit (car (libgit-odb-read-header repo commit))))
+      (should (equal [(blob . 6) nil] (libgit-odb-headers repo (list a missing) t)))
+      (should-error (libgit-odb-headers repo (list a missing)) :type 'giterr-odb)
+      (should-error (libgit-odb-read-header repo missing) :type 'giterr-odb))))
+
+(ert-deftest oid-resolve-many ()
+  (with-temp-dir path
+    (init)
+    (commit-change "a" "alpha\n")
+    (let* ((repo (libgit-repository-open path))
+           (a (libgit-object-id (libgit-revparse-single repo "HEAD:a")))
+           (commit (libgit-object-id (libgit-revparse-single repo "HEAD")))
+           (prefixes (list (substring a 0 7) commit (substring commit 0 10)
+                           "zzzzzzz" "abc" "0000000000")))
+      (dotimes (_ 2)
+        (should (equal (vector (cons a 'blob) (cons commit 'commit) (cons commit 'commit)
+                               nil nil nil)
+                       (libgit-oid-resolve-many repo prefixes)))))))
+
+(ert-deftest oid-abbrev-many ()
+  (with-temp-dir path
+    (init)
+    (commit-change "a" "alpha\n")
+    (let* ((repo (libgit-repository-open path))
+           (a (libgit-object-id (libgit-revparse-single repo "HEAD:a")))
+           (missing "0123456789abcdef0123456789abcdef01234567"))
+      (should (equal (vector (substring a 0 7) nil)
+                     (libgit-oid-abbrev-many repo (list a missing))))
+      (should (equal (vector (substring a 0 4))
+                     (libgit-oid-abbrev-many repo (list a) 4)))
+      (should (equal (vector (substring a 0 7))
+                     (libgit-oid-abbrev-many repo (list a))))
+      (should (equal (vector (substring a 0 12))
+                     (libgit-oid-abbrev-many repo (list a) 12))))))
@@ -0,0 +1,70 @@
+(ert-deftest pickaxe-string ()
+  (let (c1 c3)
+    (with-temp-dir path
+      (init)
+      (commit-change "a" "foo\n")
+      (setq c1 (rev-parse))
+      (commit-change "b" "bar\n")
+      (commit-change "a" "foo\nfoo\n")
+      (setq c3 (rev-parse))
+      (commit-change "a" "foo\nfoo\nbaz\n")
+      (let* ((repo (libgit-repository-open path))
+             (walk (libgit-revwalk-new repo)))
+        (libgit-revwalk-push-head walk)
+        (should (equal (vector (list c3 "a") (list c1 "a"))
+                       (libgit-pickaxe walk "foo")))
+        ;; The walker is exhausted
+        (should (equal [] (libgit-pickaxe walk "foo")))
+        (libgit-revwalk-push-head walk)
+        (should (equal (mapcar #'car (libgit-pickaxe walk "foo"))
+                       (split-string (run-nnl "git" "log" "--format=%H" "-Sfoo"))))
+        (libgit-revwalk-push-head walk)
+        (should (equal [] (libgit-pickaxe walk "qux")))
+        (libgit-revwalk-push-head walk)
+        (should-error (libgit-pickaxe walk ""))))))
+
+(ert-deftest pickaxe-regexp ()
+  (let (c1 c3 c4)
+    (with-temp-dir path
+      (init)
+      (commit-change "a" "foo\n")
+      (setq c1 (rev-parse))
+      (commit-change "b" "bar\n")
+      (commit-change "a" "foo\nfoo\n")
+      (setq c3 (rev-parse))
+      (commit-change "a" "foo\nfoo\nbaz\n")
+      (setq c4 (rev-parse))
+      (let* ((repo (libgit-repository-open path))
+             (walk (libgit-revwalk-new repo)))
+        (libgit-revwalk-push-head walk)
+        (should (equal (vector (list c4 "a")) (libgit-pickaxe walk "ba[z]" t)))
+        (libgit-revwalk-push-head walk)
+        (should (equal (vector (list c3 "a") (list c1 "a")) (libgit-pickaxe walk "^fo+$" t)))
+        (libgit-revwalk-push-head walk)
+        (should-error (libgit-pickaxe walk "(" t))))))
+
+(ert-deftest pickaxe-limit-and-callback ()
+  (let (c1 c2 c3)
+    (with-temp-dir path
+      (init)
+      (commit-change "a" "foo\n")
+      (setq c1 (rev-parse))
+      (commit-change "b" "foo\n")
+      (setq c2 (rev-parse))
+      (commit-change "c" "foo\n")
+      (setq c3 (rev-parse))
+      (let* ((repo (libgit-repository-open path))
+             (walk (libgit-revwalk-new repo))
+             seen)
+        (libgit-revwalk-push-head walk)
+        ;; The whole batch is returned, even past the limit
+        (should (equal (vector (list c3 "c") (list c2 "b") (list c1 "a"))
+                       (libgit-pickaxe walk "foo" nil 1)))
+        (should (equal [] (libgit-pickaxe walk "foo" nil 1)))
+        (libgit-revwalk-push-head walk)
+        (should (equal (vector (list c3 "c") (list c2 "b"))
+                       (libgit-pickaxe walk "foo" nil nil
+                                       (lambda (match)
+                                         (push (car match) seen)
+                                         (when (equal (car match) c2) 'abort)))))
+        (should (equal (list c2 c3) seen))))))
@@ -206,3 +206,48 @@
                        "refs/heads/zamg"
                        "refs/heads/zemg"
                        "refs/heads/zomg"))))))
+
+(ert-deftest reference-snapshot ()
+  (with-temp-dir path
+    (init)
+    (commit-change "a" "abcdef")
+    (let ((first (rev-parse)))
+      (commit-change "a" "ghijkl")
+      (run "git" "remote" "add" "origin" "/nonexistent")
+      (run "git" "update-ref" "refs/remotes/origin/master" first)
+      (run "git" "symbolic-ref" "refs/remotes/origin/HEAD" "refs/remotes/origin/master")
+      (run "git" "config" "branch.master.remote" "origin")
+      (run "git" "config" "branch.master.merge" "refs/heads/master")
+      (run "git" "branch" "topic" first)
+      (run "git" "config" "branch.topic.remote" ".")
+      (run "git" "config" "branch.topic.merge" "refs/heads/master")
+      (run "git" "tag" "-a" "v1" "-m" "tag" first)
+      (let* ((repo (libgit-repository-open path))
+             (snapshot (libgit-reference-snapshot repo nil '(ahead-behind committer-time)))
+             (get (lambda (name)
+                    (catch 'found
+                      (mapc (lambda (r) (when (string= name (aref r 0)) (throw 'found r)))
+                            snapshot)
+                      nil))))
+        (should (= 5 (length snapshot)))
+        (should (equal (vector "refs/heads/master" "master" 'branch (rev-parse) (rev-parse)
+                               "refs/remotes/origin/master" '(1 . 0)
+                               (string-to-number (run-nnl "git" "log" "-1" "--format=%ct")))
+                       (funcall get "refs/heads/master")))
+        (let ((topic (funcall get "refs/heads/topic")))
+          (should (string= "refs/heads/master" (aref topic 5)))
+          (should (equal '(0 . 1) (aref topic 6))))
+        (let ((tag (funcall get "refs/tags/v1")))
+          (should (eq 'tag (aref tag 2)))
+          (should (string= (rev-parse "v1") (aref tag 3)))
+          (should (string= first (aref tag 4)))
+          (should-not (aref tag 5)))
+        (let ((head (funcall get "refs/remotes/origin/HEAD")))
+          (should (eq 'remote (aref head 2)))
+          (should (string= "refs/remotes/origin/master" (aref head 3)))
+          (should (string= first (aref head 4))))
+        (let ((plain (libgit-reference-snapshot repo "refs/heads/*")))
+          (should (= 2 (length plain)))
+          (should-not (aref (aref plain 0) 6))
+          (should-not (aref (aref plain 0) 7)))
+        (should-error (libgit-reference-snapshot repo nil '(nope)) :type 'wrong-value-argument)))))
@@ -87,3 +87,119 @@
                      (cl-loop for i below 3
                               collect (libgit-commit-id
                                        (libgit-commit-nth-gen-ancestor head i))))))))
+
+(ert-deftest revwalk-next ()
+  (with-temp-dir path
+    (init)
+    (commit-change "a" "abc")
+    (commit-change "b" "abc")
+    (commit-change "c" "abc")
+    (commit-change "d" "abc")
+    (commit-change "e" "abc")
+    (let* ((repo (libgit-repository-open path))
+           (walk (libgit-revwalk-new repo))
+           (ids (cl-loop for i below 5 collect (rev-parse (format "HEAD~%d" i)))))
+      (libgit-revwalk-push-head walk)
+      (should (string= (nth 0 ids) (libgit-revwalk-next walk)))
+      (should (equal (vector (nth 1 ids) (nth 2 ids)) (libgit-revwalk-next-n walk 2)))
+      (should (equal (vector (nth 3 ids) (nth 4 ids)) (libgit-revwalk-next-n walk 10)))
+      (should (equal [] (libgit-revwalk-next-n walk 10)))
+      (should-not (libgit-revwalk-next walk))
+      (libgit-revwalk-reset walk)
+      (libgit-revwalk-push-head walk)
+      (should (equal (vconcat ids) (libgit-revwalk-next-n walk 5))))))
+
+(ert-deftest revwalk-filter ()
+  (let (c1 c2 c3 m)
+    (with-temp-dir path
+      (init)
+      (let ((process-environment (cons "GIT_COMMITTER_DATE=1000000000 +0000" process-environment)))
+        (commit-change "a" "abc")
+        (setq c1 (rev-parse)))
+      (create-branch "side")
+      (let ((process-environment (cons "GIT_COMMITTER_DATE=1000000100 +0000" process-environment)))
+        (run "git" "-c" "user.name=Some One" "-c" "user.email=one@example.org"
+             "commit" "--allow-empty" "-m" "side")
+        (setq c2 (rev-parse)))
+      (checkout "-")
+      (let ((process-environment (cons "GIT_COMMITTER_DATE=1000000200 +0000" process-environment)))
+        (commit-change "b" "abc")
+        (setq c3 (rev-parse)))
+      (let ((process-environment (cons "GIT_COMMITTER_DATE=1000000300 +0000" process-environment)))
+        (merge "side")
+        (setq m (rev-parse)))
+      (let* ((repo (libgit-repository-open path))
+             (walk (libgit-revwalk-new repo))
+             (walk-with
+              (lambda (filter)
+                (let (seen)
+                  (libgit-revwalk-sorting walk '(time))
+                  (libgit-revwalk-push-head walk)
+                  (libgit-revwalk-foreach walk (lambda (id) (push id seen)) nil filter)
+                  (nreverse seen)))))
+        (should (equal (list m c3 c2 c1) (funcall walk-with nil)))
+        (should (equal (list m c3) (funcall walk-with '((max-count . 2)))))
+        (should (equal (list c3 c2 c1) (funcall walk-with '((max-parents . 1)))))
+        (should (equal (list m) (funcall walk-with '((min-parents . 2)))))
+        (should (equal (list c3 c2) (funcall walk-with '((since . 1000000100) (until . 1000000200)))))
+        (should (equal (list c2) (funcall walk-with '((author . "Some One <one@")))))
+        (should (equal (list m c3 c1) (funcall walk-with '((committer . "Thor")))))
+        (should (equal (list c2) (funcall walk-with '((author . "^Some .* <one@example\\.org>$")))))
+        (should-not (funcall walk-with '((author . "some one"))))
+        (should (equal (list c2) (funcall walk-with '((author . "some one") (ignore-case . t)))))
+        (should-error (funcall walk-with '((author . "\\("))))
+        (should (equal (list c3 c1) (funcall walk-with '((max-parents . 1) (committer . "Thor")))))
+        (should-error (funcall walk-with '((bogus . 1))))
+        (libgit-revwalk-reset walk)
+        (libgit-revwalk-push-head walk)
+        (should (equal (vector c3 c2) (libgit-revwalk-next-n walk 10 '((max-parents . 1) (max-count . 2)))))
+        (should (equal (vector c1) (libgit-revwalk-next-n walk 10)))
+        (libgit-revwalk-reset walk)
+        (libgit-revwalk-push-head walk)
+        (should (equal (vector m) (libgit-revwalk-next-n walk 1 '((since . 1000000100)))))
+        (should (equal (vector c3) (libgit-revwalk-next-n walk 1 '((since . 1000000100)))))
+        (should (equal (vector c2) (libgit-revwalk-next-n walk 10 '((since . 1000000100)))))
+        (should (equal [] (libgit-revwalk-next-n walk 10 '((since . 1000000100)))))
+        (should (equal (list m c3 c1) (funcall walk-with '((first-parent . t)))))
+        (should (equal (list m c3 c2 c1) (funcall walk-with nil)))
+        (libgit-revwalk-push-head walk)
+        (should (equal (vector m c3) (libgit-revwalk-next-n walk 2 '((first-parent . t)))))
+        (should (equal (vector c1) (libgit-revwalk-next-n walk 10 '((first-parent . t)))))
+        (libgit-revwalk-push-head walk)
+        (should (equal (vector m c3 c2 c1) (libgit-revwalk-next-n walk 10)))
+        ;; Changing the filter starts the first-parent state afresh
+        (libgit-revwalk-push-head walk)
+        (should (equal (vector m) (libgit-revwalk-next-n walk 1 '((first-parent . t)))))
+        (should (equal (vector c3) (libgit-revwalk-next-n walk 1)))
+        (should (equal (vector c2 c1) (libgit-revwalk-next-n walk 10 '((first-parent . t)))))))))
+
+(ert-deftest revwalk-search ()
+  (let (c1 c2 c3)
+    (with-temp-dir path
+      (init)
+      (commit-change "a" "abc" "Fix the frobnicator")
+      (setq c1 (rev-parse))
+      (commit-change "b" "abc" "Add a widget\n\nThis fixes the widget.")
+      (setq c2 (rev-parse))
+      (run "git" "-c" "user.name=Some One" "-c" "user.email=one@example.org"
+           "commit" "--allow-empty" "-m" "Unrelated")
+      (setq c3 (rev-parse))
+      (let* ((repo (libgit-repository-open path))
+             (walk (libgit-revwalk-new repo)))
+        (libgit-revwalk-push-head walk)
+        (should (equal (vector c1) (libgit-revwalk-search walk "Fix")))
+        (libgit-revwalk-push-head walk)
+        (should (equal (vector c2 c1) (libgit-revwalk-search walk "fix" nil nil t)))
+        (libgit-revwalk-push-head walk)
+        (should (equal (vector c2) (libgit-revwalk-search walk "^This fix" nil t)))
+        (libgit-revwalk-push-head walk)
+        (should (equal (vector c3) (libgit-revwalk-search walk "example.org" '(author committer))))
+        (libgit-revwalk-push-head walk)
+        (should (equal (vector c2 c1) (libgit-revwalk-search walk "Thor" '(author))))
+        ;; Timestamps are not part of the match
+        (libgit-revwalk-push-head walk)
+        (should (equal [] (libgit-revwalk-search walk "+0" '(author committer))))
+        (libgit-revwalk-push-head walk)
+        (should-error (libgit-revwalk-search walk "x" '(bogus)))
+        (libgit-revwalk-push-head walk)
+        (should-error (libgit-revwalk-search walk "\\(" nil t))))))
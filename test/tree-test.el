@@ -76,3 +76,94 @@
                        ("" tree tree ,tree2-id "dir2")
                        ("" blob blob ,blob1-id "file1")
                        ("" blob blob ,blob2-id "file2")))))))
+
+(ert-deftest tree-list ()
+  (with-temp-dir path
+    (init)
+    (write "file1" "some content")
+    (write "dir1/file3" "wow such content")
+    (write "dir1/sub/file4" "unbelievable")
+    (write "dir2/file5" "vincemcmahon.gif")
+    (add "file1" "dir1/file3" "dir1/sub/file4" "dir2/file5")
+    (commit)
+    (let* ((repo (libgit-repository-open path))
+           (root (libgit-commit-tree (libgit-revparse-single repo "HEAD"))))
+      (should (equal '(["dir1" "dir2" "file1"] [tree tree blob] [tree tree blob])
+                     (butlast (libgit-tree-list root))))
+      (should (equal (vector (rev-parse "HEAD:dir1") (rev-parse "HEAD:dir2") (rev-parse "HEAD:file1"))
+                     (nth 3 (libgit-tree-list root))))
+      (should (equal ["dir1/file3" "dir1/sub/file4" "dir2/file5" "file1"]
+                     (car (libgit-tree-list root t))))
+      (should (equal '(["dir1/file3" "dir1/sub" "dir2/file5" "file1"] [blob tree blob blob])
+                     (cl-subseq (libgit-tree-list root t nil 1) 0 2)))
+      (should (equal ["dir1/file3" "dir1/sub/file4"]
+                     (car (libgit-tree-list root t '("dir1")))))
+      (should (equal ["dir1/sub/file4" "dir2/file5"]
+                     (car (libgit-tree-list root t '("dir1/sub/*" "*5")))))
+      (should (equal ["file1"]
+                     (car (libgit-tree-list root t (libgit-pathspec-new '("file*")))))))))
+
+(ert-deftest tree-entry-opaque ()
+  (with-temp-dir path
+    (init)
+    (write "file1" "some content")
+    (write "dir1/file3" "wow such content")
+    (add "file1" "dir1/file3")
+    (commit)
+    (let* ((repo (libgit-repository-open path))
+           (root (libgit-commit-tree (libgit-revparse-single repo "HEAD")))
+           (file1 (libgit-tree-entry-byname root "file1" t))
+           (dir1 (libgit-tree-entry-byindex root 0 t))
+           (file3 (libgit-tree-entry-bypath root "dir1/file3" t)))
+      (should (libgit-tree-entry-p file1))
+      (should-not (libgit-tree-entry-p (libgit-tree-entry-byname root "file1")))
+      (should (string= "file1" (libgit-tree-entry-name file1)))
+      (should (eq 'blob (libgit-tree-entry-filemode file1)))
+      (should (eq 'blob (libgit-tree-entry-type file1)))
+      (should (string= (rev-parse "HEAD:file1") (libgit-tree-entry-id file1)))
+      (should (eq 'tree (libgit-tree-entry-type dir1)))
+      (should (string= "file3" (libgit-tree-entry-name file3)))
+      (should (equal (libgit-tree-entry-id file1)
+                     (libgit-tree-entry-id (libgit-tree-entry-byid root (rev-parse "HEAD:file1") t))))
+      (should (< (libgit-tree-entry-cmp dir1 file1) 0))
+      (should (> (libgit-tree-entry-cmp file1 dir1) 0))
+      (should (= 0 (libgit-tree-entry-cmp file1 (libgit-tree-entry-byindex root 1 t))))
+      (should (libgit-tree-p (libgit-tree-entry-to-object repo dir1)))
+      (should (libgit-blob-p (libgit-tree-entry-to-object repo file3)))
+      ;; Entries keep their tree alive
+      (setq root nil)
+      (garbage-collect)
+      (should (string= "file1" (libgit-tree-entry-name file1)))
+      (let ((bld (libgit-treebuilder-new repo)))
+        (libgit-treebuilder-insert bld "x" (libgit-tree-entry-id file1) 'blob)
+        (let ((entry (libgit-treebuilder-get bld "x" t)))
+          (libgit-treebuilder-remove bld "x")
+          (should (string= "x" (libgit-tree-entry-name entry))))))))
+
+(ert-deftest tree-entries-bypath ()
+  (with-temp-dir path
+    (init)
+    (write "file1" "some content")
+    (write "dir1/file2" "more content")
+    (write "dir1/dir2/file3" "wow such content")
+    (write "dir3/file4" "even more content")
+    (add "file1" "dir1/file2" "dir1/dir2/file3" "dir3/file4")
+    (commit)
+    (let* ((repo (libgit-repository-open path))
+           (root (libgit-commit-tree (libgit-revparse-single repo "HEAD")))
+           (paths ["dir3/file4" "dir1/dir2/file3" "nope" "dir1/file2" "file1"
+                   "dir1/nope/file" "file1/nope" "dir1/" "file1/" "dir1/dir2/file3"])
+           (entries (libgit-tree-entries-bypath root paths)))
+      (should (= 10 (length entries)))
+      (dotimes (i 10)
+        (let ((path (aref paths i)))
+          (should (equal (aref entries i)
+                         (ignore-errors (libgit-tree-entry-bypath root path))))))
+      (should (aref entries 7))
+      (should-not (aref entries 8))
+      (should (equal entries (libgit-tree-entries-bypath root (append paths nil))))
+      (let ((opaque (libgit-tree-entries-bypath root '("dir1/dir2/file3" "nope") t)))
+        (should (libgit-tree-entry-p (aref opaque 0)))
+        (should (string= (rev-parse "HEAD:dir1/dir2/file3")
+                         (libgit-tree-entry-id (aref opaque 0))))
+        (should-not (aref opaque 1))))))